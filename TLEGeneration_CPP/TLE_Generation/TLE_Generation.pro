@@ -15,40 +15,89 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+        benchmark.cpp \
+        blockWriter.cpp \
         core/cEci.cpp \
+        core/cGmstGrid.cpp \
         core/cJulian.cpp \
+        core/cLookAngleTable.cpp \
+        core/cMappedFile.cpp \
         core/cSite.cpp \
         core/cTLE.cpp \
+        core/cTaskScheduler.cpp \
+        core/cTleCatalog.cpp \
         core/cVector.cpp \
         core/coord.cpp \
         core/globals.cpp \
         core/stdafx.cpp \
+        lookAngleManifest.cpp \
+        lookAngleMatrix.cpp \
+        lookAngleRowWriter.cpp \
+        lookAngleService.cpp \
         main.cpp \
+        orbit/cDenseEphemeris.cpp \
+        orbit/cLookAngleEngine.cpp \
         orbit/cNoradBase.cpp \
         orbit/cNoradSDP4.cpp \
         orbit/cNoradSGP4.cpp \
         orbit/cOrbit.cpp \
+        orbit/cOrbitCatalog.cpp \
+        orbit/cOrbitSnapshot.cpp \
+        orbit/cPassPredictor.cpp \
         orbit/cSatellite.cpp \
-        orbit/stdafx.cpp
+        orbit/cSgp4Kernel.cpp \
+        orbit/cSgp4Table.cpp \
+        orbit/cVisibilityScreen.cpp \
+        orbit/stdafx.cpp \
+        sampleClock.cpp \
+        sampleShards.cpp
+
+# SGP4 vector kernels, built with per-file instruction set flags and
+# selected at run time (see orbit/cSgp4Kernel.h).
+CONFIG += simd
+AVX2_SOURCES += orbit/cSgp4KernelAvx2.cpp
+AVX512F_SOURCES += orbit/cSgp4KernelAvx512.cpp
 
 HEADERS += \
+    benchmark.h \
+    blockWriter.h \
     core/cEci.h \
+    core/cGmstGrid.h \
     core/cJulian.h \
+    core/cLookAngleTable.h \
+    core/cMappedFile.h \
     core/cSite.h \
     core/cTLE.h \
+    core/cTaskScheduler.h \
+    core/cTleCatalog.h \
     core/cVector.h \
     core/coord.h \
     core/coreLib.h \
     core/exceptions.h \
     core/globals.h \
     core/stdafx.h \
+    lookAngleManifest.h \
+    lookAngleMatrix.h \
+    lookAngleRowWriter.h \
+    lookAngleService.h \
+    orbit/cDenseEphemeris.h \
+    orbit/cLookAngleEngine.h \
     orbit/cNoradBase.h \
     orbit/cNoradSDP4.h \
     orbit/cNoradSGP4.h \
     orbit/cOrbit.h \
+    orbit/cOrbitCatalog.h \
+    orbit/cOrbitSnapshot.h \
+    orbit/cPassPredictor.h \
     orbit/cSatellite.h \
+    orbit/cSgp4Kernel.h \
+    orbit/cSgp4KernelImpl.h \
+    orbit/cSgp4Table.h \
+    orbit/cVisibilityScreen.h \
     orbit/orbitLib.h \
-    orbit/stdafx.h
+    orbit/stdafx.h \
+    sampleClock.h \
+    sampleShards.h
 
 INCLUDEPATH += -I ./orbit -I ./core
 
@@ -0,0 +1,201 @@
+//
+// benchmark.cpp
+//
+// Propagation micro-benchmarks. Each benchmark propagates the configured
+// element set over BENCHMARK_SAMPLES consecutive 1 ms steps and reports
+// the average time per sample, for the scalar and the vector SGP4 paths.
+// The catalog benchmark instead propagates a cSgp4Table of
+// BENCHMARK_CATALOG_SIZE satellites, once per kernel.
+//
+#include "stdafx.h"
+
+#include <stdio.h>
+#include <QElapsedTimer>
+
+#include "coreLib.h"
+#include "orbitLib.h"
+
+#include "benchmark.h"
+
+static const uint32_t BENCHMARK_SAMPLES    = 1000000;
+static const uint32_t BENCHMARK_BATCH_SIZE = 4096;
+static const double   BENCHMARK_STEP_MIN   = 1.0 / 60000.0;  // 1 ms
+
+static const uint32_t BENCHMARK_CATALOG_SIZE   = 4096;
+static const uint32_t BENCHMARK_CATALOG_PASSES = 250;
+
+//////////////////////////////////////////////////////////////////////////////
+// One sample per call through cSatellite::PositionEci().
+static double BenchmarkPositionEci(const cSatellite& sat, double *pChecksum)
+{
+    QElapsedTimer timer;
+    double checksum = 0.0;
+
+    timer.start();
+
+    for(uint32_t ix = 0; ix < BENCHMARK_SAMPLES; ++ix){
+        cEciTime eci = sat.PositionEci(ix * BENCHMARK_STEP_MIN);
+        checksum += eci.Position().m_x;
+    }
+
+    double nsPerSample = double(timer.nsecsElapsed()) / BENCHMARK_SAMPLES;
+
+    *pChecksum = checksum;
+    return nsPerSample;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// BENCHMARK_BATCH_SIZE samples per call through cSatellite::PositionEciBatch().
+static double BenchmarkPositionEciBatch(const cSatellite& sat, double *pChecksum)
+{
+    vector<double> mpe(BENCHMARK_BATCH_SIZE);
+    vector<double> x (BENCHMARK_BATCH_SIZE), y (BENCHMARK_BATCH_SIZE), z (BENCHMARK_BATCH_SIZE);
+    vector<double> vx(BENCHMARK_BATCH_SIZE), vy(BENCHMARK_BATCH_SIZE), vz(BENCHMARK_BATCH_SIZE);
+    cEciArrays eci = { x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data() };
+
+    QElapsedTimer timer;
+    double checksum = 0.0;
+
+    timer.start();
+
+    for(uint32_t ix = 0; ix < BENCHMARK_SAMPLES; ix += BENCHMARK_BATCH_SIZE){
+        uint32_t count = min(BENCHMARK_BATCH_SIZE, BENCHMARK_SAMPLES - ix);
+
+        for(uint32_t jx = 0; jx < count; ++jx){
+            mpe[jx] = (ix + jx) * BENCHMARK_STEP_MIN;
+        }
+
+        sat.PositionEciBatch(mpe.data(), count, eci);
+
+        for(uint32_t jx = 0; jx < count; ++jx){
+            checksum += x[jx];
+        }
+    }
+
+    double nsPerSample = double(timer.nsecsElapsed()) / BENCHMARK_SAMPLES;
+
+    *pChecksum = checksum;
+    return nsPerSample;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// BENCHMARK_CATALOG_PASSES propagations of the whole table with its current
+// kernel. Returns the time per satellite; the last pass is left in x.
+static double BenchmarkCatalog(const cSgp4Table& table, const vector<double>& tsince,
+                               vector<double>& x)
+{
+    vector<double> y (table.Size()), z (table.Size());
+    vector<double> vx(table.Size()), vy(table.Size()), vz(table.Size());
+    vector<unsigned char> status(table.Size());
+    cEciArrays eci = { x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data() };
+
+    QElapsedTimer timer;
+
+    timer.start();
+
+    for(uint32_t ix = 0; ix < BENCHMARK_CATALOG_PASSES; ++ix){
+        table.PositionEciBatch(tsince.data(), eci, status.data());
+    }
+
+    return double(timer.nsecsElapsed()) / (double(BENCHMARK_CATALOG_PASSES) * table.Size());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The configured element set, BENCHMARK_CATALOG_SIZE times, each copy at a
+// different time, through every cSgp4Table kernel the CPU supports.
+static int RunCatalogBenchmark(const cSatellite& sat)
+{
+    static const char* const levelNames[] = { "scalar", "AVX2", "AVX-512" };
+
+    cSgp4Table table;
+    vector<double> tsince(BENCHMARK_CATALOG_SIZE);
+
+    for(uint32_t ix = 0; ix < BENCHMARK_CATALOG_SIZE; ++ix){
+        if(!table.Add(sat.Orbit())){
+            printf("  cSgp4Table          deep-space orbit, skipped\n");
+            return 0;
+        }
+        tsince[ix] = ix * 1.37;
+    }
+
+    vector<double> xScalar(BENCHMARK_CATALOG_SIZE), x(BENCHMARK_CATALOG_SIZE);
+    double nsScalar = 0.0;
+    int result = 0;
+
+    for(int level = SIMD_SCALAR; level <= SimdLevelSupported(); ++level){
+        table.SetSimdLevel(eSimdLevel(level));
+
+        double ns = BenchmarkCatalog(table, tsince, (level == SIMD_SCALAR) ? xScalar : x);
+        double maxDiff = 0.0;
+
+        if(level == SIMD_SCALAR){
+            nsScalar = ns;
+        }
+        else{
+            for(uint32_t ix = 0; ix < BENCHMARK_CATALOG_SIZE; ++ix){
+                maxDiff = max(maxDiff, fabs(x[ix] - xScalar[ix]));
+            }
+        }
+
+        printf("  cSgp4Table %-8s %8.1f ns/satellite  x%.2f  max |dx| %.1e km\n",
+               levelNames[level], ns, nsScalar / ns, maxDiff);
+
+        if(maxDiff > 1.0e-3){
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+int RunPropagationBenchmark(const std::string& tleName,
+                            const std::string& tleLine1,
+                            const std::string& tleLine2)
+{
+    string name  = tleName;
+    string line1 = tleLine1;
+    string line2 = tleLine2;
+
+    cTle       tle(name, line1, line2);
+    cSatellite sat(tle);
+
+    double checksumEci   = 0.0;
+    double checksumBatch = 0.0;
+    double checksumSimd  = 0.0;
+
+    printf("%s: %u samples, 1 ms step\n", sat.Name().c_str(), BENCHMARK_SAMPLES);
+
+    // The scalar batch must reproduce PositionEci() exactly; the vector
+    // kernels (SGP4 only) agree with it to well under a millimetre.
+    eSimdLevel simdLevel = SimdLevelSupported();
+
+    SetSimdLevelLimit(SIMD_SCALAR);
+
+    double nsEci   = BenchmarkPositionEci(sat, &checksumEci);
+    double nsBatch = BenchmarkPositionEciBatch(sat, &checksumBatch);
+
+    SetSimdLevelLimit(simdLevel);
+
+    double nsSimd  = BenchmarkPositionEciBatch(sat, &checksumSimd);
+
+    printf("  PositionEci        %8.1f ns/sample\n", nsEci);
+    printf("  PositionEciBatch   %8.1f ns/sample  (scalar)\n", nsBatch);
+    printf("  PositionEciBatch   %8.1f ns/sample  (%s)\n", nsSimd,
+           (simdLevel == SIMD_AVX512) ? "AVX-512" : (simdLevel == SIMD_AVX2) ? "AVX2" : "scalar");
+
+    if(checksumEci != checksumBatch){
+        printf("  checksum mismatch: %.10e %.10e\n", checksumEci, checksumBatch);
+        return 1;
+    }
+
+    if(fabs(checksumSimd - checksumBatch) > BENCHMARK_SAMPLES * 1.0e-6){
+        printf("  vector checksum mismatch: %.10e %.10e\n", checksumSimd, checksumBatch);
+        return 1;
+    }
+
+    printf("%s: %u satellites, %u passes\n", sat.Name().c_str(),
+           BENCHMARK_CATALOG_SIZE, BENCHMARK_CATALOG_PASSES);
+
+    return RunCatalogBenchmark(sat);
+}
@@ -0,0 +1,14 @@
+//
+// benchmark.h
+//
+// Propagation micro-benchmarks, run with "TLE_Generation --benchmark".
+//
+#pragma once
+
+#include <string>
+
+// Times the SGP4/SDP4 propagation of the given element set and prints
+// the average cost per sample. Returns the process exit code.
+int RunPropagationBenchmark(const std::string& tleName,
+                            const std::string& tleLine1,
+                            const std::string& tleLine2);
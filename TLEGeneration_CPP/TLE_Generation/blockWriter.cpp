@@ -0,0 +1,106 @@
+//
+// blockWriter.cpp
+//
+#include "stdafx.h"
+
+#include <chrono>
+#include <QIODevice>
+
+#include "blockWriter.h"
+
+const size_t BlockWriter::DEFAULT_BLOCK_SIZE;
+
+//////////////////////////////////////////////////////////////////////////////
+static int64_t MicrosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+BlockWriter::BlockWriter(QIODevice* device, size_t blockCount, size_t blockSize)
+    : m_pDevice(device), m_Blocks(blockCount < 2 ? 2 : blockCount),
+      m_fClosing(false), m_fOk(true), m_StallUs(0), m_WriteUs(0)
+{
+    for(size_t bx = 0; bx < m_Blocks.size(); ++bx){
+        m_Blocks[bx].m_Data.resize(blockSize);
+        m_Blocks[bx].m_Used = 0;
+        m_Free.push_back(&m_Blocks[bx]);
+    }
+    m_Thread = std::thread(&BlockWriter::Run, this);
+}
+
+BlockWriter::~BlockWriter()
+{
+    Close();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+BlockWriter::Block* BlockWriter::Acquire()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    if(m_Free.empty()){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        m_Returned.wait(lock, [this]{ return !m_Free.empty(); });
+        m_StallUs += MicrosecondsSince(start);
+    }
+
+    Block* block = m_Free.back();
+    m_Free.pop_back();
+    block->m_Used = 0;
+    return block;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void BlockWriter::Submit(Block* block)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Queue.push_back(block);
+    }
+    m_Queued.notify_one();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+bool BlockWriter::Close()
+{
+    if(m_Thread.joinable()){
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_fClosing = true;
+        }
+        m_Queued.notify_one();
+        m_Thread.join();
+    }
+    return m_fOk;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The writer thread: writes queued blocks until closed with an empty queue.
+void BlockWriter::Run()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    for(;;){
+        m_Queued.wait(lock, [this]{ return !m_Queue.empty() || m_fClosing; });
+        if(m_Queue.empty()){
+            break;
+        }
+
+        Block* block = m_Queue.front();
+        m_Queue.pop_front();
+        lock.unlock();
+
+        bool ok = true;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if(block->m_Used > 0){
+            ok = (m_pDevice->write(&block->m_Data[0], qint64(block->m_Used)) == qint64(block->m_Used));
+        }
+        int64_t us = MicrosecondsSince(start);
+
+        lock.lock();
+        m_fOk = m_fOk && ok;
+        m_WriteUs += us;
+        m_Free.push_back(block);
+        m_Returned.notify_one();
+    }
+}
@@ -0,0 +1,71 @@
+//
+// blockWriter.h
+//
+// Writes output blocks to a device on a thread of its own, so that the
+// samples of the next block are computed while the last one is written.
+//
+// The writer owns a fixed set of blocks. Producers Acquire() an empty
+// block, fill it and Submit() it; the writer thread writes submitted
+// blocks in submission order and hands them back. When every block is
+// queued, Acquire() waits for the writer, which bounds the memory in
+// flight and holds the producers back to the speed of the device.
+//
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class QIODevice;
+
+class BlockWriter {
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+    struct Block {
+        std::vector<char> m_Data;
+        size_t m_Used;
+    };
+
+    // "blockCount" blocks of "blockSize" bytes; at least two, so that one
+    // can be filled while the other is written.
+    BlockWriter(QIODevice* device, size_t blockCount,
+                size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~BlockWriter();
+
+    // An empty block; waits while all blocks are queued for writing.
+    Block* Acquire();
+
+    // Queues the first m_Used bytes of "block" for writing.
+    void Submit(Block* block);
+
+    // Writes out the queued blocks and stops the thread. Returns false if
+    // the device did not take all of them. The blocks must all have been
+    // submitted.
+    bool Close();
+
+    // Time the producers spent waiting in Acquire(), and the writer thread
+    // spent in device writes, in milliseconds.
+    int64_t StallMs() const { return m_StallUs / 1000; }
+    int64_t WriteMs() const { return m_WriteUs / 1000; }
+
+private:
+    void Run();
+
+    QIODevice* m_pDevice;
+    std::vector<Block> m_Blocks;
+    std::vector<Block*> m_Free;
+    std::deque<Block*> m_Queue;
+    std::mutex m_Mutex;
+    std::condition_variable m_Queued;     // writer: m_Queue not empty, or closing
+    std::condition_variable m_Returned;   // producers: m_Free not empty
+    std::thread m_Thread;
+    bool m_fClosing;
+    bool m_fOk;
+    int64_t m_StallUs;
+    int64_t m_WriteUs;
+};
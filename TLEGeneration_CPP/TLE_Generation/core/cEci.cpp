@@ -86,5 +86,78 @@ cEciTime::cEciTime(const cGeoTime &geo)
 {
 }
 
+//////////////////////////////////////////////////////////////////////
+// Class cGmstRotation
+//////////////////////////////////////////////////////////////////////
+
+cGmstRotation::cGmstRotation(const cJulian &date)
+{
+   double theta = date.ToGmst();
+
+   m_Sin = sin(theta);
+   m_Cos = cos(theta);
+}
+
+cGmstRotation::cGmstRotation(double radGmst)
+   : m_Sin(sin(radGmst)),
+     m_Cos(cos(radGmst))
+{
+}
+
+void cGmstRotation::Add(const cGmstRotation &rot)
+{
+   double s = m_Sin * rot.m_Cos + m_Cos * rot.m_Sin;
+   double c = m_Cos * rot.m_Cos - m_Sin * rot.m_Sin;
+
+   m_Sin = s;
+   m_Cos = c;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Class cEcef
+//////////////////////////////////////////////////////////////////////
+
+// Rotates the ECI coordinates about the z axis by the GMST angle, and
+// removes the earth's rotation from the velocity.
+cEcef::cEcef(const cEci &eci, const cGmstRotation &rot)
+{
+   const cVector &pos = eci.Position();
+   const cVector &vel = eci.Velocity();
+
+   m_Position.m_x =  rot.Cos() * pos.m_x + rot.Sin() * pos.m_y;
+   m_Position.m_y = -rot.Sin() * pos.m_x + rot.Cos() * pos.m_y;
+   m_Position.m_z =  pos.m_z;
+   m_Position.m_w =  pos.m_w;
+
+   double mfactor = TWOPI * (OMEGA_E / SEC_PER_DAY);
+
+   m_Velocity.m_x =  rot.Cos() * vel.m_x + rot.Sin() * vel.m_y + mfactor * m_Position.m_y;
+   m_Velocity.m_y = -rot.Sin() * vel.m_x + rot.Cos() * vel.m_y - mfactor * m_Position.m_x;
+   m_Velocity.m_z =  vel.m_z;
+}
+
+void cEcef::FromEciBatch(const cEciArrays &eci, const cGmstRotation *pRot,
+                         size_t count, const cEciArrays &ecef)
+{
+   double mfactor = TWOPI * (OMEGA_E / SEC_PER_DAY);
+
+   for (size_t i = 0; i < count; i++)
+   {
+      double s  = pRot[i].Sin();
+      double c  = pRot[i].Cos();
+      double x  =  c * eci.m_x[i]  + s * eci.m_y[i];
+      double y  = -s * eci.m_x[i]  + c * eci.m_y[i];
+      double vx =  c * eci.m_vx[i] + s * eci.m_vy[i] + mfactor * y;
+      double vy = -s * eci.m_vx[i] + c * eci.m_vy[i] - mfactor * x;
+
+      ecef.m_x [i] = x;
+      ecef.m_y [i] = y;
+      ecef.m_z [i] = eci.m_z[i];
+      ecef.m_vx[i] = vx;
+      ecef.m_vy[i] = vy;
+      ecef.m_vz[i] = eci.m_vz[i];
+   }
+}
+
 }
 }
\ No newline at end of file
@@ -59,5 +59,69 @@ protected:
    cJulian m_Date;
 };
 
+//////////////////////////////////////////////////////////////////////
+// struct cEciArrays
+// Caller-owned, structure-of-arrays ECI buffers used by the batch
+// propagation methods (and, holding Earth-fixed coordinates, by the
+// batch cEcef and cSite methods). Each member points to an array holding
+// at least as many elements as the batch being computed.
+//////////////////////////////////////////////////////////////////////
+struct cEciArrays
+{
+   double *m_x;    // position
+   double *m_y;
+   double *m_z;
+   double *m_vx;   // velocity
+   double *m_vy;
+   double *m_vz;
+};
+
+//////////////////////////////////////////////////////////////////////
+// class cGmstRotation
+// The rotation from the ECI frame to the Earth-fixed frame at one
+// instant: the sine and cosine of the Greenwich Mean Sidereal Time.
+// Evaluate it once per timestamp and share it among all objects and
+// sites at that time.
+//////////////////////////////////////////////////////////////////////
+class cGmstRotation
+{
+public:
+   explicit cGmstRotation(const cJulian &date);
+   explicit cGmstRotation(double radGmst);
+
+   double Sin() const { return m_Sin; }
+   double Cos() const { return m_Cos; }
+
+   // Adds the angle of "rot" to this one
+   void Add(const cGmstRotation &rot);
+
+protected:
+   double m_Sin;
+   double m_Cos;
+};
+
+//////////////////////////////////////////////////////////////////////
+// class cEcef
+// Position (km) and velocity (km/sec) in the Earth-fixed frame; the
+// velocity is relative to the rotating Earth.
+//////////////////////////////////////////////////////////////////////
+class cEcef
+{
+public:
+   cEcef(const cEci &eci, const cGmstRotation &rot);
+
+   // The same transformation for "count" samples; eci and ecef may be
+   // the same arrays.
+   static void FromEciBatch(const cEciArrays &eci, const cGmstRotation *pRot,
+                            size_t count, const cEciArrays &ecef);
+
+   const cVector& Position() const { return m_Position; }
+   const cVector& Velocity() const { return m_Velocity; }
+
+protected:
+   cVector  m_Position;
+   cVector  m_Velocity;
+};
+
 }
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+//
+// cGmstGrid.cpp
+//
+#include "stdafx.h"
+
+#include "cGmstGrid.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+//////////////////////////////////////////////////////////////////////////////
+// The earth turns through TWOPI * OMEGA_E radians per solar day (the GMST
+// polynomial in cJulian::ToGmst() is linear in UT at that rate).
+cGmstGrid::cGmstGrid(const cJulian &jdRef, double minFirst, double minStep,
+                     unsigned resync /* = DEFAULT_RESYNC */) :
+   m_jdRef(jdRef),
+   m_minFirst(minFirst),
+   m_minStep(minStep),
+   m_Resync(max(1u, resync)),
+   m_Step(TWOPI * OMEGA_E * (minStep / MIN_PER_DAY)),
+   m_Rot(0.0),
+   m_Index(0),
+   m_fValid(false),
+   m_Resyncs(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Date()
+cJulian cGmstGrid::Date(size_t i) const
+{
+   cJulian date = m_jdRef;
+
+   date.AddMin(m_minFirst + i * m_minStep);
+
+   return date;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// At()
+const cGmstRotation& cGmstGrid::At(size_t i)
+{
+   if (m_fValid && (i == m_Index + 1) && ((i % m_Resync) != 0))
+   {
+      m_Rot.Add(m_Step);
+   }
+   else if (!m_fValid || (i != m_Index))
+   {
+      m_Rot    = cGmstRotation(Date(i));
+      m_fValid = true;
+      m_Resyncs++;
+   }
+
+   m_Index = i;
+
+   return m_Rot;
+}
+}
+}
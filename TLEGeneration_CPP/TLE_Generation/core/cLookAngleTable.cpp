@@ -0,0 +1,311 @@
+//
+// cLookAngleTable.cpp
+//
+#include "stdafx.h"
+
+#include <stddef.h>
+
+#include "cLookAngleTable.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+static const char     TABLE_MAGIC[8]  = { 'L', 'O', 'O', 'K', 'A', 'N', 'G', '\0' };
+static const uint32_t TABLE_VERSION   = 1;
+static const uint32_t TABLE_BYTE_MARK = 0x01020304;
+
+static const size_t   TABLE_LEN_NAME  = 16;
+
+// Column value types
+static const uint32_t TABLE_TYPE_INT64  = 1;
+static const uint32_t TABLE_TYPE_DOUBLE = 2;
+
+const size_t cLookAngleTable::BLOCK_ROWS;
+const size_t cLookAngleTable::NOT_FOUND;
+
+//////////////////////////////////////////////////////////////////////////////
+// Column descriptor, as stored in the header
+struct cTableColumn
+{
+   char     m_Name[TABLE_LEN_NAME];   // NUL terminated
+   uint32_t m_Type;
+   uint32_t m_Size;                   // bytes per value
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// File header; the blocks follow it directly.
+struct cTableHeader
+{
+   char     m_Magic[8];
+   uint32_t m_Version;
+   uint32_t m_ByteMark;             // 0x01020304, read as little-endian
+   uint32_t m_HeaderSize;           // sizeof(cTableHeader)
+   uint32_t m_BlockRows;
+   uint32_t m_ColumnCount;
+   uint32_t m_Reserved;
+   uint64_t m_RowCount;
+
+   cLookAngleTableInfo m_Info;
+
+   cTableColumn m_Columns[cLookAngleTable::COL_COUNT];
+};
+
+static const char* const TABLE_COLUMN_NAMES[cLookAngleTable::COL_COUNT] =
+{
+   "time_ms", "azimuth_deg", "elevation_deg", "range_km", "range_rate_km_s"
+};
+
+//////////////////////////////////////////////////////////////////////////////
+static bool IsLittleEndian()
+{
+   uint32_t value = TABLE_BYTE_MARK;
+
+   return *(const unsigned char *)&value == 0x04;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// ColumnName()
+const char* cLookAngleTable::ColumnName(eColumn col)
+{
+   return TABLE_COLUMN_NAMES[col];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cLookAngleTable::cLookAngleTable() :
+   m_pBlocks(NULL),
+   m_Count(0)
+{
+   memset(&m_Info, 0, sizeof(m_Info));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Open()
+bool cLookAngleTable::Open(const string &path)
+{
+   Close();
+
+   if (!IsLittleEndian() || !m_File.Open(path) || (m_File.Size() < sizeof(cTableHeader)))
+   {
+      Close();
+      return false;
+   }
+
+   const cTableHeader *pHdr = (const cTableHeader *)m_File.Data();
+
+   bool fOk = (memcmp(pHdr->m_Magic, TABLE_MAGIC, sizeof(pHdr->m_Magic)) == 0) &&
+              (pHdr->m_Version     == TABLE_VERSION)        &&
+              (pHdr->m_ByteMark    == TABLE_BYTE_MARK)      &&
+              (pHdr->m_HeaderSize  == sizeof(cTableHeader)) &&
+              (pHdr->m_BlockRows   == BLOCK_ROWS)           &&
+              (pHdr->m_ColumnCount == COL_COUNT);
+
+   if (fOk)
+   {
+      uint64_t blocks = (pHdr->m_RowCount + BLOCK_ROWS - 1) / BLOCK_ROWS;
+
+      fOk = (m_File.Size() == sizeof(cTableHeader) + blocks * COL_COUNT * BLOCK_ROWS * 8);
+   }
+
+   if (!fOk)
+   {
+      Close();
+      return false;
+   }
+
+   m_Info    = pHdr->m_Info;
+   m_pBlocks = m_File.Data() + sizeof(cTableHeader);
+   m_Count   = (size_t)pHdr->m_RowCount;
+
+   return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Close()
+void cLookAngleTable::Close()
+{
+   m_File.Close();
+
+   memset(&m_Info, 0, sizeof(m_Info));
+   m_pBlocks = NULL;
+   m_Count   = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Find()
+size_t cLookAngleTable::Find(int64_t msPastEpoch) const
+{
+   size_t lo = 0;
+   size_t hi = m_Count;
+
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (TimeMs(mid) < msPastEpoch)
+      {
+         lo = mid + 1;
+      }
+      else
+      {
+         hi = mid;
+      }
+   }
+
+   if ((lo == m_Count) || (TimeMs(lo) != msPastEpoch))
+   {
+      return NOT_FOUND;
+   }
+
+   return lo;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// class cLookAngleTableWriter
+//////////////////////////////////////////////////////////////////////////////
+cLookAngleTableWriter::cLookAngleTableWriter() :
+   m_pFile(NULL),
+   m_InBlock(0),
+   m_Count(0),
+   m_fOk(false)
+{
+}
+
+cLookAngleTableWriter::~cLookAngleTableWriter()
+{
+   Close();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Create()
+bool cLookAngleTableWriter::Create(const string &path, const cLookAngleTableInfo &info)
+{
+   Close();
+
+   if (!IsLittleEndian())
+   {
+      return false;
+   }
+
+   m_Path  = path;
+   m_pFile = fopen((m_Path + ".tmp").c_str(), "wb");
+
+   if (m_pFile == NULL)
+   {
+      return false;
+   }
+
+   cTableHeader hdr;
+
+   memset(&hdr, 0, sizeof(hdr));
+   memcpy(hdr.m_Magic, TABLE_MAGIC, sizeof(hdr.m_Magic));
+
+   hdr.m_Version     = TABLE_VERSION;
+   hdr.m_ByteMark    = TABLE_BYTE_MARK;
+   hdr.m_HeaderSize  = sizeof(cTableHeader);
+   hdr.m_BlockRows   = cLookAngleTable::BLOCK_ROWS;
+   hdr.m_ColumnCount = cLookAngleTable::COL_COUNT;
+   hdr.m_RowCount    = 0;
+   hdr.m_Info        = info;
+
+   for (int col = 0; col < cLookAngleTable::COL_COUNT; col++)
+   {
+      strncpy(hdr.m_Columns[col].m_Name, TABLE_COLUMN_NAMES[col], TABLE_LEN_NAME - 1);
+
+      hdr.m_Columns[col].m_Type = (col == cLookAngleTable::COL_TIME) ? TABLE_TYPE_INT64
+                                                                      : TABLE_TYPE_DOUBLE;
+      hdr.m_Columns[col].m_Size = 8;
+   }
+
+   m_Block.assign(cLookAngleTable::COL_COUNT * cLookAngleTable::BLOCK_ROWS * 8, 0);
+   m_InBlock = 0;
+   m_Count   = 0;
+   m_fOk     = (fwrite(&hdr, sizeof(hdr), 1, m_pFile) == 1);
+
+   return m_fOk;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Append()
+void cLookAngleTableWriter::Append(int64_t msPastEpoch, double azDeg, double elDeg,
+                                   double rangeKm, double rateKmSec)
+{
+   const size_t cbColumn = cLookAngleTable::BLOCK_ROWS * 8;
+
+   char *p = &m_Block[m_InBlock * 8];
+
+   memcpy(p + cLookAngleTable::COL_TIME       * cbColumn, &msPastEpoch, 8);
+   memcpy(p + cLookAngleTable::COL_AZIMUTH    * cbColumn, &azDeg,       8);
+   memcpy(p + cLookAngleTable::COL_ELEVATION  * cbColumn, &elDeg,       8);
+   memcpy(p + cLookAngleTable::COL_RANGE      * cbColumn, &rangeKm,     8);
+   memcpy(p + cLookAngleTable::COL_RANGE_RATE * cbColumn, &rateKmSec,   8);
+
+   m_Count++;
+
+   if (++m_InBlock == cLookAngleTable::BLOCK_ROWS)
+   {
+      WriteBlock();
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// WriteBlock()
+// Writes the current block, padded with zeros to full size.
+bool cLookAngleTableWriter::WriteBlock()
+{
+   if (m_InBlock < cLookAngleTable::BLOCK_ROWS)
+   {
+      const size_t cbColumn = cLookAngleTable::BLOCK_ROWS * 8;
+
+      for (int col = 0; col < cLookAngleTable::COL_COUNT; col++)
+      {
+         memset(&m_Block[col * cbColumn + m_InBlock * 8], 0, cbColumn - m_InBlock * 8);
+      }
+   }
+
+   m_fOk = m_fOk && (fwrite(&m_Block[0], m_Block.size(), 1, m_pFile) == 1);
+   m_InBlock = 0;
+
+   return m_fOk;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Close()
+bool cLookAngleTableWriter::Close()
+{
+   if (m_pFile == NULL)
+   {
+      return m_fOk;
+   }
+
+   if (m_InBlock > 0)
+   {
+      WriteBlock();
+   }
+
+   // Row count, in place in the header
+   m_fOk = m_fOk &&
+           (fseek(m_pFile, offsetof(cTableHeader, m_RowCount), SEEK_SET) == 0) &&
+           (fwrite(&m_Count, sizeof(m_Count), 1, m_pFile) == 1);
+
+   m_fOk = (fclose(m_pFile) == 0) && m_fOk;
+
+   string pathTmp = m_Path + ".tmp";
+
+   if (m_fOk)
+   {
+      m_fOk = ReplaceWithFile(pathTmp, m_Path);
+   }
+
+   if (!m_fOk)
+   {
+      remove(pathTmp.c_str());
+   }
+
+   m_pFile = NULL;
+   m_Block.clear();
+
+   return m_fOk;
+}
+}
+}
@@ -0,0 +1,145 @@
+//
+// cLookAngleTable.h
+//
+// A binary look-angle table: the rows of a look-angle run (time, azimuth,
+// elevation, range and range rate) for one satellite and one site, stored
+// as little-endian columns for reading back by memory mapping.
+//
+// The file is a header followed by blocks of BLOCK_ROWS rows. Within a
+// block each column is contiguous (8 bytes per value); the last block is
+// padded to full size, so the address of any value is computed from its
+// row index alone. The header describes the run (satellite, site, TLE
+// epoch, sample step) and lists the columns by name, so the file can be
+// read without this code.
+//
+// Times are milliseconds past the TLE epoch. The header also keeps the
+// wall-clock time of day of the epoch and the decimal count of the text
+// output, from which the text rows can be regenerated exactly.
+//
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "cMappedFile.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+//////////////////////////////////////////////////////////////////////////////
+// struct cLookAngleTableInfo
+// Description of the run; stored in the file header.
+struct cLookAngleTableInfo
+{
+   int32_t  m_NoradId;
+   uint32_t m_DecimalCount;      // places of the text output
+   char     m_SatName [32];      // NUL terminated
+   char     m_SiteName[32];
+   double   m_SiteLatDeg;
+   double   m_SiteLonDeg;
+   double   m_SiteAltKm;
+   double   m_jdEpoch;           // TLE epoch, Julian date
+   int64_t  m_msFirst;           // first sample, ms past epoch
+   uint32_t m_msStep;            // sample step, ms
+   uint32_t m_msEpochOfDay;      // wall-clock time of day of the epoch, ms
+};
+
+//////////////////////////////////////////////////////////////////////////////
+class cLookAngleTable
+{
+public:
+   enum eColumn
+   {
+      COL_TIME,         // int64, ms past epoch
+      COL_AZIMUTH,      // double, degrees
+      COL_ELEVATION,    // double, degrees
+      COL_RANGE,        // double, km
+      COL_RANGE_RATE,   // double, km/sec
+      COL_COUNT
+   };
+
+   static const size_t BLOCK_ROWS = 4096;
+   static const size_t NOT_FOUND  = (size_t)-1;
+
+   cLookAngleTable();
+
+   // Returns false if the file is missing, truncated or not a table of
+   // this format; tables are read in place on little-endian hosts only.
+   bool Open(const string &path);
+   void Close();
+
+   const cLookAngleTableInfo& Info() const { return m_Info; }
+
+   size_t Size() const { return m_Count; }
+
+   int64_t TimeMs        (size_t row) const { return *(const int64_t *)Cell(COL_TIME, row); }
+   double  AzimuthDeg    (size_t row) const { return Value(COL_AZIMUTH,    row); }
+   double  ElevationDeg  (size_t row) const { return Value(COL_ELEVATION,  row); }
+   double  RangeKm       (size_t row) const { return Value(COL_RANGE,      row); }
+   double  RangeRateKmSec(size_t row) const { return Value(COL_RANGE_RATE, row); }
+
+   // Row of the sample taken "msPastEpoch" ms past epoch, or NOT_FOUND.
+   // Rows are in time order; the search is binary.
+   size_t Find(int64_t msPastEpoch) const;
+
+   // Row of sample "sample" of the run's grid, or NOT_FOUND.
+   size_t FindSample(uint64_t sample) const
+   {
+      return Find(m_Info.m_msFirst + (int64_t)sample * m_Info.m_msStep);
+   }
+
+   static const char* ColumnName(eColumn col);
+
+protected:
+   const char* Cell(eColumn col, size_t row) const
+   {
+      size_t block = row / BLOCK_ROWS;
+
+      return m_pBlocks + (block * COL_COUNT + col) * BLOCK_ROWS * 8 +
+                         (row - block * BLOCK_ROWS) * 8;
+   }
+
+   double Value(eColumn col, size_t row) const { return *(const double *)Cell(col, row); }
+
+   cMappedFile         m_File;
+   cLookAngleTableInfo m_Info;
+   const char         *m_pBlocks;
+   size_t              m_Count;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// class cLookAngleTableWriter
+// Writes a table row by row, one block at a time. The file is written
+// under a temporary name and moved into place by Close(), which also
+// fills in the row count.
+class cLookAngleTableWriter
+{
+public:
+   cLookAngleTableWriter();
+   ~cLookAngleTableWriter();
+
+   // Returns false if the file cannot be created, or on a big-endian host.
+   bool Create(const string &path, const cLookAngleTableInfo &info);
+
+   void Append(int64_t msPastEpoch, double azDeg, double elDeg,
+               double rangeKm, double rateKmSec);
+
+   // Returns false if any write failed.
+   bool Close();
+
+protected:
+   bool WriteBlock();
+
+   string          m_Path;
+   FILE           *m_pFile;
+   vector<char>    m_Block;
+   size_t          m_InBlock;   // rows in m_Block
+   uint64_t        m_Count;
+   bool            m_fOk;
+};
+}
+}
@@ -0,0 +1,185 @@
+//
+// cMappedFile.cpp
+//
+#include "stdafx.h"
+
+#include "cMappedFile.h"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+//////////////////////////////////////////////////////////////////////////////
+cMappedFile::cMappedFile() :
+   m_fOpen(false),
+   m_pData(NULL),
+   m_cbSize(0),
+   m_hFile(NULL),
+   m_hMapping(NULL),
+   m_fd(-1)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cMappedFile::~cMappedFile()
+{
+   Close();
+}
+
+#ifdef _WIN32
+
+//////////////////////////////////////////////////////////////////////////////
+// Open()
+bool cMappedFile::Open(const string &path)
+{
+   Close();
+
+   HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                              NULL);
+
+   if (hFile == INVALID_HANDLE_VALUE)
+   {
+      return false;
+   }
+
+   LARGE_INTEGER size;
+
+   if (!GetFileSizeEx(hFile, &size))
+   {
+      CloseHandle(hFile);
+      return false;
+   }
+
+   m_hFile  = hFile;
+   m_cbSize = (size_t)size.QuadPart;
+   m_fOpen  = true;
+
+   if (m_cbSize == 0)
+   {
+      // A zero-length file cannot be mapped
+      return true;
+   }
+
+   HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+   if (hMapping == NULL)
+   {
+      Close();
+      return false;
+   }
+
+   m_hMapping = hMapping;
+   m_pData    = (const char *)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+   if (m_pData == NULL)
+   {
+      Close();
+      return false;
+   }
+
+   return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Close()
+void cMappedFile::Close()
+{
+   if (m_pData)    { UnmapViewOfFile(m_pData);      }
+   if (m_hMapping) { CloseHandle((HANDLE)m_hMapping); }
+   if (m_hFile)    { CloseHandle((HANDLE)m_hFile);    }
+
+   m_fOpen    = false;
+   m_pData    = NULL;
+   m_cbSize   = 0;
+   m_hFile    = NULL;
+   m_hMapping = NULL;
+}
+
+#else
+
+//////////////////////////////////////////////////////////////////////////////
+// Open()
+bool cMappedFile::Open(const string &path)
+{
+   Close();
+
+   int fd = open(path.c_str(), O_RDONLY);
+
+   if (fd < 0)
+   {
+      return false;
+   }
+
+   struct stat st;
+
+   if (fstat(fd, &st) != 0)
+   {
+      close(fd);
+      return false;
+   }
+
+   m_fd     = fd;
+   m_cbSize = (size_t)st.st_size;
+   m_fOpen  = true;
+
+   if (m_cbSize == 0)
+   {
+      // A zero-length file cannot be mapped
+      return true;
+   }
+
+   void *p = mmap(NULL, m_cbSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+   if (p == MAP_FAILED)
+   {
+      Close();
+      return false;
+   }
+
+   m_pData = (const char *)p;
+
+   return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Close()
+void cMappedFile::Close()
+{
+   if (m_pData)   { munmap((void *)m_pData, m_cbSize); }
+   if (m_fd >= 0) { close(m_fd); }
+
+   m_fOpen  = false;
+   m_pData  = NULL;
+   m_cbSize = 0;
+   m_fd     = -1;
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// ReplaceWithFile()
+// rename() replaces an existing file atomically on POSIX systems; on
+// Windows it fails instead, so MoveFileEx() is asked to replace it.
+bool ReplaceWithFile(const std::string &pathFrom, const std::string &pathTo)
+{
+#ifdef _WIN32
+   return MoveFileExA(pathFrom.c_str(), pathTo.c_str(),
+                      MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+   return rename(pathFrom.c_str(), pathTo.c_str()) == 0;
+#endif
+}
+}
+}
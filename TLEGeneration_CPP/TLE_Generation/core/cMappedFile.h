@@ -0,0 +1,54 @@
+//
+// cMappedFile.h
+//
+// This class maps a whole file read-only into memory, using
+// CreateFileMapping() on Windows and mmap() elsewhere. The contents stay
+// valid until Close() or destruction.
+//
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+//////////////////////////////////////////////////////////////////////////////
+class cMappedFile
+{
+public:
+   cMappedFile();
+   ~cMappedFile();
+
+   // Returns false if the file cannot be opened or mapped. An empty file
+   // opens successfully with Size() zero.
+   bool Open(const std::string &path);
+   void Close();
+
+   bool        IsOpen() const { return m_fOpen; }
+   const char* Data()   const { return m_pData; }
+   size_t      Size()   const { return m_cbSize; }
+
+private:
+   cMappedFile(const cMappedFile&);
+   cMappedFile& operator=(const cMappedFile&);
+
+   bool        m_fOpen;
+   const char *m_pData;
+   size_t      m_cbSize;
+
+   // Platform handles: file and mapping on Windows, descriptor elsewhere
+   void *m_hFile;
+   void *m_hMapping;
+   int   m_fd;
+};
+
+// Moves the file "pathFrom" to "pathTo", replacing any file there in one
+// step, so that a reader finds either the old or the new file, and the
+// old one is kept if the move fails. Used to publish files that were
+// written under a temporary name.
+bool ReplaceWithFile(const std::string &pathFrom, const std::string &pathTo);
+}
+}
@@ -12,11 +12,21 @@ namespace Zeptomoby
 {
 namespace OrbitTools 
 {
+// With refraction on, LookAngle() can lift an object that is slightly
+// below the horizon (up to about 0.55 degrees) to above it. Objects this
+// far below are never reported visible.
+static const double SITE_REFRACTION_MARGIN = deg2rad(1.0);
+
+static const double SITE_SIN_MARGIN_SQ = sqr(sin(SITE_REFRACTION_MARGIN));
+
+const double cSite::BELOW_HORIZON = -PI / 2.0;
 
 //////////////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 cSite::cSite(const cGeo &geo) : m_Geo(geo)
-{}
+{
+   InitializeCachingVars();
+}
 
 //////////////////////////////////////////////////////////////////////////////
 // c'tor accepting:
@@ -27,7 +37,9 @@ cSite::cSite(const cGeo &geo) : m_Geo(geo)
 cSite::cSite(double degLat, double degLon, double kmAlt, const string& name) :
    m_Geo(deg2rad(degLat), deg2rad(degLon), kmAlt),
    m_Name(name)
-{}
+{
+   InitializeCachingVars();
+}
 
 //////////////////////////////////////////////////////////////////////////////
 // c'tor accepting:
@@ -36,11 +48,48 @@ cSite::cSite(double degLat, double degLon, double kmAlt, const string& name) :
 //    Altitude  in km
 cSite::cSite(double degLat, double degLon, double kmAlt) :
    m_Geo(deg2rad(degLat), deg2rad(degLon), kmAlt)
-{}
+{
+   InitializeCachingVars();
+}
 
 cSite::~cSite()
 {}
 
+//////////////////////////////////////////////////////////////////////////////
+// InitializeCachingVars()
+// The site's Earth-fixed position (as in cEci(const cGeo&, cJulian), with
+// the longitude in place of the sidereal time) and the rotation into the
+// topocentric frame.
+void cSite::InitializeCachingVars()
+{
+   double sin_lat = sin(LatitudeRad());
+   double cos_lat = cos(LatitudeRad());
+   double sin_lon = sin(LongitudeRad());
+   double cos_lon = cos(LongitudeRad());
+   double alt     = AltitudeKm();
+
+   double c = 1.0 / sqrt(1.0 + F * (F - 2.0) * sqr(sin_lat));
+   double s = sqr(1.0 - F) * c;
+   double achcp = (XKMPER_WGS72 * c + alt) * cos_lat;
+
+   m_PosEcef.m_x = achcp * cos_lon;
+   m_PosEcef.m_y = achcp * sin_lon;
+   m_PosEcef.m_z = (XKMPER_WGS72 * s + alt) * sin_lat;
+   m_PosEcef.m_w = sqrt(sqr(m_PosEcef.m_x) +
+                        sqr(m_PosEcef.m_y) +
+                        sqr(m_PosEcef.m_z));
+
+   m_Sez[0][0] =  sin_lat * cos_lon;    // south
+   m_Sez[0][1] =  sin_lat * sin_lon;
+   m_Sez[0][2] = -cos_lat;
+   m_Sez[1][0] = -sin_lon;              // east
+   m_Sez[1][1] =  cos_lon;
+   m_Sez[1][2] =  0.0;
+   m_Sez[2][0] =  cos_lat * cos_lon;    // zenith
+   m_Sez[2][1] =  cos_lat * sin_lon;
+   m_Sez[2][2] =  sin_lat;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // Return the ECI coordinate of the site at the given time.
 cEciTime cSite::PositionEci(const cJulian &date) const
@@ -61,41 +110,129 @@ cEciTime cSite::GetPosition(const cJulian &date) const
 // object located at the given ECI coordinates.
 cTopo cSite::GetLookAngle(const cEciTime &eci) const
 {
-   // Calculate the ECI coordinates for this cSite object at the time
-   // of interest.
-   cJulian  date = eci.Date();
-   cEciTime eciSite(m_Geo, date); 
-
-   cVector vecRgRate(eci.Velocity().m_x - eciSite.Velocity().m_x,
-                     eci.Velocity().m_y - eciSite.Velocity().m_y,
-                     eci.Velocity().m_z - eciSite.Velocity().m_z);
-//   cout<<eci.Velocity().m_x - eciSite.Velocity().m_x<<" "<<
-//          eci.Velocity().m_y - eciSite.Velocity().m_y<<" "<<
-//          eci.Velocity().m_z - eciSite.Velocity().m_z<<endl;
-
-   double x = eci.Position().m_x - eciSite.Position().m_x;
-   double y = eci.Position().m_y - eciSite.Position().m_y;
-   double z = eci.Position().m_z - eciSite.Position().m_z;
+   return GetLookAngle(cEcef(eci, cGmstRotation(eci.Date())));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// GetLookAngle()
+// As above, with the GMST rotation of the time of interest supplied by
+// the caller.
+cTopo cSite::GetLookAngle(const cEci &eci, const cGmstRotation &rot) const
+{
+   return GetLookAngle(cEcef(eci, rot));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// GetLookAngle()
+// Return the topocentric coordinates for a target object located at the
+// given Earth-fixed coordinates.
+cTopo cSite::GetLookAngle(const cEcef &ecef) const
+{
+   double az, el, range, rate;
+
+   LookAngle(ecef.Position().m_x, ecef.Position().m_y, ecef.Position().m_z,
+             ecef.Velocity().m_x, ecef.Velocity().m_y, ecef.Velocity().m_z,
+             &az, &el, &range, &rate);
+
+   cTopo topo(az,           // azimuth,   radians
+              el,           // elevation, radians
+              range,        // range, km
+              rate);        // rate,  km / sec
+
+   return topo;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// GetLookAngleLazy()
+cLookAngle cSite::GetLookAngleLazy(const cEcef &ecef) const
+{
+   return cLookAngle(*this, ecef);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// IsBelowHorizon()
+// The object is below the horizon when the range vector points away from
+// the zenith. With refraction, it must also be more than
+// SITE_REFRACTION_MARGIN below: top_z / range < -sin(margin), compared in
+// squares so that no square root is needed.
+bool cSite::IsBelowHorizon(double x, double y, double z) const
+{
+   x -= m_PosEcef.m_x;
+   y -= m_PosEcef.m_y;
+   z -= m_PosEcef.m_z;
+
+   double top_z = m_Sez[2][0] * x +
+                  m_Sez[2][1] * y +
+                  m_Sez[2][2] * z;
+
+   if (top_z >= 0.0)
+   {
+      return false;
+   }
+
+#ifdef WANT_ATMOSPHERIC_CORRECTION   
+   if (isAtmosphericCorrectionRequired)
+   {
+      return sqr(top_z) > SITE_SIN_MARGIN_SQ * (sqr(x) + sqr(y) + sqr(z));
+   }
+#endif
+
+   return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// GetLookAngleBatch()
+// Topocentric coordinates of "count" Earth-fixed positions and velocities
+// (see cEcef::FromEciBatch()).
+void cSite::GetLookAngleBatch(const cEciArrays &ecef, size_t count,
+                              const cTopoArrays &topo,
+                              bool fVisibleOnly /* = false */) const
+{
+   for (size_t i = 0; i < count; i++)
+   {
+      if (fVisibleOnly && IsBelowHorizon(ecef.m_x[i], ecef.m_y[i], ecef.m_z[i]))
+      {
+         topo.m_Az[i]        = 0.0;
+         topo.m_El[i]        = BELOW_HORIZON;
+         topo.m_Range[i]     = 0.0;
+         topo.m_RangeRate[i] = 0.0;
+         continue;
+      }
+
+      LookAngle(ecef.m_x [i], ecef.m_y [i], ecef.m_z [i],
+                ecef.m_vx[i], ecef.m_vy[i], ecef.m_vz[i],
+                &topo.m_Az[i], &topo.m_El[i], &topo.m_Range[i], &topo.m_RangeRate[i]);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// LookAngle()
+// Azimuth, elevation (radians), range (km) and range rate (km/sec) of an
+// object at the given Earth-fixed position and velocity.
+void cSite::LookAngle(double x,  double y,  double z,
+                      double vx, double vy, double vz,
+                      double *pAz, double *pEl, double *pRange, double *pRate) const
+{
+   x -= m_PosEcef.m_x;
+   y -= m_PosEcef.m_y;
+   z -= m_PosEcef.m_z;
+
    double w = sqrt(sqr(x) + sqr(y) + sqr(z));
 
    cVector vecRange(x, y, z, w);
 
-   // The site's Local Mean Sidereal Time at the time of interest.
-   double theta = date.ToLmst(LongitudeRad());
-
-   double sin_lat   = sin(LatitudeRad());
-   double cos_lat   = cos(LatitudeRad());
-   double sin_theta = sin(theta);
-   double cos_theta = cos(theta);
-
-   double top_s = sin_lat * cos_theta * vecRange.m_x + 
-                  sin_lat * sin_theta * vecRange.m_y - 
-                  cos_lat * vecRange.m_z;
-   double top_e = -sin_theta * vecRange.m_x + 
-                   cos_theta * vecRange.m_y;
-   double top_z = cos_lat * cos_theta * vecRange.m_x + 
-                  cos_lat * sin_theta * vecRange.m_y + 
-                  sin_lat * vecRange.m_z;
+   // The site is at rest in this frame, so the object's velocity is the
+   // range rate vector.
+   cVector vecRgRate(vx, vy, vz);
+
+   double top_s = m_Sez[0][0] * vecRange.m_x +
+                  m_Sez[0][1] * vecRange.m_y +
+                  m_Sez[0][2] * vecRange.m_z;
+   double top_e = m_Sez[1][0] * vecRange.m_x +
+                  m_Sez[1][1] * vecRange.m_y;
+   double top_z = m_Sez[2][0] * vecRange.m_x +
+                  m_Sez[2][1] * vecRange.m_y +
+                  m_Sez[2][2] * vecRange.m_z;
    double az    = atan(-top_e / top_s);
 
    if (top_s > 0.0)
@@ -137,12 +274,46 @@ cTopo cSite::GetLookAngle(const cEciTime &eci) const
    }
 #endif
 
-   cTopo topo(az,           // azimuth,   radians
-              el,           // elevation, radians
-              vecRange.m_w, // range, km
-              rate);        // rate,  km / sec
+   *pAz    = az;
+   *pEl    = el;
+   *pRange = vecRange.m_w;
+   *pRate  = rate;
+}
 
-   return topo;
+//////////////////////////////////////////////////////////////////////////////
+// class cLookAngle
+//////////////////////////////////////////////////////////////////////////////
+cLookAngle::cLookAngle(const cSite &site, const cEcef &ecef) :
+   m_pSite(&site),
+   m_Ecef(ecef),
+   m_fBelowHorizon(site.IsBelowHorizon(ecef.Position().m_x,
+                                       ecef.Position().m_y,
+                                       ecef.Position().m_z)),
+   m_fEvaluated(false),
+   m_Az(0.0),
+   m_El(0.0),
+   m_Range(0.0),
+   m_RangeRate(0.0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// EvaluateTopo()
+void cLookAngle::EvaluateTopo() const
+{
+   m_pSite->LookAngle(m_Ecef.Position().m_x, m_Ecef.Position().m_y, m_Ecef.Position().m_z,
+                      m_Ecef.Velocity().m_x, m_Ecef.Velocity().m_y, m_Ecef.Velocity().m_z,
+                      &m_Az, &m_El, &m_Range, &m_RangeRate);
+   m_fEvaluated = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Topo()
+cTopo cLookAngle::Topo() const
+{
+   Evaluate();
+
+   return cTopo(m_Az, m_El, m_Range, m_RangeRate);
 }
 
 //////////////////////////////////////////////////////////////////////////////
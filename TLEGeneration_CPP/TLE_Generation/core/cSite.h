@@ -14,9 +14,14 @@ namespace Zeptomoby
 namespace OrbitTools 
 {
 
+class cLookAngle;
+
 //////////////////////////////////////////////////////////////////////
 // class cSite
-// This class represents a ground site location on the earth.
+// This class represents a ground site location on the earth. The site's
+// Earth-fixed position and its topocentric rotation are computed once, at
+// construction, so look angles only need the object's Earth-fixed
+// coordinates: one GMST rotation per timestamp, for any number of sites.
 class cSite  
 {
 public:
@@ -31,6 +36,33 @@ public:
    cEciTime GetPosition (const cJulian& ) const;   // Deprecated, use PositionEci()
    cTopo    GetLookAngle(const cEciTime&) const;   // Calc topo coords of ECI object
 
+   // Topo coords of an ECI object, with the GMST rotation of its time
+   cTopo    GetLookAngle(const cEci&, const cGmstRotation&) const;
+
+   // Topo coords of an object in Earth-fixed coordinates
+   cTopo    GetLookAngle(const cEcef&) const;
+
+   // Look angle of an object in Earth-fixed coordinates, evaluated only
+   // as far as it is used (see cLookAngle)
+   cLookAngle GetLookAngleLazy(const cEcef&) const;
+
+   // Topo coords of "count" objects in Earth-fixed coordinates. With
+   // fVisibleOnly, objects for which IsBelowHorizon() holds are not
+   // evaluated: their elevation is set to BELOW_HORIZON and their other
+   // values to zero.
+   void     GetLookAngleBatch(const cEciArrays &ecef, size_t count,
+                              const cTopoArrays &topo,
+                              bool fVisibleOnly = false) const;
+
+   // True if an object at the given Earth-fixed position (km) cannot
+   // have a look angle at or above the horizon. Takes one dot product.
+   bool     IsBelowHorizon(double x, double y, double z) const;
+
+   static const double BELOW_HORIZON;   // -PI/2
+
+   // Site position in Earth-fixed coordinates, km
+   const cVector& PositionEcef() const { return m_PosEcef; }
+
    double LatitudeRad()  const { return m_Geo.LatitudeRad();  }
    double LongitudeRad() const { return m_Geo.LongitudeRad(); }
 
@@ -43,8 +75,60 @@ public:
    string ToString() const;
 
 protected:
+   friend class cLookAngle;
+
+   void InitializeCachingVars();
+   void LookAngle(double x,  double y,  double z,
+                  double vx, double vy, double vz,
+                  double *pAz, double *pEl, double *pRange, double *pRate) const;
+
    cGeo   m_Geo;  // Site coordinates
    string m_Name; // Site name
+
+   // Caching variables
+   cVector m_PosEcef;      // Earth-fixed position, km
+   double  m_Sez[3][3];    // Earth-fixed to topocentric (south, east, zenith)
+};
+
+//////////////////////////////////////////////////////////////////////
+// class cLookAngle
+// The look angle of an object from a site, evaluated on demand. The
+// horizon test is made up front from the zenith component of the range
+// vector alone; azimuth, elevation, range and rate are computed together
+// on first use of any of them. Results equal cSite::GetLookAngle().
+class cLookAngle
+{
+public:
+   bool IsBelowHorizon() const { return m_fBelowHorizon; }
+
+   double AzimuthRad()     const { Evaluate(); return m_Az;        }
+   double ElevationRad()   const { Evaluate(); return m_El;        }
+
+   double AzimuthDeg()     const { return rad2deg(AzimuthRad());   }
+   double ElevationDeg()   const { return rad2deg(ElevationRad()); }
+
+   double RangeKm()        const { Evaluate(); return m_Range;     }
+   double RangeRateKmSec() const { Evaluate(); return m_RangeRate; }
+
+   cTopo  Topo() const;
+
+protected:
+   friend class cSite;
+
+   cLookAngle(const cSite &site, const cEcef &ecef);
+
+   void Evaluate() const { if (!m_fEvaluated) EvaluateTopo(); }
+   void EvaluateTopo() const;
+
+   const cSite *m_pSite;
+   cEcef        m_Ecef;
+   bool         m_fBelowHorizon;
+
+   mutable bool   m_fEvaluated;
+   mutable double m_Az;
+   mutable double m_El;
+   mutable double m_Range;
+   mutable double m_RangeRate;
 };
 }
 }
\ No newline at end of file
@@ -41,6 +41,168 @@ const int TLE2_COL_MEANANOMALY   = 43; const int TLE2_LEN_MEANANOMALY   =  8;
 const int TLE2_COL_MEANMOTION    = 52; const int TLE2_LEN_MEANMOTION    = 11;
 const int TLE2_COL_REVATEPOCH    = 63; const int TLE2_LEN_REVATEPOCH    =  5;
 
+// Exact powers of ten. A field is decoded as an integer mantissa scaled by
+// one of these in a single correctly rounded operation, which gives the
+// same double as atof() while the mantissa fits in 53 bits.
+static const double POW10[] =
+{
+   1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const int                TLE_MAX_POW10    = 22;
+static const unsigned long long TLE_MAX_MANTISSA = 1ULL << 53;
+static const int                TLE_MAX_FIELD    = 16;
+
+/////////////////////////////////////////////////////////////////////////////
+// Columns()
+// Points pBegin/pEnd at columns [col, col + len) of the line, clipped to
+// its length.
+static void Columns(const char *pLine, size_t lenLine, int col, int len,
+                    const char *&pBegin, const char *&pEnd)
+{
+   size_t first = min((size_t)col, lenLine);
+   size_t last  = min((size_t)(col + len), lenLine);
+
+   pBegin = pLine + first;
+   pEnd   = pLine + last;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+static bool IsDigit(const char *p, const char *pEnd)
+{
+   return (p < pEnd) && (*p >= '0') && (*p <= '9');
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DecodeText()
+// The value atof() gives for the text [p, pEnd) (at most TLE_MAX_FIELD
+// characters): leading blanks, a sign, digits with at most one decimal
+// point and an optional exponent, up to the first other character. Values
+// outside the exact range fall back to strtod() on a stack copy.
+static double DecodeText(const char *p, const char *pEnd)
+{
+   const char *pText = p;
+
+   while ((p < pEnd) && (*p == ' ')) { p++; }
+
+   bool fNeg = false;
+
+   if ((p < pEnd) && ((*p == '-') || (*p == '+')))
+   {
+      fNeg = (*p == '-');
+      p++;
+   }
+
+   unsigned long long mantissa = 0;
+   int  exp10   = 0;
+   bool fDigits = false;
+
+   for (; IsDigit(p, pEnd); p++)
+   {
+      mantissa = (mantissa * 10) + (*p - '0');
+      fDigits  = true;
+   }
+
+   if ((p < pEnd) && (*p == '.'))
+   {
+      for (p++; IsDigit(p, pEnd); p++)
+      {
+         mantissa = (mantissa * 10) + (*p - '0');
+         fDigits  = true;
+         exp10--;
+      }
+   }
+
+   if (fDigits && (p < pEnd) && ((*p == 'e') || (*p == 'E')))
+   {
+      const char *pExp = p + 1;
+      bool fExpNeg = false;
+
+      if ((pExp < pEnd) && ((*pExp == '-') || (*pExp == '+')))
+      {
+         fExpNeg = (*pExp == '-');
+         pExp++;
+      }
+
+      // Without digits the 'e' is not part of the number.
+      if (IsDigit(pExp, pEnd))
+      {
+         int exp = 0;
+
+         for (; IsDigit(pExp, pEnd); pExp++)
+         {
+            exp = (exp * 10) + (*pExp - '0');
+         }
+
+         exp10 += fExpNeg ? -exp : exp;
+      }
+   }
+
+   if (!fDigits)
+   {
+      return 0.0;
+   }
+
+   if ((mantissa > TLE_MAX_MANTISSA) ||
+       (exp10 < -TLE_MAX_POW10) || (exp10 > TLE_MAX_POW10))
+   {
+      char   text[TLE_MAX_FIELD + 1];
+      size_t len = min((size_t)(pEnd - pText), (size_t)TLE_MAX_FIELD);
+
+      memcpy(text, pText, len);
+      text[len] = '\0';
+
+      return atof(text);
+   }
+
+   double val = (double)mantissa;
+
+   val = (exp10 < 0) ? val / POW10[-exp10] : val * POW10[exp10];
+
+   return fNeg ? -val : val;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DecodeExp()
+// The value of a TLE-style exponential field, as atof(ExpToAtof(field)).
+// The text is assembled on the stack.
+static double DecodeExp(const char *p, const char *pEnd)
+{
+   const int LEN_MANTISSA = 5;
+
+   char  text[TLE_MAX_FIELD];
+   char *pText = text;
+
+   if (p < pEnd) { *pText++ = *p++; }
+
+   *pText++ = '0';
+   *pText++ = '.';
+
+   for (int i = 0; (i < LEN_MANTISSA) && (p < pEnd); i++) { *pText++ = *p++; }
+
+   *pText++ = 'e';
+
+   while ((p < pEnd) && (*p == ' ')) { p++; }
+   while (p < pEnd) { *pText++ = *p++; }
+
+   return DecodeText(text, pText);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// DecodePrefixed()
+// The value of the text "prefix" followed by [p, pEnd).
+static double DecodePrefixed(const char *prefix, const char *p, const char *pEnd)
+{
+   char  text[TLE_MAX_FIELD];
+   char *pText = text;
+
+   while (*prefix) { *pText++ = *prefix++; }
+   while (p < pEnd) { *pText++ = *p++; }
+
+   return DecodeText(text, pText);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 cTle::cTle(string& strName, string& strLine1, string& strLine2)
 {
@@ -49,7 +211,13 @@ cTle::cTle(string& strName, string& strLine1, string& strLine2)
    m_strLine2 = strLine2;
 
    TrimRight(m_strLine0);
-   Initialize();
+
+   assert(!m_strLine1.empty());
+   assert(!m_strLine2.empty());
+
+   Decode(m_strLine1.data(), m_strLine1.size(),
+          m_strLine2.data(), m_strLine2.size(),
+          m_Elements);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -59,12 +227,7 @@ cTle::cTle(const cTle &tle)
    m_strLine1 = tle.m_strLine1;
    m_strLine2 = tle.m_strLine2;
 
-   for (int fld = FLD_FIRST; fld < FLD_LAST; fld++)
-   {
-      m_Field[fld] = tle.m_Field[fld];
-   }
-
-   m_mapCache = tle.m_mapCache;
+   m_Elements = tle.m_Elements;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -78,8 +241,8 @@ cTle::~cTle()
 // string (*pstr) in the units requested (eUnit). Set 'bStrUnits' to true 
 // to have units appended to text string.
 //
-// Note: numeric return values are cached; asking for the same field more
-// than once incurs minimal overhead.
+// Note: numeric values are decoded once, at construction; asking for a
+// field only costs the unit conversion.
 double cTle::GetField(eField   fld, 
                       eUnits   units,    /* = U_NATIVE */
                       string  *pstr      /* = NULL     */,
@@ -91,7 +254,7 @@ double cTle::GetField(eField   fld,
    if (pstr)
    {
       // Return requested field in string form.
-      *pstr = m_Field[fld];
+      *pstr = FieldText(fld);
       
       if (bStrUnits)
       {
@@ -106,23 +269,7 @@ double cTle::GetField(eField   fld,
    else
    {
       // Return requested field in floating-point form.
-      // Return cache contents if it exists, else populate cache
-      FldKey key = Key(units, fld);
-
-      if (m_mapCache.find(key) == m_mapCache.end())
-      {
-         // Value not in cache; add it
-         double valNative = atof(m_Field[fld].c_str());
-         double valConv   = ConvertUnits(valNative, fld, units); 
-         m_mapCache[key]  = valConv;
-
-         return valConv;
-      }
-      else
-      {
-         // return cached value
-         return m_mapCache[key];
-      }
+      return ConvertUnits(m_Elements.m_Field[fld], fld, units);
    }
 }
 
@@ -206,84 +353,141 @@ string cTle::ExpToAtof(const string &str)
 }
 
 /////////////////////////////////////////////////////////////////////////////
-// Initialize()
-// Initialize the string array.
-void cTle::Initialize()
+// Decode()
+void cTle::Decode(const char *pLine1, size_t len1,
+                  const char *pLine2, size_t len2,
+                  cElements  &el)
 {
-   // Have we already been initialized?
-   if (m_Field[FLD_NORADNUM].size()) { return; }
-   
-   assert(!m_strLine1.empty());
-   assert(!m_strLine2.empty());
-   
-   m_Field[FLD_NORADNUM] = m_strLine1.substr(TLE1_COL_SATNUM, TLE1_LEN_SATNUM);
-   m_Field[FLD_INTLDESC] = m_strLine1.substr(TLE1_COL_INTLDESC_A,
-                                             TLE1_LEN_INTLDESC_A +
-                                             TLE1_LEN_INTLDESC_B +   
-                                             TLE1_LEN_INTLDESC_C);   
-   m_Field[FLD_EPOCHYEAR] = 
-         m_strLine1.substr(TLE1_COL_EPOCH_A, TLE1_LEN_EPOCH_A);
-
-   m_Field[FLD_EPOCHDAY] = 
-         m_strLine1.substr(TLE1_COL_EPOCH_B, TLE1_LEN_EPOCH_B);
-   
-   if (m_strLine1[TLE1_COL_MEANMOTIONDT] == '-')
-   {
-      // value is negative
-      m_Field[FLD_MMOTIONDT] = "-0";
-   }
-   else
+   const char *p;
+   const char *pEnd;
+
+   Columns(pLine1, len1, TLE1_COL_SATNUM, TLE1_LEN_SATNUM, p, pEnd);
+   el.m_Field[FLD_NORADNUM] = DecodeText(p, pEnd);
+
+   Columns(pLine1, len1, TLE1_COL_INTLDESC_A,
+           TLE1_LEN_INTLDESC_A + TLE1_LEN_INTLDESC_B + TLE1_LEN_INTLDESC_C,
+           p, pEnd);
+   el.m_Field[FLD_INTLDESC] = DecodeText(p, pEnd);
+
+   Columns(pLine1, len1, TLE1_COL_EPOCH_A, TLE1_LEN_EPOCH_A, p, pEnd);
+   el.m_Field[FLD_EPOCHYEAR] = DecodeText(p, pEnd);
+
+   Columns(pLine1, len1, TLE1_COL_EPOCH_B, TLE1_LEN_EPOCH_B, p, pEnd);
+   el.m_Field[FLD_EPOCHDAY] = DecodeText(p, pEnd);
+
+   // The sign column is followed by the value without its leading zero.
    {
-      m_Field[FLD_MMOTIONDT] = "0";
+      bool fNeg = ((size_t)TLE1_COL_MEANMOTIONDT < len1) &&
+                  (pLine1[TLE1_COL_MEANMOTIONDT] == '-');
+
+      Columns(pLine1, len1, TLE1_COL_MEANMOTIONDT + 1, TLE1_LEN_MEANMOTIONDT,
+              p, pEnd);
+      el.m_Field[FLD_MMOTIONDT] = DecodePrefixed(fNeg ? "-0" : "0", p, pEnd);
    }
-   
-   m_Field[FLD_MMOTIONDT] += m_strLine1.substr(TLE1_COL_MEANMOTIONDT + 1,
-                                               TLE1_LEN_MEANMOTIONDT);
-   
+
    // decimal point assumed; exponential notation
-   m_Field[FLD_MMOTIONDT2] = ExpToAtof(
-                                 m_strLine1.substr(TLE1_COL_MEANMOTIONDT2,
-                                                   TLE1_LEN_MEANMOTIONDT2));
+   Columns(pLine1, len1, TLE1_COL_MEANMOTIONDT2, TLE1_LEN_MEANMOTIONDT2,
+           p, pEnd);
+   el.m_Field[FLD_MMOTIONDT2] = DecodeExp(p, pEnd);
+
    // decimal point assumed; exponential notation
-   m_Field[FLD_BSTAR] = ExpToAtof(m_strLine1.substr(TLE1_COL_BSTAR,
-                                                    TLE1_LEN_BSTAR));
-   // TLE1_COL_EPHEMTYPE      
-   // TLE1_LEN_EPHEMTYPE   
-   m_Field[FLD_SET] = m_strLine1.substr(TLE1_COL_ELNUM, TLE1_LEN_ELNUM);
-   
-   TrimLeft(m_Field[FLD_SET]);
-   
-   // TLE2_COL_SATNUM         
-   // TLE2_LEN_SATNUM         
-   
-   m_Field[FLD_I] = m_strLine2.substr(TLE2_COL_INCLINATION,
-                                      TLE2_LEN_INCLINATION);
-   TrimLeft(m_Field[FLD_I]);
-   
-   m_Field[FLD_RAAN] = m_strLine2.substr(TLE2_COL_RAASCENDNODE,
-                                         TLE2_LEN_RAASCENDNODE);
-   TrimLeft(m_Field[FLD_RAAN]);
+   Columns(pLine1, len1, TLE1_COL_BSTAR, TLE1_LEN_BSTAR, p, pEnd);
+   el.m_Field[FLD_BSTAR] = DecodeExp(p, pEnd);
+
+   Columns(pLine1, len1, TLE1_COL_ELNUM, TLE1_LEN_ELNUM, p, pEnd);
+   el.m_Field[FLD_SET] = DecodeText(p, pEnd);
+
+   Columns(pLine2, len2, TLE2_COL_INCLINATION, TLE2_LEN_INCLINATION, p, pEnd);
+   el.m_Field[FLD_I] = DecodeText(p, pEnd);
+
+   Columns(pLine2, len2, TLE2_COL_RAASCENDNODE, TLE2_LEN_RAASCENDNODE, p, pEnd);
+   el.m_Field[FLD_RAAN] = DecodeText(p, pEnd);
 
    // decimal point is assumed
-   m_Field[FLD_E] = "0.";
-   m_Field[FLD_E] += m_strLine2.substr(TLE2_COL_ECCENTRICITY,
-                                       TLE2_LEN_ECCENTRICITY);
-   
-   m_Field[FLD_ARGPER] = m_strLine2.substr(TLE2_COL_ARGPERIGEE,
-                                           TLE2_LEN_ARGPERIGEE);
-   TrimLeft(m_Field[FLD_ARGPER]);
-   
-   m_Field[FLD_M] = m_strLine2.substr(TLE2_COL_MEANANOMALY,
-                                      TLE2_LEN_MEANANOMALY);
-   TrimLeft(m_Field[FLD_M]);
-   
-   m_Field[FLD_MMOTION] = m_strLine2.substr(TLE2_COL_MEANMOTION, 
-                                            TLE2_LEN_MEANMOTION);
-   TrimLeft(m_Field[FLD_MMOTION]);
-   
-   m_Field[FLD_ORBITNUM] = m_strLine2.substr(TLE2_COL_REVATEPOCH,
-                                             TLE2_LEN_REVATEPOCH);
-   TrimLeft(m_Field[FLD_ORBITNUM]);
+   Columns(pLine2, len2, TLE2_COL_ECCENTRICITY, TLE2_LEN_ECCENTRICITY, p, pEnd);
+   el.m_Field[FLD_E] = DecodePrefixed("0.", p, pEnd);
+
+   Columns(pLine2, len2, TLE2_COL_ARGPERIGEE, TLE2_LEN_ARGPERIGEE, p, pEnd);
+   el.m_Field[FLD_ARGPER] = DecodeText(p, pEnd);
+
+   Columns(pLine2, len2, TLE2_COL_MEANANOMALY, TLE2_LEN_MEANANOMALY, p, pEnd);
+   el.m_Field[FLD_M] = DecodeText(p, pEnd);
+
+   Columns(pLine2, len2, TLE2_COL_MEANMOTION, TLE2_LEN_MEANMOTION, p, pEnd);
+   el.m_Field[FLD_MMOTION] = DecodeText(p, pEnd);
+
+   Columns(pLine2, len2, TLE2_COL_REVATEPOCH, TLE2_LEN_REVATEPOCH, p, pEnd);
+   el.m_Field[FLD_ORBITNUM] = DecodeText(p, pEnd);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// FieldText()
+// The text of a field, in atof()-readable form. Only built when a caller
+// asks for a field as a string.
+string cTle::FieldText(eField fld) const
+{
+   const string &line1 = m_strLine1;
+   const string &line2 = m_strLine2;
+
+   switch (fld)
+   {
+      case FLD_NORADNUM:
+         return line1.substr(TLE1_COL_SATNUM, TLE1_LEN_SATNUM);
+
+      case FLD_INTLDESC:
+         return line1.substr(TLE1_COL_INTLDESC_A,
+                             TLE1_LEN_INTLDESC_A +
+                             TLE1_LEN_INTLDESC_B +
+                             TLE1_LEN_INTLDESC_C);
+
+      case FLD_SET:
+         return line1.substr(TLE1_COL_ELNUM, TLE1_LEN_ELNUM);
+
+      case FLD_EPOCHYEAR:
+         return line1.substr(TLE1_COL_EPOCH_A, TLE1_LEN_EPOCH_A);
+
+      case FLD_EPOCHDAY:
+         return line1.substr(TLE1_COL_EPOCH_B, TLE1_LEN_EPOCH_B);
+
+      case FLD_ORBITNUM:
+         return line2.substr(TLE2_COL_REVATEPOCH, TLE2_LEN_REVATEPOCH);
+
+      case FLD_I:
+         return line2.substr(TLE2_COL_INCLINATION, TLE2_LEN_INCLINATION);
+
+      case FLD_RAAN:
+         return line2.substr(TLE2_COL_RAASCENDNODE, TLE2_LEN_RAASCENDNODE);
+
+      case FLD_E:
+         // decimal point is assumed
+         return "0." + line2.substr(TLE2_COL_ECCENTRICITY,
+                                    TLE2_LEN_ECCENTRICITY);
+
+      case FLD_ARGPER:
+         return line2.substr(TLE2_COL_ARGPERIGEE, TLE2_LEN_ARGPERIGEE);
+
+      case FLD_M:
+         return line2.substr(TLE2_COL_MEANANOMALY, TLE2_LEN_MEANANOMALY);
+
+      case FLD_MMOTION:
+         return line2.substr(TLE2_COL_MEANMOTION, TLE2_LEN_MEANMOTION);
+
+      case FLD_MMOTIONDT:
+         return ((line1[TLE1_COL_MEANMOTIONDT] == '-') ? "-0" : "0") +
+                line1.substr(TLE1_COL_MEANMOTIONDT + 1, TLE1_LEN_MEANMOTIONDT);
+
+      case FLD_MMOTIONDT2:
+         // decimal point assumed; exponential notation
+         return ExpToAtof(line1.substr(TLE1_COL_MEANMOTIONDT2,
+                                       TLE1_LEN_MEANMOTIONDT2));
+
+      case FLD_BSTAR:
+         // decimal point assumed; exponential notation
+         return ExpToAtof(line1.substr(TLE1_COL_BSTAR, TLE1_LEN_BSTAR));
+
+      default:
+         return string();
+   }
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -331,14 +535,19 @@ int cTle::CheckSum(const string& str)
 {
    // The length is "- 1" because we don't include the current (existing)
    // checksum character in the checksum calculation.
-   size_t len = str.size() - 1;
+   return CheckSum(str.data(), str.size() - 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+int cTle::CheckSum(const char *pLine, size_t len)
+{
    int xsum = 0;
    
    for (size_t i = 0; i < len; i++)
    {
-      char ch = str[i];
+      char ch = pLine[i];
 
-      if (isdigit(ch)) 
+      if ((ch >= '0') && (ch <= '9'))
       {
          xsum += (ch - '0');
       }
@@ -61,8 +61,27 @@ public:
       U_LAST            // MUST be last
    };
    
+   // The numeric fields of an element set in native units, indexed by
+   // eField. Decoded once; GetField() reads from here.
+   struct cElements
+   {
+      double m_Field[FLD_LAST];
+   };
+
+   // Decodes the numeric fields of the two data lines straight from their
+   // fixed columns, without allocating. The lines need not be terminated;
+   // columns past the end of a short line read as blank. Each value is
+   // identical to atof() of the field text.
+   static void Decode(const char *pLine1, size_t len1,
+                      const char *pLine2, size_t len2,
+                      cElements  &el);
+
    static bool IsValidLine(string&, eTleLine);
 
+   // Checksum of the first "len" characters of a data line: the digits
+   // summed, with each minus sign counting as one, modulo 10.
+   static int CheckSum(const char *pLine, size_t len);
+
    double GetField(eField fld,               // which field to retrieve
                    eUnits unit  = U_NATIVE,  // return units in rad, deg etc.
                    string *pstr = NULL,      // return ptr for str value
@@ -73,8 +92,10 @@ public:
    string Line1() const { return m_strLine1; }
    string Line2() const { return m_strLine2; }
 
+   const cElements& Elements() const { return m_Elements; }
+
 protected:
-   void Initialize();
+   string FieldText(eField fld) const;
 
    static string ExpToAtof(const string&);
    static double ConvertUnits(double val, eField fld, eUnits units);
@@ -91,13 +112,8 @@ private:
    string m_strLine1;
    string m_strLine2;
 
-   // Converted fields, in atof()-readable form
-   string m_Field[FLD_LAST];
-
-   // Cache of field values in "double" format
-   typedef int FldKey;
-   FldKey Key(eUnits u, eField f) const { return (u * 100) + f; }
-   mutable map<FldKey, double>  m_mapCache;
+   // Decoded field values
+   cElements m_Elements;
 };
 }
 }
@@ -0,0 +1,178 @@
+//
+// cTaskScheduler.cpp
+//
+#include "stdafx.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "cTaskScheduler.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+//////////////////////////////////////////////////////////////////////////////
+// One thread's queue. The number of tasks left and their estimated cost
+// are kept alongside, for thieves to read without taking the lock.
+struct cTaskQueue
+{
+   cTaskQueue() : m_Left(0), m_Cost(0.0) { }
+
+   // Called, under the lock, after a task of estimated cost "cost" has
+   // been added (cost > 0) or taken (cost < 0).
+   void Changed(double cost)
+   {
+      m_Left.store(m_Tasks.size());
+      m_Cost.store(m_Cost.load() + cost);
+   }
+
+   std::mutex          m_Mutex;
+   deque<size_t>       m_Tasks;
+   std::atomic<size_t> m_Left;
+   std::atomic<double> m_Cost;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+cTaskScheduler::cTaskScheduler(unsigned threads /* = 0 */) :
+   m_Threads(threads)
+{
+   if (m_Threads == 0)
+   {
+      m_Threads = max(1u, std::thread::hardware_concurrency());
+   }
+
+   m_Stats.m_Threads = 0;
+   m_Stats.m_Tasks   = 0;
+   m_Stats.m_Steals  = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Run()
+void cTaskScheduler::Run(const vector<double> &cost,
+                         const std::function<void(size_t, unsigned)> &fn)
+{
+   unsigned threads = (unsigned)max((size_t)1, min((size_t)m_Threads, cost.size()));
+
+   m_Stats.m_Threads = threads;
+   m_Stats.m_Tasks   = cost.size();
+   m_Stats.m_Steals  = 0;
+   m_Stats.m_BusyUs.assign(threads, 0);
+
+   // Largest first; equal costs keep their order.
+   vector<size_t> order(cost.size());
+
+   for (size_t task = 0; task < order.size(); task++)
+   {
+      order[task] = task;
+   }
+
+   stable_sort(order.begin(), order.end(),
+               [&cost](size_t a, size_t b) { return cost[a] > cost[b]; });
+
+   vector<cTaskQueue> queues(threads);
+
+   for (size_t i = 0; i < order.size(); i++)
+   {
+      cTaskQueue &queue = queues[i % threads];
+
+      queue.m_Tasks.push_back(order[i]);
+      queue.Changed(cost[order[i]]);
+   }
+
+   vector<size_t> steals(threads, 0);
+
+   auto worker = [&](unsigned thread)
+   {
+      for (;;)
+      {
+         size_t task   = 0;
+         bool   fFound = false;
+
+         {
+            cTaskQueue &own = queues[thread];
+            lock_guard<mutex> lock(own.m_Mutex);
+
+            if (!own.m_Tasks.empty())
+            {
+               task = own.m_Tasks.front();
+               own.m_Tasks.pop_front();
+               own.Changed(-cost[task]);
+               fFound = true;
+            }
+         }
+
+         // Steal from the queue with the most work left; the counts are
+         // read without the locks, so the choice is only a hint.
+         while (!fFound)
+         {
+            unsigned victim = thread;
+            double   most   = 0.0;
+
+            for (unsigned t = 0; t < threads; t++)
+            {
+               if ((t != thread) && (queues[t].m_Left.load() > 0) &&
+                   (queues[t].m_Cost.load() >= most))
+               {
+                  victim = t;
+                  most   = queues[t].m_Cost.load();
+               }
+            }
+
+            if (victim == thread)
+            {
+               break;
+            }
+
+            cTaskQueue &other = queues[victim];
+            lock_guard<mutex> lock(other.m_Mutex);
+
+            if (!other.m_Tasks.empty())
+            {
+               task = other.m_Tasks.back();
+               other.m_Tasks.pop_back();
+               other.Changed(-cost[task]);
+               fFound = true;
+               steals[thread]++;
+            }
+         }
+
+         if (!fFound)
+         {
+            return;
+         }
+
+         std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+         fn(task, thread);
+
+         m_Stats.m_BusyUs[thread] += std::chrono::duration_cast<std::chrono::microseconds>(
+                                        std::chrono::steady_clock::now() - start).count();
+      }
+   };
+
+   vector<std::thread> workers;
+
+   for (unsigned t = 1; t < threads; t++)
+   {
+      workers.push_back(std::thread(worker, t));
+   }
+
+   worker(0);
+
+   for (size_t t = 0; t < workers.size(); t++)
+   {
+      workers[t].join();
+   }
+
+   for (unsigned t = 0; t < threads; t++)
+   {
+      m_Stats.m_Steals += steals[t];
+   }
+}
+}
+}
@@ -0,0 +1,60 @@
+//
+// cTaskScheduler.h
+//
+// This class runs a set of independent tasks of uneven, roughly known cost
+// on a fixed number of threads, balancing the load by work stealing.
+//
+// The tasks are dealt out largest first, round robin, into one queue per
+// thread (so each thread starts with a similar share of the estimated
+// cost). A thread takes tasks from the front of its own queue; when that
+// is empty it steals from the back of the queue with the most estimated
+// cost left. Estimates only need to be right in proportion: a thread that
+// was dealt more than its share is relieved by the others near the end.
+//
+// Each queue has its own lock, held only to take a task, so threads only
+// contend when stealing.
+//
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+//////////////////////////////////////////////////////////////////////////////
+class cTaskScheduler
+{
+public:
+   // Outcome of the last Run()
+   struct cStats
+   {
+      unsigned         m_Threads;
+      size_t           m_Tasks;
+      size_t           m_Steals;     // tasks run by a thread they were not dealt to
+      vector<int64_t>  m_BusyUs;     // per thread, time spent in tasks
+   };
+
+   // "threads" of 0 uses one per hardware thread.
+   explicit cTaskScheduler(unsigned threads = 0);
+
+   // Calls fn(task, thread) once for each task in [0, cost.size()), on up
+   // to Threads() threads (thread in [0, Threads())), and waits for them
+   // all. cost[task] is the task's estimated cost in any unit. With one
+   // thread, the tasks run on the calling thread.
+   void Run(const vector<double> &cost,
+            const std::function<void(size_t, unsigned)> &fn);
+
+   unsigned Threads() const { return m_Threads; }
+
+   const cStats& Stats() const { return m_Stats; }
+
+protected:
+   unsigned m_Threads;
+   cStats   m_Stats;
+};
+}
+}
@@ -0,0 +1,420 @@
+//
+// cTleCatalog.cpp
+//
+#include "stdafx.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "cTleCatalog.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+// Length of a data line, and the columns of the satellite number
+static const size_t CAT_LEN_LINE_DATA  = 69;
+static const size_t CAT_COL_SATNUM     = 2;
+static const size_t CAT_LEN_SATNUM     = 5;
+
+// Fewest records worth giving a thread of their own
+static const size_t CAT_MIN_PER_THREAD = 2048;
+
+//////////////////////////////////////////////////////////////////////////////
+// ForEachChunk()
+// Calls fn(first, last) for consecutive chunks of [0, count), on up to
+// "threads" threads, and waits for them all.
+template <class FN>
+static void ForEachChunk(size_t count, unsigned threads, FN fn)
+{
+   if (threads == 0)
+   {
+      threads = max(1u, std::thread::hardware_concurrency());
+   }
+
+   size_t chunks = min((size_t)threads, max((size_t)1, count / CAT_MIN_PER_THREAD));
+
+   if (chunks <= 1)
+   {
+      fn((size_t)0, count);
+      return;
+   }
+
+   vector<std::thread> workers;
+
+   for (size_t c = 1; c < chunks; c++)
+   {
+      workers.push_back(std::thread(fn, count * c / chunks, count * (c + 1) / chunks));
+   }
+
+   fn((size_t)0, count / chunks);
+
+   for (size_t c = 0; c < workers.size(); c++)
+   {
+      workers[c].join();
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+static bool IsDataLine(const char *p, size_t len, char number)
+{
+   return (len >= 2) && (p[0] == number) && (p[1] == ' ');
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cTleCatalog::cTleCatalog()
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Load()
+bool cTleCatalog::Load(const string &path, unsigned threads /* = 0 */)
+{
+   Clear();
+
+   if (!m_File.Open(path))
+   {
+      return false;
+   }
+
+   Parse(m_File.Data(), m_File.Size(), threads);
+
+   return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Clear()
+void cTleCatalog::Clear()
+{
+   m_Records.clear();
+   m_NoradId.clear();
+   m_Index.clear();
+   m_Errors.clear();
+
+   for (int fld = cTle::FLD_FIRST; fld < cTle::FLD_LAST; fld++)
+   {
+      m_Col[fld].clear();
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// AddError()
+void cTleCatalog::AddError(size_t line, eError code)
+{
+   cError err = { line, code };
+
+   m_Errors.push_back(err);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Split()
+// Divides the text into candidate records. Lines are trimmed of trailing
+// blanks and carriage returns; data lines are only checked for their
+// "1 " / "2 " prefix here.
+void cTleCatalog::Split(const char *pText, size_t cbText,
+                        vector<cRecord> &records)
+{
+   const char *pEnd = pText + cbText;
+
+   cRecord rec      = { NULL, NULL, NULL, 0, 0, 0, 0 };
+   size_t  lineName = 0;
+
+   for (size_t line = 1; pText < pEnd; line++)
+   {
+      const char *pEol = (const char *)memchr(pText, '\n', pEnd - pText);
+
+      if (pEol == NULL)
+      {
+         pEol = pEnd;
+      }
+
+      const char *p   = pText;
+      size_t      len = pEol - pText;
+
+      pText = (pEol < pEnd) ? pEol + 1 : pEnd;
+
+      while ((len > 0) && ((p[len - 1] == ' ') || (p[len - 1] == '\r')))
+      {
+         len--;
+      }
+
+      if (len == 0)
+      {
+         continue;
+      }
+
+      if (IsDataLine(p, len, '1'))
+      {
+         if (rec.m_pLine1)
+         {
+            AddError(rec.m_Line, ERR_NO_LINE2);
+            rec.m_pName = NULL;
+         }
+
+         rec.m_pLine1   = p;
+         rec.m_lenLine1 = len;
+         rec.m_Line     = line;
+      }
+      else if (IsDataLine(p, len, '2') && rec.m_pLine1)
+      {
+         rec.m_pLine2   = p;
+         rec.m_lenLine2 = len;
+         records.push_back(rec);
+
+         rec.m_pName  = NULL;
+         rec.m_pLine1 = NULL;
+      }
+      else
+      {
+         if (rec.m_pLine1)
+         {
+            AddError(rec.m_Line, ERR_NO_LINE2);
+            rec.m_pLine1 = NULL;
+            rec.m_pName  = NULL;
+         }
+
+         if (rec.m_pName)
+         {
+            AddError(lineName, ERR_STRAY_LINE);
+            rec.m_pName = NULL;
+         }
+
+         if (IsDataLine(p, len, '2'))
+         {
+            AddError(line, ERR_STRAY_LINE);
+            continue;
+         }
+
+         // Name line; some catalogs prefix it with "0 "
+         if (IsDataLine(p, len, '0'))
+         {
+            p   += 2;
+            len -= 2;
+         }
+
+         rec.m_pName   = p;
+         rec.m_lenName = len;
+         lineName      = line;
+      }
+   }
+
+   if (rec.m_pLine1)
+   {
+      AddError(rec.m_Line, ERR_NO_LINE2);
+   }
+   else if (rec.m_pName)
+   {
+      AddError(lineName, ERR_STRAY_LINE);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Validate()
+// Checks the layout and checksums of both data lines, and that they name
+// the same satellite.
+bool cTleCatalog::Validate(const cRecord &rec, eError *pCode)
+{
+   const char *pLines[2] = { rec.m_pLine1,   rec.m_pLine2   };
+   const size_t lens[2]  = { rec.m_lenLine1, rec.m_lenLine2 };
+   const eError fmt[2]   = { ERR_LINE1_FORMAT,   ERR_LINE2_FORMAT   };
+   const eError xsum[2]  = { ERR_LINE1_CHECKSUM, ERR_LINE2_CHECKSUM };
+
+   for (int i = 0; i < 2; i++)
+   {
+      const char *p = pLines[i];
+
+      if ((lens[i] != CAT_LEN_LINE_DATA) || (p[CAT_COL_SATNUM - 1] != ' '))
+      {
+         *pCode = fmt[i];
+         return false;
+      }
+
+      char ch = p[CAT_LEN_LINE_DATA - 1];
+
+      if ((ch < '0') || (ch > '9') ||
+          (cTle::CheckSum(p, CAT_LEN_LINE_DATA - 1) != (ch - '0')))
+      {
+         *pCode = xsum[i];
+         return false;
+      }
+   }
+
+   if (memcmp(rec.m_pLine1 + CAT_COL_SATNUM,
+              rec.m_pLine2 + CAT_COL_SATNUM, CAT_LEN_SATNUM) != 0)
+   {
+      *pCode = ERR_SATNUM_MISMATCH;
+      return false;
+   }
+
+   return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Parse()
+void cTleCatalog::Parse(const char *pText, size_t cbText,
+                        unsigned threads /* = 0 */)
+{
+   if (pText != m_File.Data())
+   {
+      m_File.Close();
+   }
+
+   Clear();
+
+   vector<cRecord> records;
+
+   Split(pText, cbText, records);
+
+   // Validate in parallel, then decode the good records straight into
+   // their rows. Each thread writes only to its own range.
+   size_t count = records.size();
+   vector<unsigned char> valid(count);
+   vector<unsigned char> code (count);
+
+   ForEachChunk(count, threads, [&](size_t first, size_t last)
+   {
+      for (size_t i = first; i < last; i++)
+      {
+         eError err = ERR_NO_LINE2;
+
+         valid[i] = Validate(records[i], &err);
+         code [i] = (unsigned char)err;
+      }
+   });
+
+   vector<size_t> row(count);
+   size_t rows = 0;
+
+   for (size_t i = 0; i < count; i++)
+   {
+      if (valid[i])
+      {
+         row[i] = rows++;
+      }
+      else
+      {
+         AddError(records[i].m_Line, (eError)code[i]);
+      }
+   }
+
+   m_Records.resize(rows);
+   m_NoradId.resize(rows);
+
+   for (int fld = cTle::FLD_FIRST; fld < cTle::FLD_LAST; fld++)
+   {
+      m_Col[fld].resize(rows);
+   }
+
+   ForEachChunk(count, threads, [&](size_t first, size_t last)
+   {
+      cTle::cElements el;
+
+      for (size_t i = first; i < last; i++)
+      {
+         if (!valid[i])
+         {
+            continue;
+         }
+
+         const cRecord &rec = records[i];
+
+         cTle::Decode(rec.m_pLine1, CAT_LEN_LINE_DATA,
+                      rec.m_pLine2, CAT_LEN_LINE_DATA, el);
+
+         for (int fld = cTle::FLD_FIRST; fld < cTle::FLD_LAST; fld++)
+         {
+            m_Col[fld][row[i]] = el.m_Field[fld];
+         }
+
+         m_Records[row[i]] = rec;
+         m_NoradId[row[i]] = (int)el.m_Field[cTle::FLD_NORADNUM];
+      }
+   });
+
+   // NORAD index; equal numbers stay in record order
+   m_Index.resize(rows);
+
+   for (size_t r = 0; r < rows; r++)
+   {
+      m_Index[r] = make_pair(m_NoradId[r], r);
+   }
+
+   sort(m_Index.begin(), m_Index.end());
+
+   for (size_t k = 1; k < m_Index.size(); k++)
+   {
+      if (m_Index[k].first == m_Index[k - 1].first)
+      {
+         AddError(m_Records[m_Index[k].second].m_Line, ERR_DUPLICATE_ID);
+      }
+   }
+
+   stable_sort(m_Errors.begin(), m_Errors.end(),
+               [](const cError &a, const cError &b) { return a.m_Line < b.m_Line; });
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Find()
+size_t cTleCatalog::Find(int noradId) const
+{
+   vector<pair<int, size_t> >::const_iterator it =
+      lower_bound(m_Index.begin(), m_Index.end(), make_pair(noradId, (size_t)0));
+
+   if ((it == m_Index.end()) || (it->first != noradId))
+   {
+      return NOT_FOUND;
+   }
+
+   return it->second;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+string cTleCatalog::Name(size_t i) const
+{
+   const cRecord &rec = m_Records[i];
+
+   return rec.m_pName ? string(rec.m_pName, rec.m_lenName) : string();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+string cTleCatalog::Line1(size_t i) const
+{
+   return string(m_Records[i].m_pLine1, CAT_LEN_LINE_DATA);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+string cTleCatalog::Line2(size_t i) const
+{
+   return string(m_Records[i].m_pLine2, CAT_LEN_LINE_DATA);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Tle()
+cTle cTleCatalog::Tle(size_t i) const
+{
+   string name  = Name(i);
+   string line1 = Line1(i);
+   string line2 = Line2(i);
+
+   return cTle(name, line1, line2);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// ErrorText()
+const char* cTleCatalog::ErrorText(eError code)
+{
+   switch (code)
+   {
+      case ERR_NO_LINE2:        return "line 1 without line 2";
+      case ERR_STRAY_LINE:      return "line outside any record";
+      case ERR_LINE1_FORMAT:    return "line 1 malformed";
+      case ERR_LINE2_FORMAT:    return "line 2 malformed";
+      case ERR_LINE1_CHECKSUM:  return "line 1 checksum mismatch";
+      case ERR_LINE2_CHECKSUM:  return "line 2 checksum mismatch";
+      case ERR_SATNUM_MISMATCH: return "lines 1 and 2 name different satellites";
+      case ERR_DUPLICATE_ID:    return "duplicate NORAD number";
+      default:                  return "unknown error";
+   }
+}
+}
+}
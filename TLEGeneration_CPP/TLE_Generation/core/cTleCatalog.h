@@ -0,0 +1,116 @@
+//
+// cTleCatalog.h
+//
+// This class loads a catalog of element sets, such as a CelesTrak 3LE or
+// 2LE file, into a structure of arrays: one column per numeric cTle field,
+// one row per record. The file is memory mapped and split into records in
+// a single pass; the records are then validated and decoded with
+// cTle::Decode() on several threads.
+//
+// A record is a "1 ..." line followed by a "2 ..." line, optionally
+// preceded by a name line (a leading "0 " on the name is dropped). Blank
+// lines are ignored. Records that fail validation are left out of the
+// table and reported by Errors().
+//
+// Names and line text are views into the loaded text, which the catalog
+// keeps mapped (or, for Parse(), which the caller keeps alive).
+//
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "cMappedFile.h"
+#include "cTle.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+//////////////////////////////////////////////////////////////////////////////
+class cTleCatalog
+{
+public:
+   enum eError
+   {
+      ERR_NO_LINE2,       // line 1 not followed by line 2
+      ERR_STRAY_LINE,     // name or line 2 that is not part of a record
+      ERR_LINE1_FORMAT,   // wrong length or layout
+      ERR_LINE2_FORMAT,
+      ERR_LINE1_CHECKSUM,
+      ERR_LINE2_CHECKSUM,
+      ERR_SATNUM_MISMATCH,// lines 1 and 2 name different satellites
+      ERR_DUPLICATE_ID    // kept in the table; Find() returns the first
+   };
+
+   struct cError
+   {
+      size_t m_Line;      // 1-based line number in the text
+      eError m_Code;
+   };
+
+   static const size_t NOT_FOUND = (size_t)-1;
+
+   cTleCatalog();
+
+   // Maps and parses the file. Returns false if it cannot be read.
+   // "threads" of 0 uses one per hardware thread.
+   bool Load(const string &path, unsigned threads = 0);
+
+   // Parses text held by the caller, who must keep it alive for as long
+   // as Name(), Line1(), Line2() or Tle() are used.
+   void Parse(const char *pText, size_t cbText, unsigned threads = 0);
+
+   size_t Size() const { return m_Records.size(); }
+
+   // Field values in native units (as cTle::GetField()), Size() entries.
+   const double* Column(cTle::eField fld) const { return m_Col[fld].data(); }
+
+   int    NoradId(size_t i) const { return m_NoradId[i]; }
+   string Name   (size_t i) const;
+   string Line1  (size_t i) const;
+   string Line2  (size_t i) const;
+
+   // The record as a cTle, e.g. to construct a cOrbit.
+   cTle Tle(size_t i) const;
+
+   // Index of the record with the given NORAD number, or NOT_FOUND.
+   size_t Find(int noradId) const;
+
+   // Problems found, in line order.
+   const vector<cError>& Errors() const { return m_Errors; }
+
+   static const char* ErrorText(eError code);
+
+protected:
+   struct cRecord
+   {
+      const char *m_pName;
+      const char *m_pLine1;
+      const char *m_pLine2;
+      size_t      m_lenName;
+      size_t      m_lenLine1;   // trimmed lengths
+      size_t      m_lenLine2;
+      size_t      m_Line;       // line number of line 1
+   };
+
+   void Clear();
+   void Split(const char *pText, size_t cbText, vector<cRecord> &records);
+   void AddError(size_t line, eError code);
+
+   static bool Validate(const cRecord &rec, eError *pCode);
+
+   cMappedFile m_File;
+
+   vector<cRecord> m_Records;
+   vector<double>  m_Col[cTle::FLD_LAST];
+   vector<int>     m_NoradId;
+
+   // (NORAD number, record index), sorted
+   vector<pair<int, size_t> > m_Index;
+
+   vector<cError> m_Errors;
+};
+}
+}
@@ -89,6 +89,18 @@ protected:
                         // Negative value means "towards observer"
 };
 
+//////////////////////////////////////////////////////////////////////
+// struct cTopoArrays
+// Caller-owned, structure-of-arrays topocentric buffers used by the batch
+// look-angle methods (see cSite). Units as cTopo.
+struct cTopoArrays
+{
+   double *m_Az;
+   double *m_El;
+   double *m_Range;
+   double *m_RangeRate;
+};
+
 //////////////////////////////////////////////////////////////////////
 // Topocentric-Horizon coordinates and associated time
 class cTopoTime : public cTopo
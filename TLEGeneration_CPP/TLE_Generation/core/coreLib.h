@@ -13,9 +13,13 @@ using namespace std;
 
 #include "cJulian.h"
 #include "cEci.h"
+#include "cGmstGrid.h"
+#include "cLookAngleTable.h"
 #include "coord.h"
 #include "cSite.h"
+#include "cTaskScheduler.h"
 #include "cTle.h"
+#include "cTleCatalog.h"
 #include "cVector.h"
 #include "exceptions.h"
 
@@ -0,0 +1,396 @@
+//
+// lookAngleManifest.cpp
+//
+// Jobs of one satellite that share a start time and resolution share one
+// grid, counted in integer milliseconds from the satellite's TLE epoch as
+// in a single run (see EpochSampleClock()), so they are run together, as
+// the sites of one cLookAngleEngine: each grid point is propagated once
+// for all of them, up to the latest end, and each job's output stops at
+// its own end. These groups are the tasks of a cTaskScheduler, weighted
+// like the engine's chunks by grid points times the per-point cost of
+// the satellite and its sites.
+//
+#include "stdafx.h"
+
+#include <stdio.h>
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+#include "coreLib.h"
+#include "orbitLib.h"
+
+#include "lookAngleManifest.h"
+#include "lookAngleMatrix.h"
+#include "lookAngleRowWriter.h"
+#include "sampleClock.h"
+
+// Per-point cost of one site's look angle, in SGP4 propagations (as in
+// cLookAngleEngine)
+static const double MANIFEST_COST_SITE = 0.25;
+
+struct ManifestJob {
+    ManifestJob() : sat(0), site(0), clock(0u, 0, 0), sampleCount(0) {}
+
+    size_t sat;                      // catalog index
+    size_t site;                     // site list index
+    SampleClock clock;               // the job's samples (see EpochSampleClock())
+    uint32_t sampleCount;
+    std::string outputFilename;
+};
+
+// Jobs of one satellite on one grid
+struct JobGroup {
+    JobGroup(size_t sat, const SampleClock& clock) : sat(sat), clock(clock), sampleCount(0) {}
+
+    size_t sat;
+    SampleClock clock;
+    uint32_t sampleCount;            // the longest job's
+    std::vector<size_t> jobs;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Writes the visible rows of each job of a group to the job's file. The
+// group's engine runs on one thread, so the sink needs no locking.
+class JobGroupSink : public cLookAngleSink
+{
+public:
+    JobGroupSink(const JobGroup& group, const std::vector<ManifestJob>& jobs,
+                 uint8_t decimalCount)
+        : m_Group(group), m_Jobs(jobs), m_DecimalCount(decimalCount),
+          m_Clock(group.clock),
+          m_Files(group.jobs.size(), (QFile*)NULL),
+          m_Writers(group.jobs.size(), (LookAngleRowWriter*)NULL),
+          m_fFailedAtStart(false), m_Rows(0), m_Failed(0), m_WriteFailed(0)
+    {
+    }
+
+    ~JobGroupSink()
+    {
+        CloseFiles();
+    }
+
+    // "site" is the job's index in the group.
+    virtual void Write(size_t /*sat*/, size_t site, size_t first, size_t count,
+                       const cTopoArrays& topo)
+    {
+        const ManifestJob& job = Job(site);
+        if(first >= job.sampleCount){
+            return;
+        }
+        count = std::min<size_t>(count, job.sampleCount - first);
+
+        LookAngleRowWriter* pRows = OpenFile(site);
+        if(pRows == NULL){
+            return;
+        }
+
+        for(size_t ix = 0; ix < count; ++ix){
+            double azDeg = rad2deg(topo.m_Az[ix]);
+            double elDeg = rad2deg(topo.m_El[ix]);
+            if(azDeg >= 0 && elDeg >= 0){
+                pRows->WriteRow(m_Clock.MsecOfDayAt(first + ix), azDeg, elDeg);
+                ++m_Rows;
+            }
+        }
+    }
+
+    // As in a SITE_LIST run, a job with no visible samples still gets a
+    // file with the header, unless the satellite failed at the first
+    // sample.
+    virtual void SatelliteDone(size_t /*sat*/)
+    {
+        if(!m_fFailedAtStart){
+            for(size_t ix = 0; ix < m_Group.jobs.size(); ++ix){
+                OpenFile(ix);
+            }
+        }
+        CloseFiles();
+    }
+
+    // Only the jobs that end after "first" are cut short.
+    virtual void SatelliteFailed(size_t /*sat*/, size_t first, const string& message)
+    {
+        m_fFailedAtStart = (first == 0);
+        for(size_t ix = 0; ix < m_Group.jobs.size(); ++ix){
+            const ManifestJob& job = Job(ix);
+            if(first < job.sampleCount){
+                qDebug()<<"Job"<<m_Group.jobs[ix] + 1<<"stopped at sample"<<first<<":"<<message.c_str();
+                ++m_Failed;
+            }
+        }
+    }
+
+    size_t Rows() const { return m_Rows; }
+    size_t Failed() const { return m_Failed; }
+
+    // Jobs whose file could not be written completely
+    size_t WriteFailed() const { return m_WriteFailed; }
+
+private:
+    const ManifestJob& Job(size_t ix) const { return m_Jobs[m_Group.jobs[ix]]; }
+
+    LookAngleRowWriter* OpenFile(size_t ix)
+    {
+        if(m_Files[ix] == NULL){
+            const std::string& path = Job(ix).outputFilename;
+            QFile* pFile = new QFile(QString(path.c_str()));
+            if(!pFile->open(QIODevice::WriteOnly | QIODevice::Text)){
+                qDebug()<<"Could not open"<<path.c_str()<<"for writing.";
+                delete pFile;
+                return NULL;
+            }
+            m_Files[ix] = pFile;
+            m_Writers[ix] = new LookAngleRowWriter(pFile, m_DecimalCount, SINK_BUFFER_SIZE);
+            m_Writers[ix]->WriteText("HH mm ss.zzz Longitude Latitude\n");
+        }
+        return m_Writers[ix];
+    }
+
+    void CloseFiles()
+    {
+        for(size_t ix = 0; ix < m_Files.size(); ++ix){
+            if(m_Files[ix] == NULL){
+                continue;
+            }
+            if(!m_Writers[ix]->Close() || !m_Files[ix]->flush()){
+                qDebug()<<"Could not write"<<Job(ix).outputFilename.c_str();
+                ++m_WriteFailed;
+            }
+            delete m_Writers[ix];
+            delete m_Files[ix];
+            m_Writers[ix] = NULL;
+            m_Files[ix] = NULL;
+        }
+    }
+
+    // Per open file; a group has one open for each job.
+    static const size_t SINK_BUFFER_SIZE = 256 * 1024;
+
+    const JobGroup& m_Group;
+    const std::vector<ManifestJob>& m_Jobs;
+    uint8_t m_DecimalCount;
+    SampleClock m_Clock;
+    std::vector<QFile*> m_Files;
+    std::vector<LookAngleRowWriter*> m_Writers;
+    bool m_fFailedAtStart;
+    size_t m_Rows;
+    size_t m_Failed;
+    size_t m_WriteFailed;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Parses "NORAD,SITE,START,END,RESOLUTION_MS,OUTPUT" into "job".
+static bool parseJob(const QString& value, const cTleCatalog& catalog,
+                     const std::map<std::string, size_t>& siteIndex,
+                     ManifestJob& job)
+{
+    auto parts = value.split(",");
+    if(parts.size() != 6){
+        return false;
+    }
+
+    bool okId = false, okResolution = false;
+    int noradId = parts[0].trimmed().toInt(&okId);
+    job.sat = catalog.Find(noradId);
+    if(!okId || job.sat == cTleCatalog::NOT_FOUND){
+        qDebug()<<"NORAD ID"<<parts[0].trimmed().toStdString().c_str()<<"not in catalog";
+        return false;
+    }
+
+    auto site = siteIndex.find(parts[1].trimmed().toStdString());
+    if(site == siteIndex.end()){
+        qDebug()<<"Site"<<parts[1].trimmed().toStdString().c_str()<<"not in site list";
+        return false;
+    }
+    job.site = site->second;
+
+    QDateTime startTime = QDateTime::fromString(parts[2].trimmed(), "yyyy-MM-dd HH:mm:ss");
+    QDateTime endTime = QDateTime::fromString(parts[3].trimmed(), "yyyy-MM-dd HH:mm:ss");
+    uint32_t timeResolutionMs = parts[4].trimmed().toUInt(&okResolution);
+    job.outputFilename = parts[5].trimmed().toStdString();
+    if(!startTime.isValid() || !endTime.isValid() || !okResolution ||
+       timeResolutionMs == 0 || job.outputFilename.empty()){
+        return false;
+    }
+
+    // Sample ix is taken at start + ix*resolution, up to but not including
+    // the end, with the start moved up to the TLE epoch if earlier.
+    job.clock = EpochSampleClock(catalog.Line1(job.sat), startTime, endTime,
+                                 timeResolutionMs, job.sampleCount);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+int RunLookAngleManifest(const std::string& path)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(QString(path.c_str()));
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)){
+        qDebug()<<"Cannot open manifest"<<path.c_str();
+        return -1;
+    }
+
+    // Settings first, jobs after: the jobs refer to the catalog and sites.
+    std::map<QString, QString> kv;
+    std::vector<QString> jobLines;
+    QTextStream in(&file);
+    while(!in.atEnd()){
+        QString line = in.readLine().trimmed();
+        if(line.isEmpty() || line.startsWith("#")) continue;
+        int eq = line.indexOf("=");
+        if(eq < 0){
+            qDebug()<<"Invalid manifest line"<<line.toStdString().c_str();
+            return -1;
+        }
+        QString key = line.left(eq).trimmed();
+        QString value = line.mid(eq + 1).trimmed();
+        if(key == "JOB"){
+            jobLines.push_back(value);
+        }else{
+            kv[key] = value;
+        }
+    }
+
+    isAtmosphericCorrectionRequired = (kv["ATMOSPHERIC_CORRECTION"] == "1");
+    uint8_t decimalCount = kv["DECIMAL_COUNT"].toUInt();
+    unsigned threads = kv["THREADS"].toUInt();
+
+    cTleCatalog catalog;
+    if(!catalog.Load(kv["TLE_CATALOG"].toStdString())){
+        qDebug()<<"Cannot open TLE catalog"<<kv["TLE_CATALOG"].toStdString().c_str();
+        return -1;
+    }
+
+    std::vector<cSite> sites;
+    std::vector<std::string> siteNames;
+    if(!LoadSites(kv["SITE_LIST"].toStdString(), sites, siteNames)){
+        return -1;
+    }
+    std::map<std::string, size_t> siteIndex;
+    for(size_t ix = 0; ix < siteNames.size(); ++ix){
+        siteIndex[siteNames[ix]] = ix;
+    }
+
+    // Jobs, grouped by satellite, start time and resolution. Two jobs
+    // writing the same file is an error in the manifest, not a race to
+    // leave to the file system.
+    std::vector<ManifestJob> jobs(jobLines.size());
+    std::vector<JobGroup> groups;
+    std::map<std::tuple<size_t, int64_t, uint32_t>, size_t> groupIndex;
+    std::set<std::string> outputs;
+    for(size_t ix = 0; ix < jobLines.size(); ++ix){
+        ManifestJob& job = jobs[ix];
+        if(!parseJob(jobLines[ix], catalog, siteIndex, job)){
+            qDebug()<<"Invalid job"<<ix + 1<<":"<<jobLines[ix].toStdString().c_str();
+            return -1;
+        }
+        if(!outputs.insert(job.outputFilename).second){
+            qDebug()<<"Job"<<ix + 1<<"writes"<<job.outputFilename.c_str()<<"as well as an earlier job";
+            return -1;
+        }
+
+        auto key = std::make_tuple(job.sat, job.clock.Tick(0), job.clock.StepMs());
+        auto found = groupIndex.find(key);
+        if(found == groupIndex.end()){
+            found = groupIndex.insert(std::make_pair(key, groups.size())).first;
+            groups.push_back(JobGroup(job.sat, job.clock));
+        }
+        JobGroup& group = groups[found->second];
+        group.jobs.push_back(ix);
+        group.sampleCount = std::max(group.sampleCount, job.sampleCount);
+    }
+
+    // Each satellite is initialized once, whatever number of groups it is in.
+    std::map<size_t, cSatellite*> sats;
+    size_t failed = 0;
+    for(size_t ix = 0; ix < groups.size(); ++ix){
+        if(sats.count(groups[ix].sat)){
+            continue;
+        }
+        cSatellite* pSat = NULL;
+        try{
+            pSat = new cSatellite(catalog.Tle(groups[ix].sat));
+        }catch(cPropagationException& e){
+            qDebug()<<"Skipping NORAD ID"<<catalog.NoradId(groups[ix].sat)<<":"<<e.Message().c_str();
+        }
+        sats[groups[ix].sat] = pSat;
+    }
+
+    std::vector<double> cost(groups.size(), 0.0);
+    for(size_t ix = 0; ix < groups.size(); ++ix){
+        const cSatellite* pSat = sats[groups[ix].sat];
+        if(pSat == NULL){
+            failed += groups[ix].jobs.size();
+            continue;
+        }
+        cost[ix] = double(groups[ix].sampleCount) *
+                   (cLookAngleEngine::PropagationCost(*pSat) +
+                    MANIFEST_COST_SITE * groups[ix].jobs.size());
+    }
+
+    std::vector<size_t> groupRows(groups.size(), 0);
+    std::vector<size_t> groupFailed(groups.size(), 0);
+    std::vector<size_t> groupWriteFailed(groups.size(), 0);
+
+    cTaskScheduler scheduler(threads);
+    scheduler.Run(cost, [&](size_t ix, unsigned /*thread*/){
+        const JobGroup& group = groups[ix];
+        const cSatellite* pSat = sats[group.sat];
+        if(pSat == NULL){
+            return;
+        }
+
+        // Only visible rows are written, so samples below the horizon need
+        // no look-angle evaluation.
+        cLookAngleEngine engine;
+        engine.SetVisibleOnly(true);
+        engine.AddSatellite(*pSat, group.clock.Tick(0), group.clock.StepMs(), group.sampleCount);
+        for(size_t job = 0; job < group.jobs.size(); ++job){
+            engine.AddSite(sites[jobs[group.jobs[job]].site]);
+        }
+
+        JobGroupSink sink(group, jobs, decimalCount);
+        engine.Run(sink);
+        groupRows[ix] = sink.Rows();
+        groupFailed[ix] = sink.Failed();
+        groupWriteFailed[ix] = sink.WriteFailed();
+    });
+
+    size_t rows = 0;
+    size_t writeFailed = 0;
+    for(size_t ix = 0; ix < groups.size(); ++ix){
+        rows += groupRows[ix];
+        failed += groupFailed[ix];
+        writeFailed += groupWriteFailed[ix];
+    }
+
+    qDebug()<<jobs.size()<<"jobs in"<<groups.size()<<"propagation groups of"<<sats.size()<<"satellites:"
+           <<rows<<"visible rows,"<<failed<<"jobs failed,"<<writeFailed<<"files not written, in"
+           <<timer.elapsed()<<"ms";
+
+    const cTaskScheduler::cStats& stats = scheduler.Stats();
+    if(!stats.m_BusyUs.empty()){
+        int64_t busiest = *std::max_element(stats.m_BusyUs.begin(), stats.m_BusyUs.end());
+        int64_t idlest = *std::min_element(stats.m_BusyUs.begin(), stats.m_BusyUs.end());
+        qDebug()<<stats.m_Tasks<<"groups on"<<stats.m_Threads<<"threads,"<<stats.m_Steals<<"stolen;"
+               <<"busiest thread"<<busiest / 1000<<"ms, least busy"<<idlest / 1000<<"ms";
+    }
+
+    for(auto it = sats.begin(); it != sats.end(); ++it){
+        delete it->second;
+    }
+
+    if(writeFailed > 0){
+        return -1;
+    }
+    qDebug()<<"Completed";
+    return 0;
+}
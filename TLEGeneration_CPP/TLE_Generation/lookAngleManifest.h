@@ -0,0 +1,28 @@
+//
+// lookAngleManifest.h
+//
+// Many look-angle jobs in one process: "TLE_Generation --manifest <file>"
+// loads a TLE catalog and a site list once and runs every job listed in
+// the manifest file against them:
+//
+//   TLE_CATALOG=../catalog.txt
+//   SITE_LIST=../sites.txt          (see LoadSites())
+//   DECIMAL_COUNT=2
+//   ATMOSPHERIC_CORRECTION=1
+//   THREADS=0                       (0 = one per hardware thread)
+//   JOB=<NORAD id>,<site>,<start>,<end>,<resolution ms>,<output file>
+//   JOB=...
+//
+// Start and end are "yyyy-MM-dd HH:mm:ss", as in the configuration file;
+// the sites are named as in the site list. Each job's file holds the rows
+// a single run of the pair over the job's times writes, as the pair's
+// file from a SITE_LIST run does (see CheckLookAngleMatrix()): samples at
+// or above the horizon, with the start moved up to the TLE epoch if
+// earlier.
+//
+#pragma once
+
+#include <string>
+
+// Runs the jobs of the manifest file. Returns the process exit code.
+int RunLookAngleManifest(const std::string& path);
@@ -0,0 +1,464 @@
+//
+// lookAngleMatrix.cpp
+//
+// The satellites come from TLE_CATALOG (all entries, or those listed in
+// TLE_NORAD_IDS), or are the single configured TLE; the sites from the
+// SITE_LIST file. Every satellite is propagated once per sample for all
+// sites, and each (satellite, site) pair gets its own output file with
+// the rows main writes for a single pair: samples at or above the
+// horizon. Each satellite's samples are counted in integer milliseconds
+// from its TLE epoch, with the start moved up to the epoch if earlier, as
+// in the single run (see EpochSampleClock()); CheckLookAngleMatrix()
+// confirms that the files match the single run byte for byte.
+//
+#include "stdafx.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+#include "coreLib.h"
+#include "orbitLib.h"
+
+#include "lookAngleMatrix.h"
+#include "lookAngleRowWriter.h"
+#include "sampleClock.h"
+#include "sampleShards.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// The output file of a pair: OUTPUT_FILENAME without its extension,
+// followed by "_<NORAD>_<SITE>.csv".
+static std::string PairPath(const LookAngleMatrixConfiguration& cfg,
+                            const std::string& satName, const std::string& siteName)
+{
+    std::string stem = cfg.outputFilename;
+    size_t dot = stem.rfind('.');
+    if(dot != std::string::npos && stem.find('/', dot) == std::string::npos){
+        stem.erase(dot);
+    }
+    return stem + "_" + satName + "_" + siteName + ".csv";
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Writes the visible rows of each (satellite, site) pair to its own file.
+// The files of a satellite are open only while it is being processed;
+// with several engine threads, several satellites are.
+class LookAngleFileSink : public cLookAngleSink
+{
+public:
+    LookAngleFileSink(const LookAngleMatrixConfiguration& cfg,
+                      const std::vector<SampleClock>& clocks,
+                      const std::vector<std::string>& satNames,
+                      const std::vector<std::string>& siteNames)
+        : m_Cfg(cfg), m_Clocks(clocks),
+          m_SatNames(satNames), m_SiteNames(siteNames),
+          m_Open(satNames.size(), (SatelliteFiles*)NULL), m_Rows(0), m_Failed(0),
+          m_WriteFailed(0)
+    {
+    }
+
+    ~LookAngleFileSink()
+    {
+        for(size_t sat = 0; sat < m_Open.size(); ++sat){
+            CloseFiles(sat);
+        }
+    }
+
+    virtual void Write(size_t sat, size_t site, size_t first, size_t count,
+                       const cTopoArrays& topo)
+    {
+        LookAngleRowWriter* pRows = OpenFile(sat, site);
+        if(pRows == NULL){
+            return;
+        }
+
+        const SampleClock& clock = m_Clocks[sat];
+        size_t rows = 0;
+        for(size_t ix = 0; ix < count; ++ix){
+            double azDeg = rad2deg(topo.m_Az[ix]);
+            double elDeg = rad2deg(topo.m_El[ix]);
+            if(azDeg >= 0 && elDeg >= 0){
+                pRows->WriteRow(clock.MsecOfDayAt(first + ix), azDeg, elDeg);
+                ++rows;
+            }
+        }
+        m_Rows += rows;
+    }
+
+    // The engine does not deliver blocks that visibility screening ruled
+    // out, so a pair may get no Write() at all; its file still gets the
+    // header, as it would have without screening, unless the satellite
+    // failed at the first sample.
+    virtual void SatelliteDone(size_t sat)
+    {
+        if(!Files(sat).fFailedAtStart){
+            for(size_t site = 0; site < m_SiteNames.size(); ++site){
+                OpenFile(sat, site);
+            }
+        }
+        CloseFiles(sat);
+    }
+
+    virtual void SatelliteFailed(size_t sat, size_t first, const string& message)
+    {
+        qDebug()<<"Satellite"<<m_SatNames[sat].c_str()<<"stopped at sample"<<first<<":"<<message.c_str();
+        Files(sat).fFailedAtStart = (first == 0);
+        ++m_Failed;
+    }
+
+    size_t Rows() const { return m_Rows; }
+    size_t Failed() const { return m_Failed; }
+
+    // Files that could not be written completely
+    size_t WriteFailed() const { return m_WriteFailed; }
+
+private:
+    // A satellite's open files, one per site
+    struct SatelliteFiles {
+        std::vector<QFile*> files;
+        std::vector<LookAngleRowWriter*> writers;
+        bool fFailedAtStart;
+    };
+
+    // The engine makes no two calls for one satellite at a time, so only
+    // m_Open itself needs the lock.
+    SatelliteFiles& Files(size_t sat)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if(m_Open[sat] == NULL){
+            m_Open[sat] = new SatelliteFiles;
+            m_Open[sat]->files.assign(m_SiteNames.size(), (QFile*)NULL);
+            m_Open[sat]->writers.assign(m_SiteNames.size(), (LookAngleRowWriter*)NULL);
+            m_Open[sat]->fFailedAtStart = false;
+        }
+        return *m_Open[sat];
+    }
+
+    LookAngleRowWriter* OpenFile(size_t sat, size_t site)
+    {
+        SatelliteFiles& open = Files(sat);
+        if(open.files[site] == NULL){
+            std::string path = PairPath(m_Cfg, m_SatNames[sat], m_SiteNames[site]);
+            QFile* pFile = new QFile(QString(path.c_str()));
+            if(!pFile->open(QIODevice::WriteOnly | QIODevice::Text)){
+                qDebug()<<"Could not open"<<path.c_str()<<"for writing.";
+                delete pFile;
+                return NULL;
+            }
+            open.files[site] = pFile;
+            open.writers[site] = new LookAngleRowWriter(pFile, m_Cfg.decimalCount, SINK_BUFFER_SIZE);
+            open.writers[site]->WriteText("HH mm ss.zzz Longitude Latitude\n");
+        }
+        return open.writers[site];
+    }
+
+    void CloseFiles(size_t sat)
+    {
+        SatelliteFiles* pOpen = NULL;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            std::swap(pOpen, m_Open[sat]);
+        }
+        if(pOpen){
+            for(size_t ix = 0; ix < pOpen->files.size(); ++ix){
+                if(pOpen->files[ix] == NULL){
+                    continue;
+                }
+                if(!pOpen->writers[ix]->Close() || !pOpen->files[ix]->flush()){
+                    qDebug()<<"Could not write"<<pOpen->files[ix]->fileName().toStdString().c_str();
+                    ++m_WriteFailed;
+                }
+                delete pOpen->writers[ix];
+                delete pOpen->files[ix];
+            }
+            delete pOpen;
+        }
+    }
+
+    // Per open file; a satellite has one open for each site.
+    static const size_t SINK_BUFFER_SIZE = 256 * 1024;
+
+    const LookAngleMatrixConfiguration& m_Cfg;
+    const std::vector<SampleClock>& m_Clocks;
+    const std::vector<std::string>& m_SatNames;
+    const std::vector<std::string>& m_SiteNames;
+    std::mutex m_Mutex;
+    std::vector<SatelliteFiles*> m_Open;
+    std::atomic<size_t> m_Rows;
+    std::atomic<size_t> m_Failed;
+    std::atomic<size_t> m_WriteFailed;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+bool LoadSites(const std::string& path, std::vector<cSite>& sites,
+               std::vector<std::string>& names)
+{
+    QFile file(QString(path.c_str()));
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)){
+        qDebug()<<"Cannot open site list"<<path.c_str();
+        return false;
+    }
+
+    QTextStream in(&file);
+    while(!in.atEnd()){
+        QString line = in.readLine().trimmed();
+        if(line.isEmpty() || line.startsWith("#")) continue;
+        auto parts = line.split(",");
+        bool okLat = false, okLon = false, okHeight = false;
+        if(parts.size() == 4){
+            double lat = parts[1].trimmed().toDouble(&okLat);
+            double lon = parts[2].trimmed().toDouble(&okLon);
+            double height = parts[3].trimmed().toDouble(&okHeight);
+            if(okLat && okLon && okHeight){
+                sites.push_back(cSite(lat, lon, height, parts[0].trimmed().toStdString()));
+                names.push_back(parts[0].trimmed().toStdString());
+                continue;
+            }
+        }
+        qDebug()<<"Invalid site list line"<<line.toStdString().c_str();
+        return false;
+    }
+
+    return !sites.empty();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The satellites of the configuration, named by NORAD number. Catalog
+// entries that cannot be initialized are skipped. Returns false, after
+// reporting it, if the catalog cannot be read.
+static bool LoadSatellites(const LookAngleMatrixConfiguration& cfg, std::vector<cSatellite*>& sats,
+                           std::vector<std::string>& satNames)
+{
+    cTleCatalog catalog;
+
+    if(!cfg.tleCatalog.empty()){
+        if(!catalog.Load(cfg.tleCatalog)){
+            qDebug()<<"Cannot open TLE catalog"<<cfg.tleCatalog.c_str();
+            return false;
+        }
+
+        std::vector<size_t> indices;
+        if(cfg.tleNoradIds.empty()){
+            for(size_t ix = 0; ix < catalog.Size(); ++ix){
+                indices.push_back(ix);
+            }
+        }else{
+            auto ids = QString(cfg.tleNoradIds.c_str()).split(",");
+            for(size_t ix = 0; ix < size_t(ids.size()); ++ix){
+                size_t index = catalog.Find(ids[ix].trimmed().toInt());
+                if(index == cTleCatalog::NOT_FOUND){
+                    qDebug()<<"NORAD ID"<<ids[ix].trimmed().toStdString().c_str()<<"not in catalog";
+                    continue;
+                }
+                indices.push_back(index);
+            }
+        }
+
+        for(size_t ix = 0; ix < indices.size(); ++ix){
+            try{
+                sats.push_back(new cSatellite(catalog.Tle(indices[ix])));
+                satNames.push_back(QString::number(catalog.NoradId(indices[ix])).toStdString());
+            }catch(cPropagationException& e){
+                qDebug()<<"Skipping NORAD ID"<<catalog.NoradId(indices[ix])<<":"<<e.Message().c_str();
+            }
+        }
+    }else{
+        std::string name = cfg.tleName, line1 = cfg.tleLine1, line2 = cfg.tleLine2;
+        cTle tle(name, line1, line2);
+        sats.push_back(new cSatellite(tle));
+        satNames.push_back(QString::number(int(tle.GetField(cTle::FLD_NORADNUM))).toStdString());
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+int RunLookAngleMatrix(const LookAngleMatrixConfiguration& cfg)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    std::vector<cSite> sites;
+    std::vector<std::string> siteNames;
+    if(!LoadSites(cfg.siteList, sites, siteNames)){
+        return -1;
+    }
+
+    // Satellites, named by NORAD number in the output file names
+    std::vector<cSatellite*> sats;
+    std::vector<std::string> satNames;
+    if(!LoadSatellites(cfg, sats, satNames)){
+        return -1;
+    }
+
+    // Each satellite's samples, as a single run of it takes them
+    std::vector<SampleClock> clocks;
+    std::vector<uint32_t> sampleCounts;
+    for(size_t ix = 0; ix < sats.size(); ++ix){
+        uint32_t sampleCount = 0;
+        clocks.push_back(EpochSampleClock(sats[ix]->Orbit().TleLine1(), cfg.startTime, cfg.endTime,
+                                          cfg.timeResolutionMs, sampleCount));
+        sampleCounts.push_back(sampleCount);
+    }
+
+    // Only visible rows are written, so samples below the horizon need no
+    // look-angle evaluation.
+    cLookAngleEngine engine;
+    engine.SetVisibleOnly(true);
+    engine.SetThreads(cfg.threads);
+    for(size_t ix = 0; ix < sats.size(); ++ix){
+        engine.AddSatellite(*sats[ix], clocks[ix].Tick(0), clocks[ix].StepMs(), sampleCounts[ix]);
+    }
+    for(size_t ix = 0; ix < sites.size(); ++ix){
+        engine.AddSite(sites[ix]);
+    }
+
+    // The sink closes each satellite's files when the engine is done with
+    // it, so all of them are closed once Run() returns.
+    LookAngleFileSink sink(cfg, clocks, satNames, siteNames);
+    engine.Run(sink);
+
+    qDebug()<<sats.size()<<"satellites x"<<sites.size()<<"sites:"
+           <<sink.Rows()<<"visible rows,"<<sink.Failed()<<"satellites failed,"
+           <<sink.WriteFailed()<<"files not written, in"<<timer.elapsed()<<"ms";
+
+    const cTaskScheduler::cStats& stats = engine.Stats();
+    if(!stats.m_BusyUs.empty()){
+        int64_t busiest = *std::max_element(stats.m_BusyUs.begin(), stats.m_BusyUs.end());
+        int64_t idlest = *std::min_element(stats.m_BusyUs.begin(), stats.m_BusyUs.end());
+        qDebug()<<stats.m_Tasks<<"tasks on"<<stats.m_Threads<<"threads,"<<stats.m_Steals<<"stolen;"
+               <<"busiest thread"<<busiest / 1000<<"ms, least busy"<<idlest / 1000<<"ms";
+    }
+
+    for(size_t ix = 0; ix < sats.size(); ++ix){
+        delete sats[ix];
+    }
+
+    if(sink.WriteFailed() > 0){
+        return -1;
+    }
+    qDebug()<<"Completed";
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// True if the two files have the same contents. Otherwise "offset" is
+// where they first differ.
+static bool SameContents(const std::string& pathA, const std::string& pathB, int64_t& offset)
+{
+    offset = 0;
+    QFile fileA(QString(pathA.c_str()));
+    QFile fileB(QString(pathB.c_str()));
+    if(!fileA.open(QIODevice::ReadOnly) || !fileB.open(QIODevice::ReadOnly)){
+        return false;
+    }
+
+    std::vector<char> bytesA(64 * 1024), bytesB(64 * 1024);
+    for(;;){
+        qint64 countA = fileA.read(&bytesA[0], qint64(bytesA.size()));
+        qint64 countB = fileB.read(&bytesB[0], qint64(bytesB.size()));
+        for(qint64 ix = 0; ix < std::min(countA, countB); ++ix, ++offset){
+            if(bytesA[ix] != bytesB[ix]){
+                return false;
+            }
+        }
+        if(countA != countB || countA < 0){
+            return false;
+        }
+        if(countA == 0){
+            return true;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+int CheckLookAngleMatrix(const LookAngleMatrixConfiguration& cfg)
+{
+    int result = RunLookAngleMatrix(cfg);
+    if(result != 0){
+        return result;
+    }
+
+    std::vector<cSite> sites;
+    std::vector<std::string> siteNames;
+    std::vector<cSatellite*> sats;
+    std::vector<std::string> satNames;
+    if(!LoadSites(cfg.siteList, sites, siteNames) || !LoadSatellites(cfg, sats, satNames)){
+        return -1;
+    }
+
+    size_t checked = 0, differ = 0, skipped = 0;
+    for(size_t sat = 0; sat < sats.size(); ++sat){
+        uint32_t sampleCount = 0;
+        SampleClock clock = EpochSampleClock(sats[sat]->Orbit().TleLine1(), cfg.startTime, cfg.endTime,
+                                             cfg.timeResolutionMs, sampleCount);
+
+        for(size_t site = 0; site < sites.size(); ++site){
+            std::string path = PairPath(cfg, satNames[sat], siteNames[site]);
+            std::string checkPath = path + ".check";
+            QFile file(QString(checkPath.c_str()));
+            if(!file.open(QIODevice::WriteOnly | QIODevice::Text)){
+                qDebug()<<"Could not open"<<checkPath.c_str()<<"for writing.";
+                ++differ;
+                continue;
+            }
+
+            // The rows of a single run of the pair, from all of its
+            // samples, computed on this thread so that a satellite that
+            // cannot be propagated is reported rather than ending the
+            // process.
+            LookAngleRowWriter rows(&file, cfg.decimalCount);
+            rows.WriteText("HH mm ss.zzz Longitude Latitude\n");
+
+            SampleShardJob job;
+            job.pSatellite = sats[sat];
+            job.pSite = &sites[site];
+            job.pClock = &clock;
+            job.sampleCount = sampleCount;
+            if(sampleCount > 0){
+                job.ranges.push_back(std::make_pair(uint32_t(0), sampleCount));
+            }
+            job.decimalCount = cfg.decimalCount;
+            job.textRows = true;
+            job.tableRows = false;
+            job.pRows = &rows;
+            job.pTable = NULL;
+            job.pDenseEphemeris = NULL;
+
+            bool propagated = true;
+            try{
+                RunSampleShards(job, 1);
+            }catch(cPropagationException& e){
+                qDebug()<<"Not checking"<<path.c_str()<<":"<<e.Message().c_str();
+                propagated = false;
+            }
+            bool written = rows.Close() && file.flush();
+            file.close();
+
+            int64_t offset = 0;
+            if(!propagated){
+                QFile::remove(QString(checkPath.c_str()));
+                ++skipped;
+            }else if(!written || !SameContents(path, checkPath, offset)){
+                qDebug()<<path.c_str()<<"differs from the single run at byte"<<offset
+                       <<"; the single run's rows are in"<<checkPath.c_str();
+                ++differ;
+            }else{
+                QFile::remove(QString(checkPath.c_str()));
+                ++checked;
+            }
+        }
+    }
+
+    for(size_t ix = 0; ix < sats.size(); ++ix){
+        delete sats[ix];
+    }
+
+    qDebug()<<checked<<"pairs match the single run,"<<differ<<"differ,"<<skipped<<"not checked";
+    return (differ > 0) ? -1 : 0;
+}
@@ -0,0 +1,48 @@
+//
+// lookAngleMatrix.h
+//
+// Look angles of several satellites from several ground sites in one run
+// (see cLookAngleEngine), enabled by SITE_LIST in the configuration.
+//
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <QDateTime>
+
+#include "coreLib.h"
+
+struct LookAngleMatrixConfiguration {
+    std::string tleCatalog;          // catalog file; empty = the single TLE below
+    std::string tleNoradIds;         // comma-separated catalog entries; empty = all
+    std::string tleName;
+    std::string tleLine1;
+    std::string tleLine2;
+    std::string siteList;            // "NAME,LAT,LON,HEIGHT" per line
+    std::string outputFilename;      // <stem>_<NORAD>_<SITE>.csv per pair
+    QDateTime startTime;
+    QDateTime endTime;
+    uint32_t timeResolutionMs;
+    uint8_t decimalCount;
+    uint32_t threads;                // engine threads; 0 = one per hardware thread
+};
+
+// Writes one look-angle file per (satellite, site) pair. Returns the
+// process exit code.
+int RunLookAngleMatrix(const LookAngleMatrixConfiguration& cfg);
+
+// Runs RunLookAngleMatrix(), then computes each pair's rows again as a
+// single run of it would (see RunSampleShards()), from every sample
+// without screening, and compares them with the pair's file byte for
+// byte. For a pair that differs, the single run's rows are left next to
+// its file, with ".check" appended to the name. Returns -1 if any pair
+// differs.
+int CheckLookAngleMatrix(const LookAngleMatrixConfiguration& cfg);
+
+// Reads a site list: "NAME,LAT,LON,HEIGHT" lines (degrees, km); blank
+// lines and lines starting with '#' are skipped. Returns false, after
+// reporting it, on an unreadable file or line, or if there are no sites.
+bool LoadSites(const std::string& path, std::vector<cSite>& sites,
+               std::vector<std::string>& names);
@@ -0,0 +1,188 @@
+//
+// lookAngleRowWriter.cpp
+//
+#include "stdafx.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <QIODevice>
+
+#include "lookAngleRowWriter.h"
+
+const size_t LookAngleRowWriter::DEFAULT_CAPACITY;
+const size_t LookAngleRowWriter::MAX_ROW_LENGTH;
+
+// Decimal places handled in integer arithmetic; more go through snprintf.
+static const uint8_t FIXED_MAX_DECIMALS = 9;
+
+static const uint64_t POW10[FIXED_MAX_DECIMALS + 1] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull,
+    1000000ull, 10000000ull, 100000000ull, 1000000000ull
+};
+
+// Scaled values below this have a fractional part with at least 1/2
+// resolution, which the rounding below relies on.
+static const double FIXED_MAX_SCALED = 4503599627370496.0;   // 2^52
+
+//////////////////////////////////////////////////////////////////////////////
+LookAngleRowWriter::LookAngleRowWriter(QIODevice* device, uint8_t decimalCount,
+                                       size_t capacity)
+    : m_pDevice(device), m_pBlockWriter(NULL), m_pBlock(NULL), m_DecimalCount(decimalCount),
+      m_Buffer(capacity < 2*MAX_ROW_LENGTH ? 2*MAX_ROW_LENGTH : capacity),
+      m_pData(&m_Buffer[0]), m_Capacity(m_Buffer.size()), m_Used(0), m_fError(false)
+{
+}
+
+LookAngleRowWriter::LookAngleRowWriter(BlockWriter* blockWriter, uint8_t decimalCount)
+    : m_pDevice(NULL), m_pBlockWriter(blockWriter), m_pBlock(NULL), m_DecimalCount(decimalCount),
+      m_pData(NULL), m_Capacity(0), m_Used(0), m_fError(false)
+{
+}
+
+LookAngleRowWriter::~LookAngleRowWriter()
+{
+    Flush();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void LookAngleRowWriter::WriteText(const char* text)
+{
+    WriteBytes(text, strlen(text));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void LookAngleRowWriter::WriteBytes(const char* bytes, size_t length)
+{
+    while(length > 0){
+        if(m_Used == m_Capacity){
+            Reserve();
+        }
+        size_t count = std::min(length, m_Capacity - m_Used);
+        memcpy(m_pData + m_Used, bytes, count);
+        m_Used += count;
+        bytes += count;
+        length -= count;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// A failed write is remembered, so that errors hit by Reserve() or the
+// destructor are reported by the next Flush() or Close().
+bool LookAngleRowWriter::Flush()
+{
+    if(m_pBlockWriter){
+        if(m_pBlock){
+            m_pBlock->m_Used = m_Used;
+            m_pBlockWriter->Submit(m_pBlock);
+            m_pBlock = NULL;
+            m_pData = NULL;
+            m_Capacity = 0;
+        }
+    }else if(m_Used > 0){
+        if(m_pDevice->write(m_pData, qint64(m_Used)) != qint64(m_Used)){
+            m_fError = true;
+        }
+    }
+    m_Used = 0;
+    return !m_fError;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void LookAngleRowWriter::Reserve()
+{
+    Flush();
+    if(m_pBlockWriter){
+        m_pBlock = m_pBlockWriter->Acquire();
+        m_pData = &m_pBlock->m_Data[0];
+        m_Capacity = m_pBlock->m_Data.size();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Writes "value" with "decimalCount" places, left-padded with zeros to
+// "width" characters, and returns the end of the text.
+char* LookAngleRowWriter::FormatFixed(char* p, double value, uint8_t decimalCount, int width)
+{
+    if(decimalCount <= FIXED_MAX_DECIMALS && value >= 0.0 &&
+       value * POW10[decimalCount] < FIXED_MAX_SCALED){
+        double scale = double(POW10[decimalCount]);
+        double scaled = value * scale;
+        uint64_t digits = uint64_t(scaled);
+        double fraction = scaled - double(digits);
+
+        // The product is rounded, but only a fraction of exactly one half
+        // can hide which side of it the true value is on: the rounding
+        // error, recovered exactly by the fused multiply-add, decides.
+        if(fraction > 0.5 || (fraction == 0.5 && fma(value, scale, -scaled) >= 0.0)){
+            ++digits;
+        }
+
+        uint64_t whole = digits / POW10[decimalCount];
+        uint64_t part = digits % POW10[decimalCount];
+
+        char text[32];
+        char* q = text + sizeof(text);
+        for(uint8_t ix = 0; ix < decimalCount; ++ix){
+            *--q = char('0' + part % 10);
+            part /= 10;
+        }
+        if(decimalCount > 0){
+            *--q = '.';
+        }
+        do{
+            *--q = char('0' + whole % 10);
+            whole /= 10;
+        }while(whole > 0);
+
+        int length = int(text + sizeof(text) - q);
+        for(; width > length; --width){
+            *p++ = '0';
+        }
+        memcpy(p, q, length);
+        return p + length;
+    }
+
+    // Rare: negative, very large or very precise values
+    char text[MAX_ROW_LENGTH / 2 - 16];
+    int length = snprintf(text, sizeof(text), "%.*f", int(decimalCount), value);
+    if(length < 0 || length >= int(sizeof(text))){
+        length = int(sizeof(text)) - 1;
+    }
+    if(width > int(sizeof(text)) - 1){
+        width = int(sizeof(text)) - 1;
+    }
+    for(; width > length; --width){
+        *p++ = '0';
+    }
+    memcpy(p, text, length);
+    return p + length;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+size_t LookAngleRowWriter::FormatRow(char* p, uint32_t msecOfDay, double azDeg, double elDeg,
+                                     uint8_t decimalCount)
+{
+    char* start = p;
+    uint32_t seconds = msecOfDay / 1000;
+    uint32_t msecs = msecOfDay % 1000;
+    uint32_t fields[3] = { seconds / 3600, seconds / 60 % 60, seconds % 60 };
+
+    for(int ix = 0; ix < 3; ++ix){
+        *p++ = char('0' + fields[ix] / 10 % 10);
+        *p++ = char('0' + fields[ix] % 10);
+        *p++ = (ix < 2) ? ' ' : '.';
+    }
+    *p++ = char('0' + msecs / 100);
+    *p++ = char('0' + msecs / 10 % 10);
+    *p++ = char('0' + msecs % 10);
+    *p++ = ' ';
+
+    p = FormatFixed(p, azDeg, decimalCount, 4 + decimalCount);
+    *p++ = ' ';
+    p = FormatFixed(p, elDeg, decimalCount, 3 + decimalCount);
+    *p++ = '\n';
+
+    return size_t(p - start);
+}
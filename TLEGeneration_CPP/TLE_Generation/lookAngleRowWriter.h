@@ -0,0 +1,81 @@
+//
+// lookAngleRowWriter.h
+//
+// Writes look-angle rows, "HH MM SS.ZZZ AZ EL", to a device. Rows are
+// formatted with integer fixed-point arithmetic straight into a byte
+// buffer that is allocated once and written out in large blocks, so no
+// string objects are created per row. Given a BlockWriter instead of a
+// device, the writer fills the BlockWriter's blocks and leaves the
+// writing to its thread.
+//
+// The text matches what QString::number(x, 'f', decimalCount) padded
+// with rightJustified() produced: the value correctly rounded to
+// "decimalCount" places (exact halves round up, as in Qt), left-padded
+// with zeros to 4 + decimalCount characters for the azimuth and
+// 3 + decimalCount for the elevation.
+//
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "blockWriter.h"
+
+class QIODevice;
+
+class LookAngleRowWriter {
+public:
+    static const size_t DEFAULT_CAPACITY = 1 << 20;
+
+    // Longest row: both values printed in full (see FormatFixed()).
+    static const size_t MAX_ROW_LENGTH = 1024;
+
+    LookAngleRowWriter(QIODevice* device, uint8_t decimalCount,
+                       size_t capacity = DEFAULT_CAPACITY);
+    // Blocks of "blockWriter" must hold at least MAX_ROW_LENGTH bytes.
+    LookAngleRowWriter(BlockWriter* blockWriter, uint8_t decimalCount);
+    ~LookAngleRowWriter();
+
+    void WriteText(const char* text);
+    void WriteBytes(const char* bytes, size_t length);
+    void WriteRow(uint32_t msecOfDay, double azDeg, double elDeg)
+    {
+        if(m_Capacity - m_Used < MAX_ROW_LENGTH){
+            Reserve();
+        }
+        m_Used += FormatRow(m_pData + m_Used, msecOfDay, azDeg, elDeg, m_DecimalCount);
+    }
+
+    // Writes out the buffered rows, or submits them to the BlockWriter.
+    // Returns false if the device has failed to take any rows so far;
+    // rows it did not take are dropped. With a BlockWriter, write errors
+    // are reported by BlockWriter::Close().
+    bool Flush();
+
+    // Flushes for the last time. Call it before destroying the writer
+    // to learn whether everything was written; the destructor flushes
+    // too, but cannot report an error.
+    bool Close() { return Flush(); }
+
+    // Formats one row, with its newline, at "p". Returns its length,
+    // at most MAX_ROW_LENGTH.
+    static size_t FormatRow(char* p, uint32_t msecOfDay, double azDeg, double elDeg,
+                            uint8_t decimalCount);
+
+private:
+    // Flushes, and with a BlockWriter, takes the next block to fill.
+    void Reserve();
+
+    static char* FormatFixed(char* p, double value, uint8_t decimalCount, int width);
+
+    QIODevice* m_pDevice;
+    BlockWriter* m_pBlockWriter;
+    BlockWriter::Block* m_pBlock;
+    uint8_t m_DecimalCount;
+    std::vector<char> m_Buffer;
+    char* m_pData;          // m_Buffer, or m_pBlock's data
+    size_t m_Capacity;
+    size_t m_Used;
+    bool m_fError;          // a device write failed; sticky
+};
@@ -0,0 +1,752 @@
+//
+// lookAngleService.cpp
+//
+// The workers wait on the listening socket themselves (it is non-blocking,
+// so those that lose the race for a connection go back to waiting), and
+// poll with a timeout so that they notice a stop request. There is no
+// dispatcher thread between a connection and the worker answering it.
+//
+// A worker keeps the connections it accepted, all non-blocking, in one
+// poll set. A connection's answers are buffered and sent as the client
+// takes them, and its requests are read meanwhile, so a client that sends
+// many requests before reading cannot stall the worker: past
+// SERVICE_MAX_OUTPUT of unsent answers the worker only stops reading that
+// connection, and one that moves no data for SERVICE_IDLE_MS is closed.
+//
+// The satellites are in a cOrbitCatalog. Each worker registers as one of
+// its readers and answers each request in a read section; a reload, on
+// the updater thread, builds the changed satellites and publishes them one
+// at a time while the workers keep answering.
+//
+#include "stdafx.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QString>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "coreLib.h"
+#include "orbitLib.h"
+
+#include "lookAngleMatrix.h"
+#include "lookAngleService.h"
+
+#ifndef _WIN32
+
+// How often waiting workers check for a stop request, ms
+static const int SERVICE_POLL_MS = 200;
+
+// Bytes read from a connection at a time; every complete request in them
+// is answered with one write.
+static const size_t SERVICE_READ_SIZE = 64 * 1024;
+
+// A connection whose pending request grows past this is closed.
+static const size_t SERVICE_MAX_LINE = 1024 * 1024;
+
+// Unsent answers past which a connection's requests are not read until
+// the client has read some of them
+static const size_t SERVICE_MAX_OUTPUT = 4 * 1024 * 1024;
+
+// A connection that neither sends nor takes any data for this long is
+// closed, ms.
+static const int SERVICE_IDLE_MS = 60 * 1000;
+
+// Longest PASSES window, days
+static const double SERVICE_MAX_PASS_DAYS = 31.0;
+
+static volatile sig_atomic_t serviceStop = 0;
+static volatile sig_atomic_t serviceReload = 0;
+
+static void onStopSignal(int)
+{
+    serviceStop = 1;
+}
+
+static void onReloadSignal(int)
+{
+    serviceReload = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// "yyyy-MM-ddTHH:mm:ss[.zzz]", UTC
+static bool parseTime(const std::string& text, cJulian& time)
+{
+    int year, month, day, hour, minute;
+    double second;
+    char sep;
+    if(sscanf(text.c_str(), "%d-%d-%d%c%d:%d:%lf", &year, &month, &day, &sep,
+              &hour, &minute, &second) != 7 || sep != 'T'){
+        return false;
+    }
+    if(month < 1 || month > 12 || day < 1 || day > 31 || hour < 0 || hour > 23 ||
+       minute < 0 || minute > 59 || second < 0.0 || second >= 60.0){
+        return false;
+    }
+    time = cJulian(year, month, day, hour, minute, second);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// As parseTime() reads it, to the millisecond.
+static std::string formatTime(const cJulian& time)
+{
+    int year, month;
+    double dom;
+    time.GetComponent(&year, &month, &dom);
+    int day = int(dom);
+    int64_t ms = int64_t((dom - day) * 86400000.0 + 0.5);
+    if(ms > 86399999) ms = 86399999;
+
+    char text[32];
+    snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d:%02d.%03d",
+             year, month, day, int(ms / 3600000), int(ms / 60000 % 60),
+             int(ms / 1000 % 60), int(ms % 1000));
+    return text;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// A client connection, owned by the worker that accepted it
+struct ServiceConnection {
+    int fd;
+    std::string pending;             // received, not yet a complete request
+    std::string out;                 // answers; those before "sent" are sent
+    size_t sent;
+    bool fInputDone;                 // no more requests are read
+    std::chrono::steady_clock::time_point lastActive;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+class LookAngleService
+{
+public:
+    LookAngleService()
+        : m_ListenFd(-1), m_fReloadRequested(false), m_Connections(0),
+          m_Requests(0), m_Updates(0) {}
+
+    bool Load(const LookAngleServiceConfiguration& cfg);
+    bool Listen(const std::string& socketPath);
+    void Serve(unsigned workers);
+
+    size_t SatelliteCount() const { return m_Orbits.Size(); }
+    size_t SiteCount() const { return m_Sites.size(); }
+    size_t Connections() const { return m_Connections; }
+    size_t Requests() const { return m_Requests; }
+    size_t Updates() const { return m_Updates; }
+
+private:
+    bool Reload();
+    void Updater();
+    void Worker();
+    bool ServeConnection(ServiceConnection& conn, std::vector<char>& buffer,
+                         cOrbitCatalog::cReader& reader);
+    void Answer(const std::string& line, cOrbitCatalog::cReader& reader, std::string& out);
+    void AnswerLook(const std::vector<std::string>& fields, const cOrbitCatalog::cReadGuard& guard,
+                    std::string& out);
+    void AnswerPasses(const std::vector<std::string>& fields, const cOrbitCatalog::cReadGuard& guard,
+                      std::string& out);
+    void AnswerElements(const std::vector<std::string>& fields, const cOrbitCatalog::cReadGuard& guard,
+                        std::string& out);
+    bool Find(const std::vector<std::string>& fields, const cOrbitCatalog::cReadGuard& guard,
+              const cSatellite*& pSat, const cSite*& pSite, std::string& out) const;
+
+    cOrbitCatalog m_Orbits;
+    std::string m_CatalogPath;
+    std::map<int, std::string> m_Elements;     // updater only: lines of each published satellite
+    std::vector<cSite> m_Sites;
+    std::map<std::string, size_t> m_SiteIndex;
+    std::string m_SocketPath;
+    int m_ListenFd;
+    std::atomic<bool> m_fReloadRequested;
+    std::atomic<size_t> m_Connections;
+    std::atomic<size_t> m_Requests;
+    std::atomic<size_t> m_Updates;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+bool LookAngleService::Load(const LookAngleServiceConfiguration& cfg)
+{
+    if(!cfg.tleCatalog.empty()){
+        m_CatalogPath = cfg.tleCatalog;
+        if(!Reload()){
+            return false;
+        }
+    }else{
+        std::string name = cfg.tleName, line1 = cfg.tleLine1, line2 = cfg.tleLine2;
+        m_Orbits.Update(cTle(name, line1, line2));
+    }
+
+    std::vector<std::string> names;
+    if(!cfg.siteList.empty()){
+        if(!LoadSites(cfg.siteList, m_Sites, names)){
+            return false;
+        }
+    }else{
+        m_Sites.push_back(cSite(cfg.siteLat, cfg.siteLon, cfg.siteHeight, "SITE"));
+        names.push_back("SITE");
+    }
+    for(size_t ix = 0; ix < names.size(); ++ix){
+        m_SiteIndex[names[ix]] = ix;
+    }
+
+    return m_Orbits.Size() > 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Reads the catalog file again and publishes a new satellite for each
+// entry whose element set changed or is new. Entries no longer in the
+// file are kept.
+bool LookAngleService::Reload()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    cTleCatalog catalog;
+    if(!catalog.Load(m_CatalogPath)){
+        qDebug()<<"Cannot open TLE catalog"<<m_CatalogPath.c_str();
+        return false;
+    }
+
+    size_t updated = 0;
+    for(size_t ix = 0; ix < catalog.Size(); ++ix){
+        int noradId = catalog.NoradId(ix);
+        if(catalog.Find(noradId) != ix){
+            continue;          // a later duplicate
+        }
+        std::string elements = catalog.Line1(ix) + "\n" + catalog.Line2(ix);
+        auto current = m_Elements.find(noradId);
+        if(current != m_Elements.end() && current->second == elements){
+            continue;
+        }
+        try{
+            m_Orbits.Update(catalog.Tle(ix));
+            m_Elements[noradId] = elements;
+            ++updated;
+        }catch(cPropagationException& e){
+            qDebug()<<"Skipping NORAD ID"<<noradId<<":"<<e.Message().c_str();
+        }
+    }
+
+    m_Updates += updated;
+    qDebug()<<"Loaded"<<m_CatalogPath.c_str()<<":"<<updated<<"of"<<catalog.Size()
+           <<"element sets new or changed, in"<<timer.elapsed()<<"ms";
+    return true;
+}
+//////////////////////////////////////////////////////////////////////////////
+// A socket file left behind by a service that did not stop cleanly is
+// replaced; one that a running service still answers on is not.
+bool LookAngleService::Listen(const std::string& socketPath)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path)){
+        qDebug()<<"Invalid service socket path"<<socketPath.c_str();
+        return false;
+    }
+    strcpy(addr.sun_path, socketPath.c_str());
+
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(probe >= 0 && connect(probe, (sockaddr*)&addr, sizeof(addr)) == 0){
+        close(probe);
+        qDebug()<<"A service is already running on"<<socketPath.c_str();
+        return false;
+    }
+    if(probe >= 0){
+        close(probe);
+    }
+    unlink(socketPath.c_str());
+
+    m_ListenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(m_ListenFd < 0 ||
+       bind(m_ListenFd, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+       listen(m_ListenFd, SOMAXCONN) != 0){
+        qDebug()<<"Cannot listen on"<<socketPath.c_str()<<":"<<strerror(errno);
+        if(m_ListenFd >= 0){
+            close(m_ListenFd);
+            m_ListenFd = -1;
+        }
+        return false;
+    }
+    fcntl(m_ListenFd, F_SETFL, fcntl(m_ListenFd, F_GETFL) | O_NONBLOCK);
+    m_SocketPath = socketPath;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Returns once a stop signal has arrived and every worker has closed its
+// connections.
+void LookAngleService::Serve(unsigned workers)
+{
+    std::vector<std::thread> threads;
+    threads.push_back(std::thread(&LookAngleService::Updater, this));
+    for(unsigned ix = 0; ix < workers; ++ix){
+        threads.push_back(std::thread(&LookAngleService::Worker, this));
+    }
+    for(size_t ix = 0; ix < threads.size(); ++ix){
+        threads[ix].join();
+    }
+
+    close(m_ListenFd);
+    m_ListenFd = -1;
+    unlink(m_SocketPath.c_str());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Reloads the catalog on SIGHUP or a RELOAD request.
+void LookAngleService::Updater()
+{
+    while(!serviceStop){
+        bool fRequested = m_fReloadRequested.exchange(false);
+        if(serviceReload){
+            serviceReload = 0;
+            fRequested = true;
+        }
+        if(fRequested && !m_CatalogPath.empty()){
+            Reload();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(SERVICE_POLL_MS));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Serves the connections it accepts until stopped. Their requests are
+// answered one at a time, so a long one delays the worker's other
+// connections, not those of the other workers.
+void LookAngleService::Worker()
+{
+    cOrbitCatalog::cReader reader(m_Orbits);
+    std::vector<ServiceConnection> conns;
+    std::vector<pollfd> waits;
+    std::vector<char> buffer(SERVICE_READ_SIZE);
+
+    while(!serviceStop){
+        waits.clear();
+        pollfd listening = { m_ListenFd, POLLIN, 0 };
+        waits.push_back(listening);
+        for(size_t ix = 0; ix < conns.size(); ++ix){
+            const ServiceConnection& conn = conns[ix];
+            pollfd wait = { conn.fd, 0, 0 };
+            if(!conn.fInputDone && conn.out.size() - conn.sent < SERVICE_MAX_OUTPUT){
+                wait.events |= POLLIN;
+            }
+            if(conn.sent < conn.out.size()){
+                wait.events |= POLLOUT;
+            }
+            waits.push_back(wait);
+        }
+        if(poll(&waits[0], waits.size(), SERVICE_POLL_MS) < 0){
+            continue;          // EINTR: check for a stop request
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        size_t kept = 0;
+        for(size_t ix = 0; ix < conns.size(); ++ix){
+            ServiceConnection& conn = conns[ix];
+            bool fOpen = (waits[ix + 1].revents == 0) || ServeConnection(conn, buffer, reader);
+            if(fOpen && now - conn.lastActive > std::chrono::milliseconds(SERVICE_IDLE_MS)){
+                fOpen = false;
+            }
+            if(!fOpen){
+                close(conn.fd);
+                continue;
+            }
+            if(kept != ix){
+                conns[kept] = std::move(conn);
+            }
+            ++kept;
+        }
+        conns.resize(kept);
+
+        if(waits[0].revents & POLLIN){
+            int fd = accept(m_ListenFd, NULL, NULL);
+            if(fd >= 0){          // else taken by another worker
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                ServiceConnection conn;
+                conn.fd = fd;
+                conn.sent = 0;
+                conn.fInputDone = false;
+                conn.lastActive = std::chrono::steady_clock::now();
+                conns.push_back(std::move(conn));
+                ++m_Connections;
+            }
+        }
+    }
+
+    for(size_t ix = 0; ix < conns.size(); ++ix){
+        close(conns[ix].fd);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Reads what has arrived, answers the complete requests, and sends as
+// much of the answers as the client takes without waiting. A last request
+// without a line end is answered when the client closes its end. Returns
+// false once the connection is done with: the client closed its end and
+// has all the answers, or the connection failed.
+bool LookAngleService::ServeConnection(ServiceConnection& conn, std::vector<char>& buffer,
+                                       cOrbitCatalog::cReader& reader)
+{
+    if(!conn.fInputDone && conn.out.size() - conn.sent < SERVICE_MAX_OUTPUT){
+        ssize_t n = recv(conn.fd, &buffer[0], buffer.size(), 0);
+        if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+            return false;
+        }
+        if(n == 0){
+            if(!conn.pending.empty()){
+                Answer(conn.pending, reader, conn.out);
+                conn.pending.clear();
+            }
+            conn.fInputDone = true;
+        }else if(n > 0){
+            conn.lastActive = std::chrono::steady_clock::now();
+            conn.pending.append(&buffer[0], size_t(n));
+
+            size_t start = 0, end;
+            while((end = conn.pending.find('\n', start)) != std::string::npos){
+                Answer(conn.pending.substr(start, end - start), reader, conn.out);
+                start = end + 1;
+            }
+            conn.pending.erase(0, start);
+
+            if(conn.pending.size() > SERVICE_MAX_LINE){
+                conn.out += "ERR request too long\n";
+                conn.pending.clear();
+                conn.fInputDone = true;
+            }
+        }
+    }
+
+    if(conn.sent < conn.out.size()){
+        ssize_t n = send(conn.fd, conn.out.data() + conn.sent, conn.out.size() - conn.sent,
+                         MSG_NOSIGNAL);
+        if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+            return false;
+        }
+        if(n > 0){
+            conn.lastActive = std::chrono::steady_clock::now();
+            conn.sent += size_t(n);
+            if(conn.sent == conn.out.size()){
+                conn.out.clear();
+                conn.sent = 0;
+            }else if(conn.sent > SERVICE_READ_SIZE && conn.sent > conn.out.size() / 2){
+                conn.out.erase(0, conn.sent);
+                conn.sent = 0;
+            }
+        }
+    }
+
+    return !conn.fInputDone || conn.sent < conn.out.size();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Each request is answered in its own read section, so a satellite
+// replaced meanwhile is freed as soon as the request that uses it is done.
+void LookAngleService::Answer(const std::string& line, cOrbitCatalog::cReader& reader,
+                              std::string& out)
+{
+    std::istringstream in(line);
+    std::vector<std::string> fields((std::istream_iterator<std::string>(in)),
+                                    std::istream_iterator<std::string>());
+    if(fields.empty()){
+        return;
+    }
+    ++m_Requests;
+
+    if(fields[0] == "LOOK"){
+        cOrbitCatalog::cReadGuard guard(reader);
+        AnswerLook(fields, guard, out);
+    }else if(fields[0] == "PASSES"){
+        cOrbitCatalog::cReadGuard guard(reader);
+        AnswerPasses(fields, guard, out);
+    }else if(fields[0] == "ELEMENTS"){
+        cOrbitCatalog::cReadGuard guard(reader);
+        AnswerElements(fields, guard, out);
+    }else if(fields[0] == "RELOAD"){
+        if(m_CatalogPath.empty()){
+            out += "ERR no TLE catalog to reload\n";
+        }else{
+            m_fReloadRequested = true;
+            out += "OK 0\n";
+        }
+    }else if(fields[0] == "PING"){
+        out += "OK 0\n";
+    }else{
+        out += "ERR unknown request " + fields[0] + "\n";
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+bool LookAngleService::Find(const std::vector<std::string>& fields,
+                            const cOrbitCatalog::cReadGuard& guard,
+                            const cSatellite*& pSat, const cSite*& pSite,
+                            std::string& out) const
+{
+    pSat = guard.Find(atoi(fields[1].c_str()));
+    if(pSat == NULL){
+        out += "ERR unknown satellite " + fields[1] + "\n";
+        return false;
+    }
+    auto site = m_SiteIndex.find(fields[2]);
+    if(site == m_SiteIndex.end()){
+        out += "ERR unknown site " + fields[2] + "\n";
+        return false;
+    }
+    pSite = &m_Sites[site->second];
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The times of one request share a propagation context, so an SDP4
+// resonance integration continues from one time to the next.
+void LookAngleService::AnswerLook(const std::vector<std::string>& fields,
+                                  const cOrbitCatalog::cReadGuard& guard, std::string& out)
+{
+    const cSatellite* pSat;
+    const cSite* pSite;
+    if(fields.size() < 4){
+        out += "ERR usage: LOOK <NORAD id> <site> <time> [<time> ...]\n";
+        return;
+    }
+    if(!Find(fields, guard, pSat, pSite, out)){
+        return;
+    }
+
+    std::string rows;
+    char row[128];
+    cPropagationContext context;
+    for(size_t ix = 3; ix < fields.size(); ++ix){
+        cJulian time;
+        if(!parseTime(fields[ix], time)){
+            out += "ERR invalid time " + fields[ix] + "\n";
+            return;
+        }
+        try{
+            double mpe = pSat->Orbit().TPlusEpoch(time) / 60.0;
+            cTopo topo = pSite->GetLookAngle(pSat->PositionEci(mpe, context));
+            snprintf(row, sizeof(row), "%.6f %.6f %.6f %.6f\n", topo.AzimuthDeg(),
+                     topo.ElevationDeg(), topo.RangeKm(), topo.RangeRateKmSec());
+            rows += row;
+        }catch(cPropagationException& e){
+            out += "ERR " + fields[ix] + ": " + e.Message() + "\n";
+            return;
+        }
+    }
+
+    out += "OK " + std::to_string(fields.size() - 3) + "\n" + rows;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void LookAngleService::AnswerPasses(const std::vector<std::string>& fields,
+                                    const cOrbitCatalog::cReadGuard& guard, std::string& out)
+{
+    const cSatellite* pSat;
+    const cSite* pSite;
+    cJulian start, end;
+    if(fields.size() != 5){
+        out += "ERR usage: PASSES <NORAD id> <site> <start> <end>\n";
+        return;
+    }
+    if(!Find(fields, guard, pSat, pSite, out)){
+        return;
+    }
+    if(!parseTime(fields[3], start) || !parseTime(fields[4], end)){
+        out += "ERR invalid time\n";
+        return;
+    }
+    if(end.SpanDay(start) > SERVICE_MAX_PASS_DAYS){
+        out += "ERR window longer than " + std::to_string(int(SERVICE_MAX_PASS_DAYS)) + " days\n";
+        return;
+    }
+
+    std::vector<cPass> passes;
+    try{
+        cPassPredictor predictor(*pSat, *pSite);
+        passes = predictor.FindPasses(pSat->Orbit().TPlusEpoch(start) / 60.0,
+                                      pSat->Orbit().TPlusEpoch(end) / 60.0);
+    }catch(cPropagationException& e){
+        out += "ERR " + e.Message() + "\n";
+        return;
+    }
+
+    out += "OK " + std::to_string(passes.size()) + "\n";
+    cJulian epoch = pSat->Orbit().Epoch();
+    char maxEl[32];
+    for(size_t ix = 0; ix < passes.size(); ++ix){
+        cJulian aos = epoch, tca = epoch, los = epoch;
+        aos.AddMin(passes[ix].m_mpeAos);
+        tca.AddMin(passes[ix].m_mpeTca);
+        los.AddMin(passes[ix].m_mpeLos);
+        snprintf(maxEl, sizeof(maxEl), " %.6f\n", rad2deg(passes[ix].m_radMaxEl));
+        out += formatTime(aos) + " " + formatTime(tca) + " " + formatTime(los) + maxEl;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void LookAngleService::AnswerElements(const std::vector<std::string>& fields,
+                                      const cOrbitCatalog::cReadGuard& guard, std::string& out)
+{
+    if(fields.size() != 2){
+        out += "ERR usage: ELEMENTS <NORAD id>\n";
+        return;
+    }
+    const cSatellite* pSat = guard.Find(atoi(fields[1].c_str()));
+    if(pSat == NULL){
+        out += "ERR unknown satellite " + fields[1] + "\n";
+        return;
+    }
+    out += "OK 2\n" + pSat->Orbit().TleLine1() + "\n" + pSat->Orbit().TleLine2() + "\n";
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+int RunLookAngleService(const LookAngleServiceConfiguration& cfg)
+{
+#ifdef _WIN32
+    qDebug()<<"The look-angle service needs Unix domain sockets, which this build does not support.";
+    return -1;
+#else
+    QElapsedTimer timer;
+    timer.start();
+
+    LookAngleService service;
+    if(!service.Load(cfg) || !service.Listen(cfg.socketPath)){
+        return -1;
+    }
+
+    unsigned workers = cfg.workers;
+    if(workers == 0){
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    signal(SIGINT, onStopSignal);
+    signal(SIGTERM, onStopSignal);
+    signal(SIGHUP, onReloadSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    qDebug()<<"Serving"<<service.SatelliteCount()<<"satellites and"<<service.SiteCount()<<"sites on"
+           <<cfg.socketPath.c_str()<<"with"<<workers<<"workers, loaded in"<<timer.elapsed()<<"ms";
+
+    service.Serve(workers);
+
+    qDebug()<<service.Requests()<<"requests on"<<service.Connections()<<"connections,"
+           <<service.Updates()<<"element sets loaded, in"<<timer.elapsed() / 1000<<"s";
+    qDebug()<<"Completed";
+    return 0;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+int QueryLookAngleService(const std::string& socketPath)
+{
+#ifdef _WIN32
+    qDebug()<<"The look-angle service needs Unix domain sockets, which this build does not support.";
+    return -1;
+#else
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path)){
+        qDebug()<<"Invalid service socket path"<<socketPath.c_str();
+        return -1;
+    }
+    strcpy(addr.sun_path, socketPath.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0){
+        qDebug()<<"Cannot connect to"<<socketPath.c_str()<<":"<<strerror(errno);
+        if(fd >= 0){
+            close(fd);
+        }
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    signal(SIGPIPE, SIG_IGN);
+
+    // Requests are sent as standard input provides them, and answers are
+    // copied out as they arrive: the service reads no further ahead than
+    // the answers it has been able to send. Closing the sending side tells
+    // it that no more requests follow.
+    std::string requests;
+    size_t sent = 0;
+    bool fInputDone = false, fSendDone = false, ok = true;
+    char buffer[64 * 1024];
+
+    for(;;){
+        pollfd waits[2] = {
+            { fd, short(POLLIN | (sent < requests.size() ? POLLOUT : 0)), 0 },
+            { (!fInputDone && requests.size() - sent < SERVICE_READ_SIZE) ? STDIN_FILENO : -1,
+              POLLIN, 0 }
+        };
+        if(poll(waits, 2, -1) < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            ok = false;
+            break;
+        }
+
+        if(waits[1].revents){
+            ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if(n > 0){
+                requests.erase(0, sent);
+                sent = 0;
+                requests.append(buffer, size_t(n));
+            }else if(n == 0 || errno != EINTR){
+                fInputDone = true;
+            }
+        }
+
+        if(sent < requests.size() && waits[0].revents){
+            ssize_t n = send(fd, requests.data() + sent, requests.size() - sent, MSG_NOSIGNAL);
+            if(n > 0){
+                sent += size_t(n);
+            }else if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+                // The service closed the connection; its answers still arrive.
+                requests.clear();
+                sent = 0;
+                fInputDone = true;
+                ok = false;
+            }
+        }
+        if(fInputDone && sent == requests.size() && !fSendDone){
+            shutdown(fd, SHUT_WR);
+            fSendDone = true;
+        }
+
+        if(waits[0].revents & (POLLIN | POLLHUP | POLLERR)){
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if(n > 0){
+                fwrite(buffer, 1, size_t(n), stdout);
+            }else if(n == 0){
+                break;
+            }else if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+                ok = false;
+                break;
+            }
+        }
+    }
+    fflush(stdout);
+    close(fd);
+    return ok ? 0 : -1;
+#endif
+}
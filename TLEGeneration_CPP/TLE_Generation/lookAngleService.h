@@ -0,0 +1,67 @@
+//
+// lookAngleService.h
+//
+// A resident look-angle service: "TLE_Generation --serve" loads the
+// satellites and sites once, initializes their orbit models, and answers
+// queries on a Unix domain socket (SERVICE_SOCKET) until it is stopped
+// with SIGINT or SIGTERM; SIGHUP reloads TLE_CATALOG. "TLE_Generation
+// --query [socket]" sends its standard input to the service and prints
+// the answers, so the service can be used from a shell without any other
+// tool.
+//
+// Requests are text lines of space-separated fields; times are UTC,
+// written "yyyy-MM-ddTHH:mm:ss[.zzz]":
+//
+//   LOOK <NORAD id> <site> <time> [<time> ...]
+//      one line per time: "<az deg> <el deg> <range km> <range rate km/s>"
+//   PASSES <NORAD id> <site> <start> <end>
+//      one line per pass: "<AOS> <TCA> <LOS> <max el deg>" (see cPassPredictor)
+//   ELEMENTS <NORAD id>
+//      the two lines of the element set in use
+//   RELOAD
+//      reload TLE_CATALOG in the background, as SIGHUP does
+//   PING
+//
+// Each answer starts with "OK <lines>", followed by that many lines, or
+// is the single line "ERR <message>". Requests on a connection are
+// answered in order, so a client may send many before reading, provided
+// it reads the answers while it sends: the service stops reading a
+// connection while 4 MB of its answers wait to be sent. A connection that
+// sends and takes nothing for a minute is closed.
+//
+// SERVICE_WORKERS threads (0 = one per hardware thread) each serve any
+// number of connections, answering one request at a time, so a long
+// request delays only the other connections of its worker. They share
+// the satellites and sites; each request propagates with its own
+// cPropagationContext.
+//
+// A reload builds a satellite for each new or changed element set and
+// swaps it in (see cOrbitCatalog) while requests are being answered: a
+// request uses the element set that was current when it started, and the
+// workers never wait for the reload.
+//
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+struct LookAngleServiceConfiguration {
+    std::string tleCatalog;          // satellites by NORAD id; empty = the single TLE below
+    std::string tleName;
+    std::string tleLine1;
+    std::string tleLine2;
+    std::string siteList;            // sites by name; empty = the single site below, as "SITE"
+    double siteLat;
+    double siteLon;
+    double siteHeight;
+    std::string socketPath;
+    uint32_t workers;                // 0 = one per hardware thread
+};
+
+// Serves requests until stopped. Returns the process exit code.
+int RunLookAngleService(const LookAngleServiceConfiguration& cfg);
+
+// Sends standard input to the service at "socketPath" as it is read, and
+// copies the answers to standard output as they arrive. Returns the
+// process exit code.
+int QueryLookAngleService(const std::string& socketPath);
@@ -16,10 +16,12 @@
 #include <math.h>
 #include <QFile>
 #include <QTextStream>
+#include <QElapsedTimer>
 #include <QDebug>
 #include <QString>
 #include <QDateTime>
 #include <map>
+#include <thread>
 
 // "coreLib.h" includes basic types from the core library,
 // such as cSite, cJulian, etc. The header file also contains a
@@ -30,41 +32,18 @@
 // including cOrbit.
 #include "orbitLib.h"
 
-// Forward declaration of helper function; see below
-void PrintPosVel(const cSatellite& sat);
-
-QDateTime convertFractionalTimestampToDateTime(uint8_t year, double fractional_date_time){
-    uint16_t dayOfyear= uint16_t(fractional_date_time);
-    double sample_Time= fractional_date_time - dayOfyear; //0.75767778;//85986634;
-    QDateTime epoch_Time;
-
-    epoch_Time.setDate(QDate(2000 + year, 1, 1));
-    epoch_Time =epoch_Time.addDays(dayOfyear - 1);
-
-
-    uint8_t hour = 0, minute = 0, sec = 0;
-    uint16_t m_sec = 0;
-
-    double hourFraction = sample_Time*24;
-    hour = uint8_t(floor(hourFraction));
-    double minuteFraction = (hourFraction - hour)*60;
-    minute = uint8_t(floor(minuteFraction));
-    double secsFraction = (minuteFraction - minute)*60;
-    sec = uint8_t(floor(secsFraction));
-    double msecsFraction = (secsFraction - sec)*1000;
-    m_sec = uint16_t(floor(msecsFraction));
+#include "benchmark.h"
+#include "blockWriter.h"
+#include "lookAngleManifest.h"
+#include "lookAngleMatrix.h"
+#include "lookAngleRowWriter.h"
+#include "lookAngleService.h"
+#include "sampleClock.h"
+#include "sampleShards.h"
 
-    epoch_Time.setTime(QTime(hour, minute, sec, m_sec));
-
-
-    return epoch_Time;
-}
-
-QDateTime convertEpochStringToDateTime(QString epochTimeString){
-    uint8_t year = epochTimeString.left(2).toUInt();
-    double dateTimeString = epochTimeString.mid(2).toDouble();
-    return convertFractionalTimestampToDateTime(year, dateTimeString);
-}
+// Forward declaration of helper functions; see below
+void PrintPosVel(const cSatellite& sat);
+int ConvertLookAngleTable(const string& tablePath, const string& textPath);
 
 #define TILE_LINE_LENGTH    69
 bool isValidTleLine(QString line){
@@ -108,6 +87,19 @@ struct LookAngleConfiguration {
     uint32_t timeResolutionMs;
     uint8_t decimalCount;
     bool atmosphericCorrection;
+    double interpolationMaxErrorM;   // 0 = propagate every sample
+    bool passPrediction;             // only sample inside predicted passes
+    bool visibilityScreening;        // without pass prediction: skip provably invisible stretches (default on)
+    std::string tleCatalog;          // 3LE/2LE catalog file; overrides TLE_NAME/LINE1/LINE2
+    int tleNoradId;                  // catalog entry to use; 0 = first
+    std::string tleSnapshot;         // precompiled orbits of TLE_CATALOG; rebuilt when stale
+    std::string tleNoradIds;         // SITE_LIST runs: catalog entries to use; empty = all
+    std::string siteList;            // several sites at once, see lookAngleMatrix.h
+    std::string outputFormat;        // "text" (default), "binary" or "both"; see cLookAngleTable.h
+    uint32_t outputBlocks;           // text blocks in flight to the writer thread; 0 = no thread
+    uint32_t sampleThreads;          // threads computing samples; 0 = one per hardware thread
+    std::string serviceSocket;       // --serve: Unix domain socket, see lookAngleService.h
+    uint32_t serviceWorkers;         // --serve: worker threads; 0 = one per hardware thread
 };
 
 LookAngleConfiguration loadConfig(const QString& filename) {
@@ -143,6 +135,21 @@ LookAngleConfiguration loadConfig(const QString& filename) {
     cfg.timeResolutionMs = kv["TLE_TIME_RESOLUTION"].toUInt();
     cfg.atmosphericCorrection = (kv["ATMOSPHERIC_CORRECTION"] == "1");
     cfg.decimalCount = kv["DECIMAL_COUNT"].toUInt();
+    cfg.interpolationMaxErrorM = kv["INTERPOLATION_MAX_ERROR_M"].toDouble();
+    cfg.passPrediction = (kv["PASS_PREDICTION"] == "1");
+    // On unless turned off: the screening does not change the output.
+    cfg.visibilityScreening = (kv.count("VISIBILITY_SCREENING") == 0 ||
+                               kv["VISIBILITY_SCREENING"] == "1");
+    cfg.tleCatalog = kv["TLE_CATALOG"].toStdString();
+    cfg.tleNoradId = kv["TLE_NORAD_ID"].toInt();
+    cfg.tleSnapshot = kv["TLE_SNAPSHOT"].toStdString();
+    cfg.tleNoradIds = kv["TLE_NORAD_IDS"].toStdString();
+    cfg.siteList = kv["SITE_LIST"].toStdString();
+    cfg.outputFormat = kv["OUTPUT_FORMAT"].toStdString();
+    cfg.outputBlocks = kv["OUTPUT_BLOCKS"].toUInt();
+    cfg.sampleThreads = kv["SAMPLE_THREADS"].toUInt();
+    cfg.serviceSocket = kv["SERVICE_SOCKET"].toStdString();
+    cfg.serviceWorkers = kv["SERVICE_WORKERS"].toUInt();
     return cfg;
 }
 
@@ -151,6 +158,26 @@ int main(int argc, char*  argv[] )
 {
     uint64_t diffrenceInMSecsFraction = 0;
     QDateTime currentTime = QDateTime::currentDateTime();
+
+    // "--to-text <table> <text file>" rewrites a binary look-angle table
+    // in the text format.
+    if(argc > 3 && QString(argv[1]) == "--to-text"){
+        return ConvertLookAngleTable(argv[2], argv[3]);
+    }
+
+    // "--manifest <file>" runs the jobs listed in the file instead of the
+    // configuration (see lookAngleManifest.h).
+    if(argc > 2 && QString(argv[1]) == "--manifest"){
+        return RunLookAngleManifest(argv[2]);
+    }
+
+    // "--query [socket]" sends standard input to a running service (see
+    // lookAngleService.h); without the socket, SERVICE_SOCKET is used.
+    if(argc > 1 && QString(argv[1]) == "--query"){
+        std::string socketPath = (argc > 2) ? std::string(argv[2])
+                                            : loadConfig("../look_angle_configuration.txt").serviceSocket;
+        return QueryLookAngleService(socketPath);
+    }
 #if(1)
     LookAngleConfiguration cfg = loadConfig("../look_angle_configuration.txt");
     uint32_t TLE_TIME_RESOLUTION = cfg.timeResolutionMs;
@@ -165,9 +192,134 @@ int main(int argc, char*  argv[] )
     isAtmosphericCorrectionRequired = cfg.atmosphericCorrection;
     string outputFilename = cfg.outputFilename;
     uint8_t decimalCount = cfg.decimalCount;
+    double interpolationMaxErrorM = cfg.interpolationMaxErrorM;
+    bool passPrediction = cfg.passPrediction;
+    bool visibilityScreening = cfg.visibilityScreening;
+    bool textOutput = (cfg.outputFormat != "binary");
+    bool binaryOutput = (cfg.outputFormat == "binary" || cfg.outputFormat == "both");
+    uint32_t outputBlocks = cfg.outputBlocks;
+    uint32_t sampleThreads = cfg.sampleThreads;
+
+    // "--scaling" times the sample computation on 1, 2, 4, ... threads
+    // instead of writing the output.
+    bool scalingReport = (argc > 1 && QString(argv[1]) == "--scaling");
+    if(scalingReport){
+        textOutput = false;
+        binaryOutput = false;
+    }
+
+    // "--serve" keeps the satellites and sites of this configuration
+    // loaded and answers queries on SERVICE_SOCKET.
+    if(argc > 1 && QString(argv[1]) == "--serve"){
+        LookAngleServiceConfiguration serviceCfg;
+        serviceCfg.tleCatalog = cfg.tleCatalog;
+        serviceCfg.tleName = cfg.tleName;
+        serviceCfg.tleLine1 = cfg.tleLine1;
+        serviceCfg.tleLine2 = cfg.tleLine2;
+        serviceCfg.siteList = cfg.siteList;
+        serviceCfg.siteLat = cfg.siteLat;
+        serviceCfg.siteLon = cfg.siteLon;
+        serviceCfg.siteHeight = cfg.siteHeight;
+        serviceCfg.socketPath = cfg.serviceSocket;
+        serviceCfg.workers = cfg.serviceWorkers;
+        return RunLookAngleService(serviceCfg);
+    }
+
+    // With SITE_LIST set, every selected satellite is run against every
+    // listed site, one output file per pair.
+    if(!cfg.siteList.empty()){
+        LookAngleMatrixConfiguration matrixCfg;
+        matrixCfg.tleCatalog = cfg.tleCatalog;
+        matrixCfg.tleNoradIds = cfg.tleNoradIds;
+        matrixCfg.tleName = cfg.tleName;
+        matrixCfg.tleLine1 = cfg.tleLine1;
+        matrixCfg.tleLine2 = cfg.tleLine2;
+        matrixCfg.siteList = cfg.siteList;
+        matrixCfg.outputFilename = cfg.outputFilename;
+        matrixCfg.startTime = cfg.startTime;
+        matrixCfg.endTime = cfg.endTime;
+        matrixCfg.timeResolutionMs = cfg.timeResolutionMs;
+        matrixCfg.decimalCount = cfg.decimalCount;
+        matrixCfg.threads = cfg.sampleThreads;
+        // "--check-site-list" also checks every pair's file against the
+        // rows a single run of the pair writes.
+        if(argc > 1 && QString(argv[1]) == "--check-site-list"){
+            return CheckLookAngleMatrix(matrixCfg);
+        }
+        return RunLookAngleMatrix(matrixCfg);
+    }
+
+    // With TLE_CATALOG set, the element set comes from the catalog file.
+    // With TLE_SNAPSHOT also set, the orbit is restored from the snapshot,
+    // which is rewritten first if it does not match the catalog.
+    cOrbit *pSnapshotOrbit = NULL;
+    if(!cfg.tleCatalog.empty()){
+        QElapsedTimer loadTimer;
+        loadTimer.start();
+
+        cTleCatalog catalog;
+        if(!catalog.Load(cfg.tleCatalog)){
+            qDebug()<<"Cannot open TLE catalog"<<cfg.tleCatalog.c_str();
+            return -1;
+        }
+
+        qDebug()<<"Catalog"<<cfg.tleCatalog.c_str()<<":"<<catalog.Size()<<"element sets,"
+               <<catalog.Errors().size()<<"errors, loaded in"<<loadTimer.elapsed()<<"ms";
+        for(size_t ex = 0; ex < catalog.Errors().size(); ++ex){
+            const cTleCatalog::cError& error = catalog.Errors()[ex];
+            qDebug()<<"  line"<<error.m_Line<<":"<<cTleCatalog::ErrorText(error.m_Code);
+        }
+
+        size_t index = (cfg.tleNoradId > 0) ? catalog.Find(cfg.tleNoradId) : 0;
+        if(index == cTleCatalog::NOT_FOUND || index >= catalog.Size()){
+            qDebug()<<"NORAD ID"<<cfg.tleNoradId<<"not in catalog";
+            return -1;
+        }
+
+        str1 = catalog.Name(index);
+        str2 = catalog.Line1(index);
+        str3 = catalog.Line2(index);
+        cfg.tleName = str1;
+        cfg.tleLine1 = str2;
+        cfg.tleLine2 = str3;
+
+        if(!cfg.tleSnapshot.empty()){
+            QElapsedTimer snapshotTimer;
+            snapshotTimer.start();
+
+            cOrbitSnapshot snapshot;
+            if(!snapshot.Open(cfg.tleSnapshot) || !snapshot.IsCurrent(catalog)){
+                snapshot.Close();
+                if(!cOrbitSnapshot::Write(cfg.tleSnapshot, catalog) || !snapshot.Open(cfg.tleSnapshot)){
+                    qDebug()<<"Cannot write orbit snapshot"<<cfg.tleSnapshot.c_str();
+                    return -1;
+                }
+                qDebug()<<"Orbit snapshot"<<cfg.tleSnapshot.c_str()<<"rebuilt in"<<snapshotTimer.elapsed()<<"ms";
+            }
+
+            size_t record = snapshot.Find(catalog.NoradId(index));
+            if(record != cOrbitSnapshot::NOT_FOUND){
+                pSnapshotOrbit = new cOrbit(snapshot.Record(record));
+            }
+            qDebug()<<"Orbit snapshot"<<cfg.tleSnapshot.c_str()<<":"<<snapshot.Size()<<"orbits, ready in"
+                   <<snapshotTimer.elapsed()<<"ms";
+        }
+    }
+
+    if(argc > 1 && QString(argv[1]) == "--benchmark"){
+        return RunPropagationBenchmark(cfg.tleName, cfg.tleLine1, cfg.tleLine2);
+    }
 #else
     // Test SGP4 TLE data
     uint32_t TLE_TIME_RESOLUTION = 1000; //in msecs
+    double interpolationMaxErrorM = 0;
+    bool passPrediction = true;
+    bool visibilityScreening = true;
+    bool textOutput = true;
+    bool binaryOutput = false;
+    uint32_t outputBlocks = 4;
+    uint32_t sampleThreads = 0;
+    bool scalingReport = false;
     string str1 = "D091";
     string str2 = "1 44078U 19072A   25237.00127315  .00000014  00000-0  40313-4 0  1239";
     string str3 = "2 44078  98.2808 291.9629 0018719  34.1424  38.1671 14.43768520337337";
@@ -191,10 +343,11 @@ int main(int argc, char*  argv[] )
    qDebug()<<"line1"<<isValidTleLine(line1)<<"line2"<<isValidTleLine(line2)<<endl
           <<startTime<<endTime;
 
+   QDateTime epoch_Time;
    if(isValidTleLine(line1) && isValidTleLine(line2)){
     QString epochTimeString = line1.mid(18, 14);
 
-    QDateTime epoch_Time = convertEpochStringToDateTime(epochTimeString);
+    epoch_Time = convertEpochStringToDateTime(epochTimeString);
 
     if(epoch_Time.msecsTo(startTime) < 0){
         startTime = epoch_Time;
@@ -214,8 +367,10 @@ int main(int argc, char*  argv[] )
     // Create a TLE object using the data above
     cTle tleSGP4(str1, str2, str3);
 
-    // Create a satellite object from the TLE object
-    cSatellite satSGP4(tleSGP4);
+    // Create a satellite object from the TLE object, or from the orbit
+    // restored from the snapshot
+    cSatellite satSGP4 = pSnapshotOrbit ? cSatellite(*pSnapshotOrbit) : cSatellite(tleSGP4);
+    delete pSnapshotOrbit;
 
     // Print the position and velocity information of the satellite
 //    PrintPosVel(satSGP4);
@@ -240,70 +395,190 @@ int main(int argc, char*  argv[] )
     // Here we ask for the location of the satellite 90 minutes after
     // the TLE epoch.
     QFile file(outputFilename.data());
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    if (textOutput && !file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         qDebug() << "Could not open file for writing.";
         return -1;
     }
-    QTextStream out(&file);
-    out << "HH mm ss.zzz Longitude Latitude\n";
-
-    for(uint32_t ix = 0; startTime.addMSecs(ix*TLE_TIME_RESOLUTION).msecsTo(endTime) > 0 ; ++ix){
-        uint64_t currentPositionDiffrenceInMsec = diffrenceInMSecsFraction + (ix*TLE_TIME_RESOLUTION);
-        double milliSecsValue = currentPositionDiffrenceInMsec % 60000;
-        double diffrenceInMinsFraction = (uint64_t)(currentPositionDiffrenceInMsec - milliSecsValue)/60000.0;
-        milliSecsValue = milliSecsValue/1000.0f;
-        diffrenceInMinsFraction += milliSecsValue/60.0f;
-
-
-        cSite siteEquator(siteLat, siteLon, siteheight); // 0.00 N, 100.00 W, 0 km altitude
+    // Rows are formatted into a buffer that is written out in large blocks
+    // (see LookAngleRowWriter). With OUTPUT_BLOCKS set, the blocks are
+    // written by a thread of their own while the next ones are computed
+    // (see BlockWriter).
+    BlockWriter *pBlockWriter = NULL;
+    if(textOutput && outputBlocks > 0){
+        pBlockWriter = new BlockWriter(&file, outputBlocks);
+    }
+    LookAngleRowWriter *pRows = pBlockWriter ? new LookAngleRowWriter(pBlockWriter, decimalCount)
+                                             : new LookAngleRowWriter(&file, decimalCount);
+    LookAngleRowWriter& rows = *pRows;
+    if(textOutput){
+        rows.WriteText("HH mm ss.zzz Longitude Latitude\n");
+    }
 
-        cEciTime eciSGP4 = satSGP4.PositionEci(diffrenceInMinsFraction);
-        cTopo topoLook = siteEquator.GetLookAngle(eciSGP4);
+    // With INTERPOLATION_MAX_ERROR_M set, samples are interpolated between
+    // coarse propagated nodes instead (see cDenseEphemeris).
+    cDenseEphemeris *pDenseEphemeris = NULL;
+    if(interpolationMaxErrorM > 0){
+        pDenseEphemeris = new cDenseEphemeris(satSGP4.Orbit(), interpolationMaxErrorM / 1000.0);
+    }
 
-//        cEciTime eciSDP4 = satSDP4.PositionEci(diffrenceInMinsFraction);
-//        cTopo topoLook = siteEquator.GetLookAngle(eciSDP4);
+    // Sample ix is taken at startTime + ix*TLE_TIME_RESOLUTION, up to but
+    // not including endTime. Its minutes past epoch and time of day come
+    // from integer ticks (see SampleClock), not from QDateTime.
+    uint32_t sampleCount = 0;
+    SampleClock sampleClock = EpochSampleClock(str2, startTime, endTime, TLE_TIME_RESOLUTION, sampleCount);
+
+    // With OUTPUT_FORMAT binary or both, the rows, with range and range
+    // rate, also go to a binary table next to the text file: same name,
+    // extension ".lat".
+    size_t extension = outputFilename.find_last_of('.');
+    size_t directory = outputFilename.find_last_of("/\\");
+    if(extension == string::npos || (directory != string::npos && extension < directory)){
+        extension = outputFilename.size();
+    }
+    string tablePath = outputFilename.substr(0, extension) + ".lat";
+    cLookAngleTableWriter table;
+    if(binaryOutput){
+        cLookAngleTableInfo info;
+        memset(&info, 0, sizeof(info));
+        info.m_NoradId = line1.mid(2, 5).toInt();
+        info.m_DecimalCount = decimalCount;
+        strncpy(info.m_SatName, str1.c_str(), sizeof(info.m_SatName) - 1);
+        info.m_SiteLatDeg = siteLat;
+        info.m_SiteLonDeg = siteLon;
+        info.m_SiteAltKm = siteheight;
+        info.m_jdEpoch = satSGP4.Orbit().Epoch().Date();
+        info.m_msFirst = sampleClock.Tick(0);
+        info.m_msStep = TLE_TIME_RESOLUTION;
+        info.m_msEpochOfDay = sampleClock.ReferenceMsecOfDay();
+
+        if(!table.Create(tablePath, info)){
+            qDebug() << "Could not open" << tablePath.c_str() << "for writing.";
+            return -1;
+        }
+    }
+    // Ranges [first, last) of sample indices to generate. With pass
+    // prediction these are the predicted passes, widened by one sample on
+    // each side; with visibility screening, the stretches that the orbit's
+    // perigee, apogee and angular rate do not rule out (see
+    // cVisibilityScreen). Samples below the horizon are still dropped below.
+    std::vector<std::pair<uint32_t, uint32_t> > sampleRanges;
+    // The site's Earth-fixed position and topocentric rotation are set up
+    // once here and shared by the pass predictor and the sample loop.
+    cSite site(siteLat, siteLon, siteheight);
+
+    if(passPrediction && sampleCount > 0){
+        cPassPredictor predictor(satSGP4, site);
+        double mpeFirst = sampleClock.MinutesAt(0);
+        double mpeLast  = sampleClock.MinutesAt(sampleCount - 1);
+        std::vector<cPass> passes = predictor.FindPasses(mpeFirst, mpeLast);
+
+        for(size_t px = 0; px < passes.size(); ++px){
+            const cPass& pass = passes[px];
+            double firstIx = floor((pass.m_mpeAos*60000.0 - diffrenceInMSecsFraction)/TLE_TIME_RESOLUTION);
+            double lastIx  = floor((pass.m_mpeLos*60000.0 - diffrenceInMSecsFraction)/TLE_TIME_RESOLUTION) + 2;
+            uint32_t first = uint32_t(std::max(0.0, firstIx));
+            uint32_t last  = uint32_t(std::min(double(sampleCount), lastIx));
+
+            if(!sampleRanges.empty() && first <= sampleRanges.back().second){
+                sampleRanges.back().second = std::max(sampleRanges.back().second, last);
+            }else if(first < last){
+                sampleRanges.push_back(std::make_pair(first, last));
+            }
 
-        //if(topoLook.AzimuthDeg() > 0 && topoLook.ElevationDeg() > 0)
-        {
-            // Print out the results.
-//            qDebug()<<"currentTime"<<startTime.addSecs(ix*TLE_TIME_RESOLUTION).toString("hh:mm:ss.zzz")
-//                   <<"Az"<<QString::number(topoLook.AzimuthDeg(), 'f', 4)
-//                    <<"El"<<QString::number(topoLook.ElevationDeg(), 'f', 2)
-//                     <<"Speed"<<topoLook.RangeKm()<<topoLook.RangeRateKmSec()
-//                    <<"minFraction"<<diffrenceInMinsFraction;
-//            qDebug()<<"currentTime"<<startTime.addMSecs(ix*TLE_TIME_RESOLUTION).toString("hh mm ss")
-//                   <<" Az: "<<QString::number(topoLook.AzimuthDeg(), 'f', 2)
-//                    <<" El: "<<QString::number(topoLook.ElevationDeg(), 'f', 2);
+            qDebug()<<"Pass AOS"<<startTime.addMSecs(qint64(pass.m_mpeAos*60000.0 - diffrenceInMSecsFraction)).toString("hh:mm:ss.zzz")
+                   <<"TCA"<<startTime.addMSecs(qint64(pass.m_mpeTca*60000.0 - diffrenceInMSecsFraction)).toString("hh:mm:ss.zzz")
+                   <<"LOS"<<startTime.addMSecs(qint64(pass.m_mpeLos*60000.0 - diffrenceInMSecsFraction)).toString("hh:mm:ss.zzz")
+                   <<"max El"<<QString::number(rad2deg(pass.m_radMaxEl), 'f', 2);
+        }
+        qDebug()<<passes.size()<<"passes,"<<predictor.EvaluationCount()<<"elevation evaluations";
+    }else if(visibilityScreening && sampleCount > 0){
+        cVisibilityScreen screen(satSGP4.Orbit());
+        screen.AddSite(site);
+
+        std::vector<std::pair<size_t, size_t> > candidates =
+                screen.CandidateRanges(sampleClock.MinutesAt(0),
+                                       TLE_TIME_RESOLUTION / 60000.0, sampleCount);
+        uint32_t candidateCount = 0;
+
+        for(size_t cx = 0; cx < candidates.size(); ++cx){
+            sampleRanges.push_back(std::make_pair(uint32_t(candidates[cx].first),
+                                                  uint32_t(candidates[cx].second)));
+            candidateCount += uint32_t(candidates[cx].second - candidates[cx].first);
         }
-        QDateTime current = startTime.addMSecs(ix*TLE_TIME_RESOLUTION);
-        if(topoLook.AzimuthDeg() >= 0 && topoLook.ElevationDeg() >= 0){
-//            out << current.toString("yyyy-MM-dd hh:mm:ss").toStdString().c_str() << " "
-//                << QString::number(topoLook.AzimuthDeg(), 'f', 4).toStdString().c_str() << " "
-//                << QString::number(topoLook.ElevationDeg(), 'f', 4).toStdString().c_str()
-//                << "\n";
-
-            int hh   = current.time().hour();
-            int mm   = current.time().minute();
-            int ss   = current.time().second();
-            int msec = current.time().msec();
-
-            // seconds with fractional part
-            double secFrac = ss + msec / 1000.0;
-
-            // Prepare formatted output
-            QString line = QString("%1 %2 %3.%4 %5 %6")
-                .arg(hh, 2, 10, QChar('0'))    // HH
-                .arg(mm, 2, 10, QChar('0'))    // MM
-                .arg(ss, 2, 10, QChar('0'))    // SS
-                .arg(msec, 3, 10, QChar('0'))    // msec ZZZ
-                .arg(QString::number(topoLook.AzimuthDeg(), 'f', decimalCount).rightJustified(4+decimalCount, '0'))  // XXX.XXXX
-                .arg(QString::number(topoLook.ElevationDeg(), 'f', decimalCount).rightJustified(3+decimalCount, '0')); // XX.XXXX
-
-            out << line.toStdString().c_str() << "\n";
+        qDebug()<<candidateCount<<"of"<<sampleCount<<"samples kept by screening,"
+               <<screen.EvaluationCount()<<"propagations";
+    }else if(sampleCount > 0){
+        sampleRanges.push_back(std::make_pair(uint32_t(0), sampleCount));
+    }
+
+    // The samples are propagated in blocks through cSatellite::PositionEciBatch
+    // and turned into rows on SAMPLE_THREADS threads, in chunks written out
+    // in sample order (see sampleShards.h).
+    SampleShardJob job;
+    job.pSatellite = &satSGP4;
+    job.pSite = &site;
+    job.pClock = &sampleClock;
+    job.sampleCount = sampleCount;
+    job.ranges = sampleRanges;
+    job.decimalCount = decimalCount;
+    job.textRows = textOutput || scalingReport;
+    job.tableRows = binaryOutput || scalingReport;
+    job.pRows = textOutput ? pRows : NULL;
+    job.pTable = binaryOutput ? &table : NULL;
+    job.pDenseEphemeris = pDenseEphemeris;
+
+    if(scalingReport){
+        // The output is computed and dropped once per thread count,
+        // doubling up to SAMPLE_THREADS.
+        unsigned maxThreads = sampleThreads ? sampleThreads
+                                            : std::max(1u, std::thread::hardware_concurrency());
+        int64_t singleMs = 0;
+        for(unsigned threads = 1; ; threads = std::min(2*threads, maxThreads)){
+            SampleShardStats stats = RunSampleShards(job, threads);
+            if(threads == 1){
+                singleMs = std::max(int64_t(1), stats.wallMs);
+            }
+            qDebug()<<"threads"<<stats.threads<<":"<<stats.wallMs<<"ms, speedup"
+                   <<QString::number(double(singleMs) / std::max(int64_t(1), stats.wallMs), 'f', 2)
+                   <<"("<<stats.chunks<<"chunks,"<<stats.rows<<"rows,"<<stats.busyMs<<"ms busy)";
+            if(threads >= maxThreads || stats.threads < threads){
+                break;
+            }
         }
+    }else{
+        SampleShardStats stats = RunSampleShards(job, sampleThreads);
+        qDebug()<<stats.rows<<"rows from"<<stats.chunks<<"chunks on"<<stats.threads<<"threads in"
+               <<stats.wallMs<<"ms ("<<stats.busyMs<<"ms busy,"<<stats.writeWaitMs<<"ms waiting for chunks)";
     }
 
+    bool written = rows.Close();
+    delete pRows;
+    if(pBlockWriter){
+        written = pBlockWriter->Close() && written;
+        qDebug()<<"Writer thread:"<<pBlockWriter->WriteMs()<<"ms writing,"
+               <<pBlockWriter->StallMs()<<"ms waited for by the sample loop";
+        delete pBlockWriter;
+    }
+    if(textOutput && !file.flush()){
+        written = false;
+    }
+    if(!written){
+        qDebug() << "Could not write" << outputFilename.c_str();
+    }
     file.close();
+    if(binaryOutput && !table.Close()){
+        qDebug() << "Could not write" << tablePath.c_str();
+        written = false;
+    }
+    if(pDenseEphemeris){
+        qDebug()<<"Interpolated: node spacing"<<pDenseEphemeris->NodeSpacing() * 60.0<<"s,"
+               <<pDenseEphemeris->PropagationCount()<<"propagations, max error"
+               <<pDenseEphemeris->MaxErrorSeen() * 1000.0<<"m";
+        delete pDenseEphemeris;
+    }
+    if(!written){
+        return -1;
+    }
     qDebug()<<"Completed";
     return 0;
 }
@@ -359,3 +634,40 @@ void PrintPosVel(const cSatellite& sat)
 
     printf("\n");
 }
+
+/////////////////////////////////////////////////////////////////////////////
+// Rewrites a binary look-angle table (see cLookAngleTable.h) as the text
+// output of the run that wrote it.
+int ConvertLookAngleTable(const string& tablePath, const string& textPath)
+{
+    cLookAngleTable table;
+    if(!table.Open(tablePath)){
+        qDebug() << "Cannot open look-angle table" << tablePath.c_str();
+        return -1;
+    }
+
+    QFile file(textPath.data());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qDebug() << "Could not open file for writing.";
+        return -1;
+    }
+
+    const cLookAngleTableInfo& info = table.Info();
+    SampleClock clock(info.m_msEpochOfDay, info.m_msFirst, info.m_msStep);
+    LookAngleRowWriter rows(&file, uint8_t(info.m_DecimalCount));
+
+    rows.WriteText("HH mm ss.zzz Longitude Latitude\n");
+    for(size_t rx = 0; rx < table.Size(); ++rx){
+        rows.WriteRow(clock.MsecOfDay(table.TimeMs(rx)), table.AzimuthDeg(rx),
+                      table.ElevationDeg(rx));
+    }
+
+    bool ok = rows.Close() && file.flush();
+    file.close();
+    if(!ok){
+        qDebug() << "Could not write" << textPath.c_str();
+        return -1;
+    }
+    qDebug() << table.Size() << "rows written to" << textPath.c_str();
+    return 0;
+}
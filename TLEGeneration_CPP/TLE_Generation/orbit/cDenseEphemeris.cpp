@@ -0,0 +1,198 @@
+//
+// cDenseEphemeris.cpp
+//
+#include "stdafx.h"
+
+#include "cDenseEphemeris.h"
+#include "cOrbit.h"
+#include "cEci.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+// Node spacing never exceeds 1/DENSE_MIN_NODES_PER_REV of the period, and
+// a segment is halved at most DENSE_MAX_HALVINGS times.
+static const double DENSE_MIN_NODES_PER_REV = 8.0;
+static const int    DENSE_MAX_HALVINGS      = 6;
+
+//////////////////////////////////////////////////////////////////////////////
+// HermiteMidpoint()
+// Position at the middle of the cubic Hermite segment between n0 and n1,
+// h seconds apart.
+template <class NODE>
+static void HermiteMidpoint(const NODE &n0, const NODE &n1, double h,
+                            double *pPos)
+{
+   for (int i = 0; i < 3; i++)
+   {
+      pPos[i] = 0.5   * (n0.m_pos[i] + n1.m_pos[i]) +
+                0.125 * h * (n0.m_vel[i] - n1.m_vel[i]);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cDenseEphemeris::cDenseEphemeris(const cOrbit &orbit, double kmMaxError) :
+   m_Orbit(orbit),
+   m_kmMaxError(kmMaxError),
+   m_fSegment(false),
+   m_kmMaxErrorSeen(0.0),
+   m_Propagations(0)
+{
+   // The cubic Hermite error is bounded by h^4 / 384 * |x''''|. On an
+   // orbit of radius r and angular rate w, |x''''| is about w^4 * r; the
+   // perigee rate and radius give the worst case.
+   double e   = orbit.Eccentricity();
+   double r   = orbit.Perigee() + XKMPER_WGS72;
+   double w   = (orbit.MeanMotion() / 60.0) * sqr(1.0 + e) / pow(1.0 - e * e, 1.5);
+   double sec = pow(384.0 * kmMaxError / (pow(w, 4.0) * r), 0.25);
+
+   m_minStepNominal = min(sec / 60.0,
+                          orbit.Period() / 60.0 / DENSE_MIN_NODES_PER_REV);
+   m_minStepFloor   = m_minStepNominal / (1 << DENSE_MAX_HALVINGS);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PropagateNode()
+void cDenseEphemeris::PropagateNode(double mpe, cNode &node)
+{
+   cEciTime eci = m_Orbit.PositionEci(mpe, m_Context);
+
+   node.m_mpe    = mpe;
+   node.m_pos[0] = eci.Position().m_x;
+   node.m_pos[1] = eci.Position().m_y;
+   node.m_pos[2] = eci.Position().m_z;
+   node.m_vel[0] = eci.Velocity().m_x;
+   node.m_vel[1] = eci.Velocity().m_y;
+   node.m_vel[2] = eci.Velocity().m_z;
+
+   m_Propagations++;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// BuildSegment()
+// Makes m_Node0/m_Node1 a segment containing mpe. Segments follow on from
+// the current one while the samples move forward, so the node grid does
+// not depend on how the samples are split into batches.
+void cDenseEphemeris::BuildSegment(double mpe)
+{
+   if (m_fSegment && (mpe >= m_Node1.m_mpe) &&
+      (mpe < m_Node1.m_mpe + 2.0 * m_minStepNominal))
+   {
+      m_Node0 = m_Node1;
+   }
+   else
+   {
+      PropagateNode(mpe, m_Node0);
+   }
+
+   for (;;)
+   {
+      double step = m_minStepNominal;
+      cNode  mid;
+
+      PropagateNode(m_Node0.m_mpe + step, m_Node1);
+
+      // Halve the segment until its midpoint, where the interpolation
+      // error peaks, is within the limit. The old midpoint becomes the
+      // new end node.
+      for (;;)
+      {
+         double pos[3];
+
+         PropagateNode(m_Node0.m_mpe + 0.5 * step, mid);
+         HermiteMidpoint(m_Node0, m_Node1, step * 60.0, pos);
+
+         double err = sqrt(sqr(pos[0] - mid.m_pos[0]) +
+                           sqr(pos[1] - mid.m_pos[1]) +
+                           sqr(pos[2] - mid.m_pos[2]));
+
+         if ((err <= m_kmMaxError) || (step <= m_minStepFloor))
+         {
+            m_kmMaxErrorSeen = max(m_kmMaxErrorSeen, err);
+            break;
+         }
+
+         step   *= 0.5;
+         m_Node1 = mid;
+      }
+
+      m_fSegment = true;
+
+      if (mpe < m_Node1.m_mpe)
+      {
+         SetCoefficients();
+         return;
+      }
+
+      m_Node0 = m_Node1;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// SetCoefficients()
+// Expands the segment m_Node0-m_Node1 into the power basis in
+// s = (mpe - m_Node0.m_mpe) / span, so Interpolate() is two Horner chains.
+void cDenseEphemeris::SetCoefficients()
+{
+   m_minSpan = m_Node1.m_mpe - m_Node0.m_mpe;
+
+   double h = m_minSpan * 60.0;
+
+   for (int i = 0; i < 3; i++)
+   {
+      double p0 = m_Node0.m_pos[i];
+      double p1 = m_Node1.m_pos[i];
+      double m0 = h * m_Node0.m_vel[i];
+      double m1 = h * m_Node1.m_vel[i];
+
+      m_Coef[i][0] = p0;
+      m_Coef[i][1] = m0;
+      m_Coef[i][2] = 3.0 * (p1 - p0) - 2.0 * m0 - m1;
+      m_Coef[i][3] = 2.0 * (p0 - p1) + m0 + m1;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Interpolate()
+void cDenseEphemeris::Interpolate(double mpe, const cEciArrays &eci,
+                                  size_t index) const
+{
+   double s    = (mpe - m_Node0.m_mpe) / m_minSpan;
+   double rate = 1.0 / (m_minSpan * 60.0);
+   double pos[3];
+   double vel[3];
+
+   for (int i = 0; i < 3; i++)
+   {
+      const double *c = m_Coef[i];
+
+      pos[i] = ((c[3] * s + c[2]) * s + c[1]) * s + c[0];
+      vel[i] = ((3.0 * c[3] * s + 2.0 * c[2]) * s + c[1]) * rate;
+   }
+
+   eci.m_x [index] = pos[0];
+   eci.m_y [index] = pos[1];
+   eci.m_z [index] = pos[2];
+   eci.m_vx[index] = vel[0];
+   eci.m_vy[index] = vel[1];
+   eci.m_vz[index] = vel[2];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PositionEciBatch()
+void cDenseEphemeris::PositionEciBatch(const double *mpe, size_t count,
+                                       const cEciArrays &eci)
+{
+   for (size_t i = 0; i < count; i++)
+   {
+      if (!m_fSegment || (mpe[i] < m_Node0.m_mpe) || (mpe[i] >= m_Node1.m_mpe))
+      {
+         BuildSegment(mpe[i]);
+      }
+
+      Interpolate(mpe[i], eci, i);
+   }
+}
+}
+}
@@ -0,0 +1,83 @@
+//
+// cDenseEphemeris.h
+//
+// This class produces high-rate ECI ephemerides of one satellite by
+// cubic Hermite interpolation between coarse nodes propagated with
+// cOrbit::PositionEci(). Each node supplies a position and a velocity, so
+// a segment between two nodes is fully determined without a fit.
+//
+// The node spacing starts from the orbit period and the requested
+// maximum position error, and is halved for any segment whose midpoint
+// (where the Hermite error term peaks) differs from direct propagation
+// by more than that error. Each segment therefore costs two propagations
+// however many samples are taken from it.
+//
+// SGP4/SDP4 solve Kepler's equation to 1e-6 rad, so their own output
+// jitters by several metres; limits much below 10 m are not meaningful.
+// Where the model itself is discontinuous (e.g. SDP4 at near-zero
+// inclination) the error can exceed the limit; MaxErrorSeen() reports it.
+//
+// An instance holds the current segment and a propagation context, so
+// it must not be shared between threads; the cOrbit may be.
+//
+#pragma once
+
+#include "cNoradBase.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+class cOrbit;
+struct cEciArrays;
+
+//////////////////////////////////////////////////////////////////////////////
+class cDenseEphemeris
+{
+public:
+   // kmMaxError - maximum position error of any interpolated sample, km.
+   cDenseEphemeris(const cOrbit &orbit, double kmMaxError);
+
+   // Same contract as cOrbit::PositionEciBatch(): the ECI position (km)
+   // and velocity (km/sec) at each mpe[i] are written to element i of
+   // "eci". Increasing times reuse the current segment's nodes.
+   void PositionEciBatch(const double *mpe, size_t count,
+                         const cEciArrays &eci);
+
+   double MaxError()         const { return m_kmMaxError;     }  // km
+   double MaxErrorSeen()     const { return m_kmMaxErrorSeen; }  // km, at checked midpoints
+   double NodeSpacing()      const { return m_minStepNominal; }  // minutes
+   size_t PropagationCount() const { return m_Propagations;   }
+
+protected:
+   struct cNode
+   {
+      double m_mpe;
+      double m_pos[3];   // km
+      double m_vel[3];   // km/sec
+   };
+
+   void PropagateNode(double mpe, cNode &node);
+   void BuildSegment(double mpe);
+   void SetCoefficients();
+   void Interpolate(double mpe, const cEciArrays &eci, size_t index) const;
+
+   const cOrbit       &m_Orbit;
+   cPropagationContext m_Context;
+
+   double m_kmMaxError;
+   double m_minStepNominal;   // starting node spacing, minutes
+   double m_minStepFloor;     // smallest spacing halving may reach
+
+   bool   m_fSegment;         // true once m_Node0/m_Node1 are valid
+   cNode  m_Node0;
+   cNode  m_Node1;
+   double m_minSpan;          // m_Node1.m_mpe - m_Node0.m_mpe
+   double m_Coef[3][4];       // per axis, km, in powers of the segment fraction
+
+   double m_kmMaxErrorSeen;
+   size_t m_Propagations;
+};
+}
+}
@@ -0,0 +1,456 @@
+//
+// cLookAngleEngine.cpp
+//
+#include "stdafx.h"
+
+#include <mutex>
+
+#include "cLookAngleEngine.h"
+#include "cGmstGrid.h"
+#include "cNoradSDP4.h"
+#include "cSatellite.h"
+#include "cSite.h"
+#include "cVisibilityScreen.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+// Grid points per propagation block
+static const size_t ENGINE_BLOCK_SIZE = 1024;
+
+// Estimated cost per grid point, in SGP4 propagations (about 60 ns with
+// the AVX2 kernel). SDP4 adds the lunar-solar periodics to every point;
+// with resonance, the secular integrator as well.
+static const double ENGINE_COST_SGP4      = 1.0;
+static const double ENGINE_COST_SDP4      = 8.5;
+static const double ENGINE_COST_SDP4_RESO = 10.0;
+
+// Per site: mostly the below-horizon test
+static const double ENGINE_COST_SITE = 0.25;
+
+// Chunks are sized for about this many tasks per thread, and hold at most
+// ENGINE_MAX_CHUNK_BLOCKS blocks, which bounds the output held for
+// delivery.
+static const size_t ENGINE_TASKS_PER_THREAD = 8;
+static const size_t ENGINE_MAX_CHUNK_BLOCKS = 16;
+
+//////////////////////////////////////////////////////////////////////////////
+// Grid points [m_First, m_Last) of satellite m_Sat, the m_Index'th chunk
+// of its output. The GMST rotation at m_First is stepped from point
+// m_GridFirst, where a grid walking all the points recomputes it exactly.
+struct cLookAngleEngine::cChunk
+{
+   size_t m_Sat;
+   size_t m_Index;
+   size_t m_First;
+   size_t m_Last;
+   size_t m_GridFirst;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Look angles of a chunk from every site: 4 arrays of m_Length per site.
+// m_Count points from m_First were propagated; if fewer than the chunk,
+// the next one failed with m_Message.
+struct cLookAngleEngine::cResult
+{
+   vector<double> m_Topo;
+   size_t         m_First;
+   size_t         m_Length;
+   size_t         m_Count;
+   bool           m_fFailed;
+   string         m_Message;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Delivery state of a satellite: chunks before m_Next have been passed to
+// the sink; finished later ones wait in m_Waiting.
+struct cLookAngleEngine::cSatelliteState
+{
+   cSatelliteState() : m_Next(0), m_fStopped(false) { }
+
+   std::mutex       m_Mutex;
+   vector<cResult*> m_Waiting;
+   size_t           m_Next;
+   bool             m_fStopped;    // failed, or all chunks delivered
+};
+
+//////////////////////////////////////////////////////////////////////////////
+cLookAngleEngine::cLookAngleEngine() :
+   m_fVisibleOnly(false),
+   m_Threads(1)
+{
+   m_Stats.m_Threads = 0;
+   m_Stats.m_Tasks   = 0;
+   m_Stats.m_Steals  = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// AddSatellite()
+size_t cLookAngleEngine::AddSatellite(const cSatellite &sat, int64_t msFirst,
+                                      uint32_t msStep, size_t count)
+{
+   cGrid grid;
+
+   grid.m_msFirst = msFirst;
+   grid.m_msStep  = msStep;
+   grid.m_Count   = count;
+
+   m_Sats.push_back(&sat);
+   m_Grids.push_back(grid);
+
+   return m_Sats.size() - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// AddSite()
+size_t cLookAngleEngine::AddSite(const cSite &site)
+{
+   m_Sites.push_back(&site);
+
+   return m_Sites.size() - 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PropagationCost()
+double cLookAngleEngine::PropagationCost(const cSatellite &sat)
+{
+   if (!sat.Orbit().IsDeepSpace())
+   {
+      return ENGINE_COST_SGP4;
+   }
+
+   const cNoradSDP4 *pSdp4 = dynamic_cast<const cNoradSDP4*>(&sat.Orbit().NoradModel());
+
+   if (pSdp4 && (pSdp4->DeepElements().gp_reso || pSdp4->DeepElements().gp_sync))
+   {
+      return ENGINE_COST_SDP4_RESO;
+   }
+
+   return ENGINE_COST_SDP4;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// AlignRanges()
+// Widens the ranges of grid points [first, last) to start at a multiple
+// of cNoradBase::BATCH_GROUP and end at one or at "count", merging those
+// that then overlap.
+static void AlignRanges(vector<pair<size_t, size_t> > &ranges, size_t count)
+{
+   const size_t group = cNoradBase::BATCH_GROUP;
+   size_t       used  = 0;
+
+   for (size_t r = 0; r < ranges.size(); r++)
+   {
+      size_t first = ranges[r].first - ranges[r].first % group;
+      size_t last  = min(count, ranges[r].second + (group - ranges[r].second % group) % group);
+
+      if ((used > 0) && (first <= ranges[used - 1].second))
+      {
+         ranges[used - 1].second = max(ranges[used - 1].second, last);
+      }
+      else
+      {
+         ranges[used++] = make_pair(first, last);
+      }
+   }
+
+   ranges.resize(used);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Run()
+void cLookAngleEngine::Run(cLookAngleSink &sink)
+{
+   cTaskScheduler scheduler(m_Threads);
+
+   // The stretches of each satellite's grid to propagate. In visible-only
+   // mode, those in which the satellite cannot be above any site's
+   // horizon are left out, and the rest widened to whole batch groups.
+   vector<vector<pair<size_t, size_t> > > ranges(m_Sats.size());
+
+   scheduler.Run(vector<double>(m_Sats.size(), 1.0), [&](size_t sat, unsigned)
+   {
+      const cGrid &grid = m_Grids[sat];
+
+      if (m_fVisibleOnly)
+      {
+         cVisibilityScreen screen(m_Sats[sat]->Orbit());
+
+         for (size_t site = 0; site < m_Sites.size(); site++)
+         {
+            screen.AddSite(*m_Sites[site]);
+         }
+
+         ranges[sat] = screen.CandidateRanges(MinutesPast(grid.m_msFirst),
+                                              grid.m_msStep / 60000.0, grid.m_Count);
+         AlignRanges(ranges[sat], grid.m_Count);
+      }
+      else if (grid.m_Count > 0)
+      {
+         ranges[sat].push_back(make_pair((size_t)0, grid.m_Count));
+      }
+   });
+
+   // Chunk size: whole blocks, about ENGINE_TASKS_PER_THREAD tasks per
+   // thread over all satellites
+   vector<double> pointCost(m_Sats.size());
+   double         totalCost = 0.0;
+
+   for (size_t sat = 0; sat < m_Sats.size(); sat++)
+   {
+      pointCost[sat] = PropagationCost(*m_Sats[sat]) + ENGINE_COST_SITE * m_Sites.size();
+
+      for (size_t r = 0; r < ranges[sat].size(); r++)
+      {
+         totalCost += pointCost[sat] * (ranges[sat][r].second - ranges[sat][r].first);
+      }
+   }
+
+   double chunkCost = totalCost / (scheduler.Threads() * ENGINE_TASKS_PER_THREAD);
+
+   vector<cChunk> chunks;
+   vector<double> chunkCosts;
+   vector<size_t> chunkCounts(m_Sats.size(), 0);
+
+   for (size_t sat = 0; sat < m_Sats.size(); sat++)
+   {
+      double blocks = floor(chunkCost / (pointCost[sat] * ENGINE_BLOCK_SIZE));
+      size_t size   = ENGINE_BLOCK_SIZE *
+                      (size_t)max(1.0, min((double)ENGINE_MAX_CHUNK_BLOCKS, blocks));
+
+      for (size_t r = 0; r < ranges[sat].size(); r++)
+      {
+         for (size_t first = ranges[sat][r].first; first < ranges[sat][r].second; first += size)
+         {
+            cChunk chunk;
+
+            chunk.m_Sat       = sat;
+            chunk.m_Index     = chunkCounts[sat]++;
+            chunk.m_First     = first;
+            chunk.m_Last      = min(ranges[sat][r].second, first + size);
+            chunk.m_GridFirst = first - first % cGmstGrid::DEFAULT_RESYNC;
+
+            chunks.push_back(chunk);
+            chunkCosts.push_back(pointCost[sat] * (chunk.m_Last - chunk.m_First));
+         }
+      }
+   }
+
+   vector<cSatelliteState> states(m_Sats.size());
+
+   for (size_t sat = 0; sat < m_Sats.size(); sat++)
+   {
+      states[sat].m_Waiting.assign(chunkCounts[sat], (cResult*)NULL);
+
+      if (chunkCounts[sat] == 0)
+      {
+         states[sat].m_fStopped = true;
+         sink.SatelliteDone(sat);
+      }
+   }
+
+   scheduler.Run(chunkCosts, [&](size_t task, unsigned)
+   {
+      const cChunk &chunk = chunks[task];
+
+      RunChunk(chunk, states[chunk.m_Sat], sink);
+   });
+
+   m_Stats = scheduler.Stats();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PropagateEach()
+// Propagates samples one at a time until one fails, and returns the
+// number that succeeded.
+static size_t PropagateEach(const cSatellite &satellite, const double *mpe,
+                            size_t count, const cEciArrays &eci,
+                            cPropagationContext &context)
+{
+   for (size_t i = 0; i < count; i++)
+   {
+      try
+      {
+         cEciTime e = satellite.PositionEci(mpe[i], context);
+
+         eci.m_x [i] = e.Position().m_x;
+         eci.m_y [i] = e.Position().m_y;
+         eci.m_z [i] = e.Position().m_z;
+         eci.m_vx[i] = e.Velocity().m_x;
+         eci.m_vy[i] = e.Velocity().m_y;
+         eci.m_vz[i] = e.Velocity().m_z;
+      }
+      catch (cPropagationException &)
+      {
+         return i;
+      }
+   }
+
+   return count;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// RunChunk()
+void cLookAngleEngine::RunChunk(const cChunk &chunk, cSatelliteState &state,
+                                cLookAngleSink &sink) const
+{
+   {
+      lock_guard<mutex> lock(state.m_Mutex);
+
+      if (state.m_fStopped)
+      {
+         return;
+      }
+   }
+
+   const cSatellite &satellite = *m_Sats[chunk.m_Sat];
+   const cGrid      &grid      = m_Grids[chunk.m_Sat];
+   size_t            length    = chunk.m_Last - chunk.m_First;
+
+   cGmstGrid           gmstGrid(satellite.Orbit().Epoch(), MinutesPast(grid.m_msFirst),
+                                grid.m_msStep / 60000.0);
+   cPropagationContext context;
+
+   for (size_t i = chunk.m_GridFirst; i < chunk.m_First; i++)
+   {
+      gmstGrid.At(i);
+   }
+
+   vector<double>        mpe(ENGINE_BLOCK_SIZE);
+   vector<double>        stateVectors(6 * ENGINE_BLOCK_SIZE);
+   vector<cGmstRotation> rot(ENGINE_BLOCK_SIZE, cGmstRotation(0.0));
+
+   double *pState = &stateVectors[0];
+   cEciArrays eci = { pState,
+                      pState + 1 * ENGINE_BLOCK_SIZE,
+                      pState + 2 * ENGINE_BLOCK_SIZE,
+                      pState + 3 * ENGINE_BLOCK_SIZE,
+                      pState + 4 * ENGINE_BLOCK_SIZE,
+                      pState + 5 * ENGINE_BLOCK_SIZE };
+
+   cResult *pResult = new cResult;
+
+   pResult->m_Topo.resize(4 * length * m_Sites.size());
+   pResult->m_First   = chunk.m_First;
+   pResult->m_Length  = length;
+   pResult->m_Count   = 0;
+   pResult->m_fFailed = false;
+
+   for (size_t first = chunk.m_First; first < chunk.m_Last; first += ENGINE_BLOCK_SIZE)
+   {
+      size_t n = min(ENGINE_BLOCK_SIZE, chunk.m_Last - first);
+
+      for (size_t i = 0; i < n; i++)
+      {
+         mpe[i] = MinutesPast(grid.m_msFirst + (int64_t)(first + i) * grid.m_msStep);
+         rot[i] = gmstGrid.At(first + i);
+      }
+
+      try
+      {
+         satellite.PositionEciBatch(&mpe[0], n, eci, context);
+      }
+      catch (cPropagationException &e)
+      {
+         // Keep the samples before the failure: redo the block one sample
+         // at a time up to it.
+         pResult->m_fFailed = true;
+         pResult->m_Message = e.Message();
+         n = PropagateEach(satellite, &mpe[0], n, eci, context);
+      }
+
+      // ECI to Earth-fixed, in place, once for all sites
+      cEcef::FromEciBatch(eci, &rot[0], n, eci);
+
+      size_t offset = first - chunk.m_First;
+
+      for (size_t site = 0; (site < m_Sites.size()) && (n > 0); site++)
+      {
+         double *pTopo = &pResult->m_Topo[4 * length * site];
+         cTopoArrays topo = { pTopo + offset,
+                              pTopo + offset + 1 * length,
+                              pTopo + offset + 2 * length,
+                              pTopo + offset + 3 * length };
+
+         m_Sites[site]->GetLookAngleBatch(eci, n, topo, m_fVisibleOnly);
+      }
+
+      pResult->m_Count = offset + n;
+
+      if (pResult->m_fFailed)
+      {
+         break;
+      }
+   }
+
+   Deliver(chunk, pResult, state, sink);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Deliver()
+// Passes the satellite's finished chunks to the sink, in order, as far
+// as they go without a gap.
+void cLookAngleEngine::Deliver(const cChunk &chunk, cResult *pResult,
+                               cSatelliteState &state, cLookAngleSink &sink) const
+{
+   lock_guard<mutex> lock(state.m_Mutex);
+
+   if (state.m_fStopped)
+   {
+      delete pResult;
+      return;
+   }
+
+   state.m_Waiting[chunk.m_Index] = pResult;
+
+   while ((state.m_Next < state.m_Waiting.size()) && state.m_Waiting[state.m_Next])
+   {
+      cResult *pNext = state.m_Waiting[state.m_Next];
+
+      state.m_Waiting[state.m_Next] = NULL;
+
+      size_t length = pNext->m_Length;
+      size_t first  = pNext->m_First;
+
+      for (size_t site = 0; (site < m_Sites.size()) && (pNext->m_Count > 0); site++)
+      {
+         double *pTopo = &pNext->m_Topo[4 * length * site];
+         cTopoArrays topo = { pTopo,
+                              pTopo + 1 * length,
+                              pTopo + 2 * length,
+                              pTopo + 3 * length };
+
+         sink.Write(chunk.m_Sat, site, first, pNext->m_Count, topo);
+      }
+
+      state.m_Next++;
+
+      if (pNext->m_fFailed)
+      {
+         sink.SatelliteFailed(chunk.m_Sat, first + pNext->m_Count, pNext->m_Message);
+         state.m_fStopped = true;
+      }
+
+      delete pNext;
+
+      if (state.m_fStopped)
+      {
+         break;
+      }
+   }
+
+   if (state.m_fStopped || (state.m_Next == state.m_Waiting.size()))
+   {
+      for (size_t i = 0; i < state.m_Waiting.size(); i++)
+      {
+         delete state.m_Waiting[i];
+         state.m_Waiting[i] = NULL;
+      }
+
+      state.m_fStopped = true;
+      sink.SatelliteDone(chunk.m_Sat);
+   }
+}
+}
+}
@@ -0,0 +1,152 @@
+//
+// cLookAngleEngine.h
+//
+// This class computes the look angles of a set of satellites from a set
+// of ground sites, each satellite over a uniform time grid of its own in
+// integer milliseconds past its epoch. For each satellite, every
+// grid point is propagated once and rotated once into the Earth-fixed
+// frame; the sites then only apply their cached Earth-fixed transform
+// (cSite::GetLookAngleBatch()). The cost is one propagation per satellite
+// and time, plus a short look-angle kernel per satellite, site and time.
+//
+// The grid of each satellite is cut into chunks of whole propagation
+// blocks, and the (satellite, chunk) tasks are run by a cTaskScheduler on
+// SetThreads() threads. The tasks are weighted by their estimated cost:
+// grid points times the per-point cost of the satellite's orbit model
+// (SDP4 costs about eight SGP4 propagations, more with the resonance
+// integrator) and of the sites' look angles. Chunks are sized so that
+// each thread gets several tasks, which lets a deep-space satellite be
+// spread over all threads instead of finishing alone at the end.
+//
+// A chunk starts with its own propagation context (SDP4 resumes from its
+// checkpoints) and GMST grid, stepped from the last multiple of
+// cGmstGrid::DEFAULT_RESYNC at or before its first point. The stretches
+// of the grid that are propagated start at a multiple of
+// cNoradBase::BATCH_GROUP and end at one or at the end of the grid. The
+// value at a grid point therefore depends only on its index, not on the
+// number of threads, the chunk size or which stretches visibility
+// screening kept. The minutes past epoch are derived from the integer
+// times (MinutesPast()), and the GMST grid runs from the epoch, as in the
+// application's single-satellite sample loop, so a satellite and site
+// get the same look angles from either.
+//
+// The results for each (satellite, site) pair are passed to a
+// cLookAngleSink in time order: a finished chunk is held until the
+// satellite's earlier chunks have been delivered.
+//
+// The satellites and sites are referenced, not copied, and must outlive
+// the engine.
+//
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "cNoradBase.h"
+#include "cTaskScheduler.h"
+#include "coord.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+class cSatellite;
+class cSite;
+
+//////////////////////////////////////////////////////////////////////////////
+// class cLookAngleSink
+// Receives the engine's output. Calls for one satellite are never made
+// at the same time, but with more than one thread, calls for different
+// satellites can be, and satellites are not delivered in index order.
+class cLookAngleSink
+{
+public:
+   virtual ~cLookAngleSink() {}
+
+   // Look angles of satellite "sat" from site "site" at grid points
+   // [first, first + count). Successive calls for a pair are in time
+   // order, but may leave gaps in visible-only mode.
+   virtual void Write(size_t sat, size_t site, size_t first, size_t count,
+                      const cTopoArrays &topo) = 0;
+
+   // Satellite "sat" is complete; no more output follows for it.
+   virtual void SatelliteDone(size_t /*sat*/) {}
+
+   // Satellite "sat" could not be propagated at grid point "first". Its
+   // output ends there; SatelliteDone() follows.
+   virtual void SatelliteFailed(size_t /*sat*/, size_t /*first*/,
+                                const string &/*message*/) {}
+};
+
+//////////////////////////////////////////////////////////////////////////////
+class cLookAngleEngine
+{
+public:
+   cLookAngleEngine();
+
+   // Returns the index used for the satellite or site in the sink calls.
+   // Grid point i of the satellite is "msFirst + i * msStep" milliseconds
+   // past its epoch, for i in [0, count).
+   size_t AddSatellite(const cSatellite &sat, int64_t msFirst,
+                       uint32_t msStep, size_t count);
+   size_t AddSite(const cSite &site);
+
+   // Skip the full look-angle evaluation of samples below the horizon;
+   // their elevation is reported as cSite::BELOW_HORIZON (see
+   // cSite::GetLookAngleBatch()). Stretches of the grid in which a
+   // satellite cannot be visible from any site (see cVisibilityScreen)
+   // are then not delivered to the sink at all. Off by default.
+   void SetVisibleOnly(bool fVisibleOnly) { m_fVisibleOnly = fVisibleOnly; }
+
+   // Threads to run on; 0 uses one per hardware thread. 1 by default.
+   void SetThreads(unsigned threads) { m_Threads = threads; }
+
+   size_t SatelliteCount() const { return m_Sats.size();  }
+   size_t SiteCount()      const { return m_Sites.size(); }
+
+   void Run(cLookAngleSink &sink);
+
+   // Scheduling of the last Run()'s chunks
+   const cTaskScheduler::cStats& Stats() const { return m_Stats; }
+
+   // Estimated cost of propagating the satellite to one grid point, in
+   // SGP4 propagations.
+   static double PropagationCost(const cSatellite &sat);
+
+   // Minutes past epoch of a time "ms" milliseconds past it: whole
+   // minutes plus the remaining milliseconds, so that long runs keep
+   // millisecond resolution.
+   static double MinutesPast(int64_t ms)
+   {
+      return (double)(ms / 60000) + ((double)(ms % 60000) / 1000.0) / 60.0;
+   }
+
+protected:
+   struct cChunk;
+   struct cResult;
+   struct cSatelliteState;
+
+   // A satellite's time grid
+   struct cGrid
+   {
+      int64_t  m_msFirst;
+      uint32_t m_msStep;
+      size_t   m_Count;
+   };
+
+   void RunChunk(const cChunk &chunk, cSatelliteState &state,
+                 cLookAngleSink &sink) const;
+
+   void Deliver(const cChunk &chunk, cResult *pResult,
+                cSatelliteState &state, cLookAngleSink &sink) const;
+
+   std::vector<const cSatellite*> m_Sats;
+   std::vector<cGrid>             m_Grids;
+   std::vector<const cSite*>      m_Sites;
+   bool                           m_fVisibleOnly;
+   unsigned                       m_Threads;
+   cTaskScheduler::cStats         m_Stats;
+};
+}
+}
@@ -32,21 +32,33 @@ namespace Zeptomoby
 namespace OrbitTools
 {
 
+const size_t cNoradBase::BATCH_GROUP;
+
 //////////////////////////////////////////////////////////////////////////////
 cNoradBase::cNoradBase(const cOrbit &orbit) :
-   m_Orbit(orbit)
+   m_Orbit(orbit),
+   m_El()
 {
    // Initialize any variables which are time-independent when
    // calculating the ECI coordinates of the satellite.
-   m_sinio = sin(m_Orbit.Inclination());
-   m_cosio = cos(m_Orbit.Inclination());
-
-   double theta2 = m_cosio * m_cosio;
+   m_El.m_xmo    = m_Orbit.MeanAnomaly();
+   m_El.m_omegao = m_Orbit.ArgPerigee();
+   m_El.m_xnodeo = m_Orbit.RAAN();
+   m_El.m_eo     = m_Orbit.Eccentricity();
+   m_El.m_xincl  = m_Orbit.Inclination();
+   m_El.m_bstar  = m_Orbit.BStar();
+   m_El.m_aodp   = m_Orbit.SemiMajor();
+   m_El.m_xnodp  = m_Orbit.MeanMotion();
+
+   m_El.m_sinio = sin(m_Orbit.Inclination());
+   m_El.m_cosio = cos(m_Orbit.Inclination());
+
+   double theta2 = m_El.m_cosio * m_El.m_cosio;
    double x3thm1 = 3.0 * theta2 - 1.0;
    double eosq   = sqr(m_Orbit.Eccentricity());
 
-   m_betao2 = 1.0 - eosq;
-   m_betao  = sqrt(m_betao2);
+   m_El.m_betao2 = 1.0 - eosq;
+   m_El.m_betao  = sqrt(m_El.m_betao2);
 
    // For perigee below 156 km, the values of S and QOMS2T are altered.
    double rp      = m_Orbit.SemiMajor() * (1.0 - m_Orbit.Eccentricity());
@@ -55,55 +67,55 @@ cNoradBase::cNoradBase(const cOrbit &orbit) :
    double Qo = AE + 120.0 / XKMPER_WGS72;
    double S  = AE +  78.0 / XKMPER_WGS72;
 
-   m_s4     = S;
-   m_qoms24 = pow((Qo - S), 4); //(QO - S)^4 ER^4
+   m_El.m_s4     = S;
+   m_El.m_qoms24 = pow((Qo - S), 4); //(QO - S)^4 ER^4
 
-   m_s4      = S;
-   m_qoms24  = QOMS2T;
+   m_El.m_s4      = S;
+   m_El.m_qoms24  = QOMS2T;
 
    if (perigee < 156.0)
    {
-      m_s4 = perigee - 78.0;
+      m_El.m_s4 = perigee - 78.0;
 
       if (perigee <= 98.0)
       {
-         m_s4 = 20.0;
+         m_El.m_s4 = 20.0;
       }
 
-      m_qoms24 = pow((120.0 - m_s4) * AE / XKMPER_WGS72, 4.0);
-      m_s4 = m_s4 / XKMPER_WGS72 + AE;
+      m_El.m_qoms24 = pow((120.0 - m_El.m_s4) * AE / XKMPER_WGS72, 4.0);
+      m_El.m_s4 = m_El.m_s4 / XKMPER_WGS72 + AE;
    }
 
-   const double pinvsq = 1.0 / (sqr(m_Orbit.SemiMajor()) * sqr(m_betao2));
+   const double pinvsq = 1.0 / (sqr(m_Orbit.SemiMajor()) * sqr(m_El.m_betao2));
 
-   m_tsi   = 1.0 / (m_Orbit.SemiMajor() - m_s4);
-   m_eta   = m_Orbit.SemiMajor() * m_Orbit.Eccentricity() * m_tsi;
-   m_eeta  = m_Orbit.Eccentricity() * m_eta;
+   m_El.m_tsi   = 1.0 / (m_Orbit.SemiMajor() - m_El.m_s4);
+   m_El.m_eta   = m_Orbit.SemiMajor() * m_Orbit.Eccentricity() * m_El.m_tsi;
+   m_El.m_eeta  = m_Orbit.Eccentricity() * m_El.m_eta;
 
-   const double etasq = m_eta * m_eta;
+   const double etasq = m_El.m_eta * m_El.m_eta;
    const double psisq = fabs(1.0 - etasq);
 
-   m_coef  = m_qoms24 * pow(m_tsi, 4.0);
-   m_coef1 = m_coef   / pow(psisq, 3.5);
+   m_El.m_coef  = m_El.m_qoms24 * pow(m_El.m_tsi, 4.0);
+   m_El.m_coef1 = m_El.m_coef   / pow(psisq, 3.5);
 
-   const double c2 = m_coef1 * m_Orbit.MeanMotion() * 
-                     (m_Orbit.SemiMajor() * (1.0 + 1.5 * etasq + m_eeta * (4.0 + etasq)) +
-                     0.75 * CK2 * m_tsi / psisq * x3thm1 * 
+   const double c2 = m_El.m_coef1 * m_Orbit.MeanMotion() * 
+                     (m_Orbit.SemiMajor() * (1.0 + 1.5 * etasq + m_El.m_eeta * (4.0 + etasq)) +
+                     0.75 * CK2 * m_El.m_tsi / psisq * x3thm1 * 
                      (8.0 + 3.0 * etasq * (8.0 + etasq)));
 
-   m_c1 = m_Orbit.BStar() * c2;
-   m_a3ovk2 = -XJ3 / CK2 * pow(AE,3.0);
+   m_El.m_c1 = m_Orbit.BStar() * c2;
+   m_El.m_a3ovk2 = -XJ3 / CK2 * pow(AE,3.0);
 
-   m_c3 = m_coef * m_tsi * m_a3ovk2 * m_Orbit.MeanMotion() * AE * m_sinio / m_Orbit.Eccentricity();
+   m_El.m_c3 = m_El.m_coef * m_El.m_tsi * m_El.m_a3ovk2 * m_Orbit.MeanMotion() * AE * m_El.m_sinio / m_Orbit.Eccentricity();
 
    const double x1mth2 = 1.0 - theta2;
-   m_c4     = 2.0 * m_Orbit.MeanMotion() * m_coef1 * m_Orbit.SemiMajor() * m_betao2 * 
-              (m_eta * (2.0 + 0.5 * etasq) +
+   m_El.m_c4     = 2.0 * m_Orbit.MeanMotion() * m_El.m_coef1 * m_Orbit.SemiMajor() * m_El.m_betao2 * 
+              (m_El.m_eta * (2.0 + 0.5 * etasq) +
               m_Orbit.Eccentricity() * (0.5 + 2.0 * etasq) - 
-              2.0 * CK2 * m_tsi / (m_Orbit.SemiMajor() * psisq) *
-              (-3.0 * x3thm1 * (1.0 - 2.0 * m_eeta + etasq * (1.5 - 0.5 * m_eeta)) +
+              2.0 * CK2 * m_El.m_tsi / (m_Orbit.SemiMajor() * psisq) *
+              (-3.0 * x3thm1 * (1.0 - 2.0 * m_El.m_eeta + etasq * (1.5 - 0.5 * m_El.m_eeta)) +
               0.75 * x1mth2 * 
-              (2.0 * etasq - m_eeta * (1.0 + etasq)) * 
+              (2.0 * etasq - m_El.m_eeta * (1.0 + etasq)) * 
               cos(2.0 * m_Orbit.ArgPerigee())));
 
    const double theta4 = theta2 * theta2;
@@ -111,22 +123,40 @@ cNoradBase::cNoradBase(const cOrbit &orbit) :
    const double temp2  = temp1 * CK2 * pinvsq;
    const double temp3  = 1.25 * CK4 * pinvsq * pinvsq * m_Orbit.MeanMotion();;
 
-   m_xmdot = m_Orbit.MeanMotion() + 0.5 * temp1 * m_betao * x3thm1 +
-             0.0625 * temp2 * m_betao * 
+   m_El.m_xmdot = m_Orbit.MeanMotion() + 0.5 * temp1 * m_El.m_betao * x3thm1 +
+             0.0625 * temp2 * m_El.m_betao * 
              (13.0 - 78.0 * theta2 + 137.0 * theta4);
 
    const double x1m5th = 1.0 - 5.0 * theta2;
 
-   m_omgdot = -0.5 * temp1 * x1m5th + 0.0625 * temp2 * 
+   m_El.m_omgdot = -0.5 * temp1 * x1m5th + 0.0625 * temp2 * 
               (7.0 - 114.0 * theta2 +  395.0 * theta4) +
               temp3 * (3.0 - 36.0 * theta2 + 49.0 * theta4);
 
-   const double xhdot1 = -temp1 * m_cosio;
+   const double xhdot1 = -temp1 * m_El.m_cosio;
+
+   m_El.m_xnodot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * theta2) +
+              2.0 * temp3 * (3.0 - 7.0 * theta2)) * m_El.m_cosio;
+   m_El.m_xnodcf = 3.5 * m_El.m_betao2 * xhdot1 * m_El.m_c1;
+   m_El.m_t2cof  = 1.5 * m_El.m_c1;
+
+   // Long period periodics and short periodics coefficients used by
+   // FinalPosition(). These depend only on the epoch inclination.
+   m_El.m_aycof  = 0.25 * m_El.m_a3ovk2 * m_El.m_sinio;
+   m_El.m_xlcof  = (0.125 * m_El.m_a3ovk2 * m_El.m_sinio * (3.0 + 5.0 * m_El.m_cosio)) / 
+                   (1.0 + m_El.m_cosio);
+   m_El.m_x3thm1 = x3thm1;
+   m_El.m_x1mth2 = x1mth2;
+   m_El.m_x7thm1 = 7.0 * theta2 - 1.0;
+}
 
-   m_xnodot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * theta2) +
-              2.0 * temp3 * (3.0 - 7.0 * theta2)) * m_cosio;
-   m_xnodcf = 3.5 * m_betao2 * xhdot1 * m_c1;
-   m_t2cof  = 1.5 * m_c1;
+//////////////////////////////////////////////////////////////////////////////
+// Restores the time-independent variables computed by an earlier instance
+// for the same orbit.
+cNoradBase::cNoradBase(const cOrbit &orbit, const cNoradElements &el) :
+   m_Orbit(orbit),
+   m_El(el)
+{
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -140,14 +170,62 @@ cNoradBase& cNoradBase::operator=(const cNoradBase &b)
 }
 
 //////////////////////////////////////////////////////////////////////////////
-cEciTime cNoradBase::FinalPosition(double incl, double  omega, 
-                                   double    e, double      a,
-                                   double   xl, double  xnode, 
-                                   double   xn, double tsince)
+// GetPosition()
+// Returns the ECI position (AE) and velocity (AE/min) for the satellite
+// at the given number of minutes since the TLE epoch time.
+cEciTime cNoradBase::GetPosition(double tsince) const
+{
+   cPropagationContext context;
+
+   return GetPosition(tsince, context);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cEciTime cNoradBase::GetPosition(double tsince, 
+                                 cPropagationContext &context) const
+{
+   double x, y, z, xdot, ydot, zdot;
+   cEciArrays eciOut = { &x, &y, &z, &xdot, &ydot, &zdot };
+
+   GetPositionBatch(&tsince, 1, eciOut, context);
+
+   cVector vecPos(x, y, z);
+   cVector vecVel(xdot, ydot, zdot);
+
+   cJulian gmt = m_Orbit.Epoch();
+   gmt.AddMin(tsince);
+
+   cEciTime eci = cEciTime(vecPos, vecVel, gmt);
+
+   return eci;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// GetPositionBatch()
+void cNoradBase::GetPositionBatch(const double *tsince, size_t count,
+                                  const cEciArrays &eci) const
+{
+   cPropagationContext context;
+
+   GetPositionBatch(tsince, count, eci, context);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// FinalPosition()
+// Stores the position (AE) and velocity (AE/min) in element "index" of
+// the given arrays. Only the element record is used, so the calculation
+// can be run without the owning cOrbit. On failure the output arrays are
+// left untouched and the reason is returned; see ThrowPositionError().
+cNoradBase::ePositionStatus 
+cNoradBase::FinalPosition(const cNoradElements &el,
+                          double incl, double  omega, 
+                          double    e, double      a,
+                          double   xl, double  xnode, double xn,
+                          const cEciArrays &eci, size_t index)
 {
    if ((e * e) > 1.0)
    {
-      throw cPropagationException("Error in satellite data");
+      return POS_ERROR;
    }
 
    double beta = sqrt(1.0 - e * e);
@@ -156,13 +234,8 @@ cEciTime cNoradBase::FinalPosition(double incl, double  omega,
    double axn  = e * cos(omega);
    double temp = 1.0 / (a * beta * beta);
 
-   double sinip = sin(m_Orbit.Inclination());
-   double cosip = cos(m_Orbit.Inclination());
-   double aycof = 0.25 * m_a3ovk2 * sinip;
-   double xlcof = (0.125 * m_a3ovk2 * sinip * (3.0 + 5.0 * cosip)) / 
-                  (1.0 + cosip);
-   double xll  = temp * xlcof * axn;
-   double aynl = temp * aycof;
+   double xll  = temp * el.m_xlcof * axn;
+   double aynl = temp * el.m_aycof;
    double xlt  = xl + xll;
    double ayn  = e * sin(omega) + aynl;
 
@@ -226,15 +299,14 @@ cEciTime cNoradBase::FinalPosition(double incl, double  omega,
    temp2 = temp1 * temp;
 
    // Update for short periodics 
-   double cosip2 = cosip * cosip;
-   double x3thm1 = 3.0 * cosip2 - 1.0;
-   double x1mth2 = 1.0 - cosip2;
-   double x7thm1 = 7.0 * cosip2 - 1.0;
+   const double x3thm1 = el.m_x3thm1;
+   const double x1mth2 = el.m_x1mth2;
+   const double x7thm1 = el.m_x7thm1;
    double rk = r * (1.0 - 1.5 * temp2 * betal * x3thm1) + 
                0.5 * temp1 * x1mth2 * cos2u;
    double uk = u - 0.25 * temp2 * x7thm1 * sin2u;
-   double xnodek = xnode + 1.5 * temp2 * m_cosio * sin2u;
-   double xinck  = incl + 1.5 * temp2 * m_cosio * m_sinio * cos2u;
+   double xnodek = xnode + 1.5 * temp2 * el.m_cosio * sin2u;
+   double xinck  = incl + 1.5 * temp2 * el.m_cosio * el.m_sinio * cos2u;
    double rdotk  = rdot - xn * temp1 * x1mth2 * sin2u;
    double rfdotk = rfdot + xn * temp1 * (x1mth2 * cos2u + 1.5 * x3thm1);
 
@@ -259,17 +331,12 @@ cEciTime cNoradBase::FinalPosition(double incl, double  omega,
    double y = rk * uy;
    double z = rk * uz;
 
-   cVector vecPos(x, y, z);
-
    // Validate on altitude
-   double altKm = (vecPos.Magnitude() * (XKMPER_WGS72 / AE));
+   double altKm = (sqrt(x * x + y * y + z * z) * (XKMPER_WGS72 / AE));
 
    if (altKm < XKMPER_WGS72)
    {
-      cJulian decayTime = m_Orbit.Epoch();
-
-      decayTime.AddMin(tsince);
-      throw cDecayException(decayTime, m_Orbit.SatName(true));
+      return POS_DECAYED;
    }
    
    // Velocity
@@ -277,14 +344,30 @@ cEciTime cNoradBase::FinalPosition(double incl, double  omega,
    double ydot = rdotk * uy + rfdotk * vy;
    double zdot = rdotk * uz + rfdotk * vz;
 
-   cVector vecVel(xdot, ydot, zdot);
+   eci.m_x [index] = x;
+   eci.m_y [index] = y;
+   eci.m_z [index] = z;
+   eci.m_vx[index] = xdot;
+   eci.m_vy[index] = ydot;
+   eci.m_vz[index] = zdot;
 
-   cJulian gmt = m_Orbit.Epoch();
-   gmt.AddMin(tsince);
+   return POS_OK;
+}
 
-   cEciTime eci = cEciTime(vecPos, vecVel, gmt);
+//////////////////////////////////////////////////////////////////////////////
+// ThrowPositionError()
+// Throws the exception matching a failed FinalPosition() status.
+void cNoradBase::ThrowPositionError(ePositionStatus status, double tsince) const
+{
+   if (status == POS_DECAYED)
+   {
+      cJulian decayTime = m_Orbit.Epoch();
 
-   return eci;
+      decayTime.AddMin(tsince);
+      throw cDecayException(decayTime, m_Orbit.SatName(true));
+   }
+
+   throw cPropagationException("Error in satellite data");
 }
 }
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 //
 #pragma once
 
+#include <stddef.h>
+
 //////////////////////////////////////////////////////////////////////////////
 
 namespace Zeptomoby 
@@ -19,36 +21,116 @@ namespace OrbitTools
 
 class cEciTime;
 class cOrbit;
+struct cEciArrays;
+
+//////////////////////////////////////////////////////////////////////////////
+// struct cNoradElements
+// The "compiled" element record of an orbit: every quantity the SGP4/SDP4
+// position calculation needs that does not depend on the propagation time.
+// The record is filled in once by the model constructors and is only read
+// from afterwards.
+struct cNoradElements
+{
+   // Recovered elements, copied from cOrbit (radians, AE, rads/min)
+   double m_xmo;     double m_omegao;  double m_xnodeo;
+   double m_eo;      double m_xincl;   double m_bstar;
+   double m_aodp;    double m_xnodp;
+
+   // Common SGP4/SDP4 terms (cNoradBase)
+   double m_cosio;   double m_sinio;   
+   double m_betao2;  double m_betao;   double m_s4;
+   double m_qoms24;  double m_tsi;     double m_eta;
+   double m_eeta;    double m_coef;    double m_coef1;
+   double m_c1;      double m_c3;      double m_c4; 
+   double m_a3ovk2;  double m_xmdot;   double m_omgdot;
+   double m_xnodot;  double m_xnodcf;  double m_t2cof;
+
+   // Long- and short-period terms used by FinalPosition()
+   double m_aycof;   double m_xlcof;
+   double m_x3thm1;  double m_x1mth2;  double m_x7thm1;
+
+   // SGP4-only terms (cNoradSGP4); zero for SDP4 orbits
+   bool   m_isimp;
+   double m_c5;      double m_omgcof;  double m_xmcof;
+   double m_delmo;   double m_sinmo;
+   double m_d2;      double m_d3;      double m_d4;
+   double m_t3cof;   double m_t4cof;   double m_t5cof;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// struct cPropagationContext
+// The mutable part of a propagation, owned by the caller. Only the SDP4
+// resonance integrator has any state: the (atime, xli, xni) point it last
+// reached, from which the next query continues when that is no further
+// from the target than the model's nearest checkpoint. The orbit models
+// are otherwise immutable, so threads can share one cOrbit as long as
+// each passes its own context. A default-constructed context (atime 0)
+// holds no state and is started from a checkpoint.
+struct cPropagationContext
+{
+   cPropagationContext() : m_atime(0.0), m_xli(0.0), m_xni(0.0) { }
+
+   double m_atime;   // integrator time, minutes since epoch
+   double m_xli;
+   double m_xni;
+};
 
 //////////////////////////////////////////////////////////////////////////////
 
 class cNoradBase
 {
 public:
+   // Outcome of a single position calculation.
+   enum ePositionStatus
+   {
+      POS_OK,
+      POS_ERROR,     // eccentricity out of range ("Error in satellite data")
+      POS_DECAYED    // satellite is below the surface of the earth
+   };
+
    cNoradBase(const cOrbit&);
+   cNoradBase(const cOrbit&, const cNoradElements &el);
    virtual ~cNoradBase() { }
 
-   virtual cEciTime GetPosition(double tsince) = 0;
+   // The forms without a context use a fresh one for each call.
+   cEciTime GetPosition(double tsince) const;
+   cEciTime GetPosition(double tsince, cPropagationContext &context) const;
+
+   // Batch form of GetPosition(). Writes the ECI position (AE) and
+   // velocity (AE/min) for each tsince[i] into element i of "eci".
+   void GetPositionBatch(const double *tsince, size_t count,
+                         const cEciArrays &eci) const;
+   virtual void GetPositionBatch(const double *tsince, size_t count,
+                                 const cEciArrays &eci,
+                                 cPropagationContext &context) const = 0;
+
+   // A batch may evaluate its samples in groups, counted from its start,
+   // by a kernel whose results differ in the last bits from those of a
+   // single GetPosition() (see cNoradSGP4::GetPositionBatch()). Batches
+   // cut from a time grid at multiples of BATCH_GROUP, and at its end,
+   // give each grid point the same result however the grid is cut.
+   static const size_t BATCH_GROUP = 8;
 
    virtual cNoradBase* Clone(const cOrbit&) = 0;
 
+   const cNoradElements& Elements() const { return m_El; }
+
 protected:
    cNoradBase& operator=(const cNoradBase&);
 
-   cEciTime FinalPosition(double incl, double omega, double  e, double    a, 
-                          double   xl, double xnode, double xn, double tsince);
+   static ePositionStatus FinalPosition(const cNoradElements &el,
+                                        double incl, double omega, 
+                                        double    e, double     a, 
+                                        double   xl, double xnode, double xn,
+                                        const cEciArrays &eci, size_t index);
+
+   void ThrowPositionError(ePositionStatus status, double tsince) const;
 
    const cOrbit &m_Orbit;
 
    // Orbital parameter variables which need only be calculated one
    // time for a given orbit (ECI position time-independent).
-   double m_cosio;   double m_sinio;   
-   double m_betao2;  double m_betao;   double m_s4;
-   double m_qoms24;  double m_tsi;     double m_eta;
-   double m_eeta;    double m_coef;    double m_coef1;
-   double m_c1;      double m_c3;      double m_c4; 
-   double m_a3ovk2;  double m_xmdot;   double m_omgdot;
-   double m_xnodot;  double m_xnodcf;  double m_t2cof;
+   cNoradElements m_El;
 };
 }
 }
\ No newline at end of file
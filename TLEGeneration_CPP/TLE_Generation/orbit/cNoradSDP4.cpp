@@ -24,7 +24,8 @@ static const double thdt = 4.3752691e-03;
 
 //////////////////////////////////////////////////////////////////////////////
 cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
-   cNoradBase(orbit)
+   cNoradBase(orbit),
+   cDeepElements()
 {
    double sinarg = sin(m_Orbit.ArgPerigee());
    double cosarg = cos(m_Orbit.ArgPerigee());
@@ -38,7 +39,7 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
    double eq     = m_Orbit.Eccentricity();
    double aqnv   = 1.0 / m_Orbit.SemiMajor();
    double xmao   = m_Orbit.MeanAnomaly();
-   double xpidot = m_omgdot + m_xnodot;
+   double xpidot = m_El.m_omgdot + m_El.m_xnodot;
    double sinq   = sin(m_Orbit.RAAN());
    double cosq   = cos(m_Orbit.RAAN());
 
@@ -100,10 +101,10 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
       double a9  = zsing * zsinh + zcosg * zcosi * zcosh;
       double a10 = zcosg * zsini;
 
-      double a2 = m_cosio * a7 +  m_sinio * a8;
-      double a4 = m_cosio * a9 +  m_sinio * a10;
-      double a5 = -m_sinio * a7 +  m_cosio * a8;
-      double a6 = -m_sinio * a9 +  m_cosio * a10;
+      double a2 = m_El.m_cosio * a7 +  m_El.m_sinio * a8;
+      double a4 = m_El.m_cosio * a9 +  m_El.m_sinio * a10;
+      double a5 = -m_El.m_sinio * a7 +  m_El.m_cosio * a8;
+      double a6 = -m_El.m_sinio * a9 +  m_El.m_cosio * a10;
       double x1 = a1 * cosarg + a2 * sinarg;
       double x2 = a3 * cosarg + a4 * sinarg;
       double x3 = -a1 * sinarg + a2 * cosarg;
@@ -126,12 +127,12 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
       double z22 = 6.0*(a4 * a5 + a2 * a6) +
                    eqsq * (24.0 * (x2 * x5 + x1 * x6) - 6.0 * (x4 * x7 + x3 * x8));
       double z23 = 6.0 * a4 * a6 + eqsq*(24.0 * x2 * x6 - 6.0 * x4 * x8);
-      z1 = z1 + z1 + m_betao2 * z31;
-      z2 = z2 + z2 + m_betao2 * z32;
-      z3 = z3 + z3 + m_betao2 * z33;
+      z1 = z1 + z1 + m_El.m_betao2 * z31;
+      z2 = z2 + z2 + m_El.m_betao2 * z32;
+      z3 = z3 + z3 + m_El.m_betao2 * z33;
       double s3  = cc * xnoi;
-      double s2  = -0.5 * s3 / m_betao;
-      double s4  = s3 * m_betao;
+      double s2  = -0.5 * s3 / m_El.m_betao;
+      double s4  = s3 * m_El.m_betao;
       double s1  = -15.0 * eq * s4;
       double s5  = x1 * x3 + x2 * x4;
       double s6  = x2 * x3 + x1 * x4;
@@ -166,8 +167,8 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
          dp_sse = se;
          dp_ssi = si;
          dp_ssl = sl;
-         dp_ssh = sh / m_sinio;
-         dp_ssg = sgh - m_cosio * dp_ssh;
+         dp_ssh = sh / m_El.m_sinio;
+         dp_ssg = sgh - m_El.m_cosio * dp_ssh;
          dp_se2 = dp_ee2;
          dp_si2 = dp_xi2;
          dp_sl2 = dp_xl2;
@@ -198,8 +199,8 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
    dp_sse = dp_sse + se;
    dp_ssi = dp_ssi + si;
    dp_ssl = dp_ssl + sl;
-   dp_ssg = dp_ssg + sgh - m_cosio / m_sinio * sh;
-   dp_ssh = dp_ssh + sh / m_sinio;
+   dp_ssg = dp_ssg + sgh - m_El.m_cosio / m_El.m_sinio * sh;
+   dp_ssh = dp_ssh + sh / m_El.m_sinio;
 
    // Geopotential resonance initialization
    gp_reso = false;
@@ -224,10 +225,10 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
 
       double g300 = 1.0 + eqsq * (-6.0 + 6.60937 * eqsq);
 
-      f220 = 0.75 * (1.0 + m_cosio) * (1.0 + m_cosio);
+      f220 = 0.75 * (1.0 + m_El.m_cosio) * (1.0 + m_El.m_cosio);
 
-      double f311 = 0.9375 * m_sinio * m_sinio * (1.0 + 3 * m_cosio) - 0.75 * (1.0 + m_cosio);
-      double f330 = 1.0 + m_cosio;
+      double f311 = 0.9375 * m_El.m_sinio * m_El.m_sinio * (1.0 + 3 * m_El.m_cosio) - 0.75 * (1.0 + m_El.m_cosio);
+      double f330 = 1.0 + m_El.m_cosio;
 
       const double q22 = 1.7891679e-06;
       const double q31 = 2.1460748e-06;   
@@ -239,7 +240,7 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
       dp_del3 = 3.0 * dp_del1 * f330 * g300 * q33 * aqnv;
       dp_del1 = dp_del1 * f311 * g310 * q31 * aqnv;
       dp_xlamo = xmao + m_Orbit.RAAN() + m_Orbit.ArgPerigee() - dp_thgr;
-      bfact = m_xmdot + xpidot - thdt;
+      bfact = m_El.m_xmdot + xpidot - thdt;
       bfact = bfact + dp_ssl + dp_ssg + dp_ssh;
    }
    else if (((m_Orbit.MeanMotion() >= 8.26E-03) && (m_Orbit.MeanMotion() <= 9.24E-03)) && (eq >= 0.5))
@@ -298,10 +299,10 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
          g532 = -40023.88  + 170470.89 * eq - 242699.48 * eqsq + 115605.82 * eoc;
       }
 
-      double sini2  = sqr(m_sinio);
-      double theta2 = sqr(m_cosio);
+      double sini2  = sqr(m_El.m_sinio);
+      double theta2 = sqr(m_El.m_cosio);
 
-      f220 = 0.75 * (1.0 + 2.0 * m_cosio + theta2);
+      f220 = 0.75 * (1.0 + 2.0 * m_El.m_cosio + theta2);
 
       const double root22 = 1.7891679e-06;
       const double root32 = 3.7393792e-07;
@@ -310,16 +311,16 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
       const double root54 = 2.1765803e-09;   
 
       double f221 = 1.5 * sini2;
-      double f321 =  1.875 * m_sinio * (1.0 - 2.0 * m_cosio - 3.0 * theta2);
-      double f322 = -1.875 * m_sinio * (1.0 + 2.0 * m_cosio - 3.0 * theta2);
+      double f321 =  1.875 * m_El.m_sinio * (1.0 - 2.0 * m_El.m_cosio - 3.0 * theta2);
+      double f322 = -1.875 * m_El.m_sinio * (1.0 + 2.0 * m_El.m_cosio - 3.0 * theta2);
       double f441 = 35.0 * sini2 * f220;
       double f442 = 39.3750 * sini2 * sini2;
-      double f522 = 9.84375 * m_sinio * (sini2 * (1.0 - 2.0 * m_cosio - 5.0 * theta2) +
-                    0.33333333*(-2.0 + 4.0 * m_cosio + 6.0 * theta2));
-      double f523 = m_sinio * (4.92187512 * sini2 * (-2.0 - 4.0 * m_cosio + 10.0 * theta2) +
-                    6.56250012 * (1.0 + 2.0 * m_cosio - 3.0 * theta2));
-      double f542 = 29.53125 * m_sinio * ( 2.0 - 8.0 * m_cosio + theta2 * (-12.0 + 8.0 * m_cosio + 10.0 * theta2));
-      double f543 = 29.53125 * m_sinio * (-2.0 - 8.0 * m_cosio + theta2 * ( 12.0 + 8.0 * m_cosio - 10.0 * theta2));
+      double f522 = 9.84375 * m_El.m_sinio * (sini2 * (1.0 - 2.0 * m_El.m_cosio - 5.0 * theta2) +
+                    0.33333333*(-2.0 + 4.0 * m_El.m_cosio + 6.0 * theta2));
+      double f523 = m_El.m_sinio * (4.92187512 * sini2 * (-2.0 - 4.0 * m_El.m_cosio + 10.0 * theta2) +
+                    6.56250012 * (1.0 + 2.0 * m_El.m_cosio - 3.0 * theta2));
+      double f542 = 29.53125 * m_El.m_sinio * ( 2.0 - 8.0 * m_El.m_cosio + theta2 * (-12.0 + 8.0 * m_El.m_cosio + 10.0 * theta2));
+      double f543 = 29.53125 * m_El.m_sinio * (-2.0 - 8.0 * m_El.m_cosio + theta2 * ( 12.0 + 8.0 * m_El.m_cosio - 10.0 * theta2));
       double xno2 = m_Orbit.MeanMotion() * m_Orbit.MeanMotion();
       double ainv2 = aqnv * aqnv;
       double temp1 = 3.0 * xno2 * ainv2;
@@ -343,7 +344,7 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
       dp_d5421 = temp * f542 * g521;
       dp_d5433 = temp * f543 * g533;
       dp_xlamo = xmao + m_Orbit.RAAN() + m_Orbit.RAAN() - dp_thgr - dp_thgr;
-      bfact = m_xmdot + m_xnodot + m_xnodot - thdt - thdt;
+      bfact = m_El.m_xmdot + m_El.m_xnodot + m_El.m_xnodot - thdt - thdt;
       bfact = bfact + dp_ssl + dp_ssh + dp_ssh;
    }
 
@@ -351,10 +352,8 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
    {
       dp_xfact = bfact - m_Orbit.MeanMotion();
 
-      // Initialize integrator 
-      dp_xli   = dp_xlamo;
-      dp_xni   = m_Orbit.MeanMotion();
-      dp_atime = 0.0;
+      // Initialize integrator; the integrator itself starts from
+      // (dp_xlamo, xnodp) at epoch in each cPropagationContext.
       dp_stepp = 720.0;
       dp_stepn = -720.0;
       dp_step2 = 259200.0;
@@ -362,15 +361,20 @@ cNoradSDP4::cNoradSDP4(const cOrbit &orbit) :
    else
    {
       dp_xfact = 0.0;
-      dp_xli   = 0.0;
-      dp_xni   = 0.0;
-      dp_atime = 0.0;
       dp_stepp = 0.0;
       dp_stepn = 0.0;
       dp_step2 = 0.0;
    }
 }
 
+//////////////////////////////////////////////////////////////////////////////
+cNoradSDP4::cNoradSDP4(const cOrbit &orbit, const cNoradElements &el,
+                       const cDeepElements &deep) :
+   cNoradBase(orbit, el),
+   cDeepElements(deep)
+{
+}
+
 //////////////////////////////////////////////////////////////////////////////
 cNoradSDP4::~cNoradSDP4()
 {
@@ -378,7 +382,8 @@ cNoradSDP4::~cNoradSDP4()
 
 
 //////////////////////////////////////////////////////////////////////////////
-bool cNoradSDP4::DeepCalcDotTerms(double *pxndot, double *pxnddt, double *pxldot)
+bool cNoradSDP4::DeepCalcDotTerms(double *pxndot, double *pxnddt, double *pxldot,
+                                  const cPropagationContext &ctx) const
 {
    const double fasx2 = 0.13130908;
    const double fasx4 = 2.8843198;
@@ -387,12 +392,12 @@ bool cNoradSDP4::DeepCalcDotTerms(double *pxndot, double *pxnddt, double *pxldot
    // Dot terms calculated 
    if (gp_sync)
    {
-      *pxndot = dp_del1 * sin(dp_xli - fasx2) + 
-                dp_del2 * sin(2.0 * (dp_xli - fasx4)) +
-                dp_del3 * sin(3.0 * (dp_xli - fasx6));
-      *pxnddt = dp_del1 * cos(dp_xli - fasx2) +
-                2.0 * dp_del2 * cos(2.0 * (dp_xli - fasx4)) +
-                3.0 * dp_del3 * cos(3.0 * (dp_xli - fasx6));
+      *pxndot = dp_del1 * sin(ctx.m_xli - fasx2) + 
+                dp_del2 * sin(2.0 * (ctx.m_xli - fasx4)) +
+                dp_del3 * sin(3.0 * (ctx.m_xli - fasx6));
+      *pxnddt = dp_del1 * cos(ctx.m_xli - fasx2) +
+                2.0 * dp_del2 * cos(2.0 * (ctx.m_xli - fasx4)) +
+                3.0 * dp_del3 * cos(3.0 * (ctx.m_xli - fasx6));
    }
    else
    {
@@ -402,34 +407,34 @@ bool cNoradSDP4::DeepCalcDotTerms(double *pxndot, double *pxnddt, double *pxldot
       const double g52 = 1.0508330;      
       const double g54 = 4.4108898;
 
-      double xomi  = m_Orbit.ArgPerigee() + m_omgdot * dp_atime;
+      double xomi  = m_El.m_omegao + m_El.m_omgdot * ctx.m_atime;
       double x2omi = xomi + xomi;
-      double x2li  = dp_xli + dp_xli;
+      double x2li  = ctx.m_xli + ctx.m_xli;
 
-      *pxndot = dp_d2201 * sin(x2omi + dp_xli - g22) + 
-                dp_d2211 * sin(dp_xli - g22)         +
-                dp_d3210 * sin( xomi + dp_xli - g32) +
-                dp_d3222 * sin(-xomi + dp_xli - g32) +
+      *pxndot = dp_d2201 * sin(x2omi + ctx.m_xli - g22) + 
+                dp_d2211 * sin(ctx.m_xli - g22)         +
+                dp_d3210 * sin( xomi + ctx.m_xli - g32) +
+                dp_d3222 * sin(-xomi + ctx.m_xli - g32) +
                 dp_d4410 * sin(x2omi + x2li - g44)   +
                 dp_d4422 * sin(x2li - g44)           +
-                dp_d5220 * sin( xomi + dp_xli - g52) +
-                dp_d5232 * sin(-xomi + dp_xli - g52) +
+                dp_d5220 * sin( xomi + ctx.m_xli - g52) +
+                dp_d5232 * sin(-xomi + ctx.m_xli - g52) +
                 dp_d5421 * sin( xomi + x2li - g54)   +
                 dp_d5433 * sin(-xomi + x2li - g54);
 
-      *pxnddt = dp_d2201 * cos(x2omi + dp_xli - g22) +
-                dp_d2211 * cos(dp_xli - g22)         +
-                dp_d3210 * cos( xomi + dp_xli - g32) +
-                dp_d3222 * cos(-xomi + dp_xli - g32) +
-                dp_d5220 * cos( xomi + dp_xli - g52) +
-                dp_d5232 * cos(-xomi + dp_xli - g52) +
+      *pxnddt = dp_d2201 * cos(x2omi + ctx.m_xli - g22) +
+                dp_d2211 * cos(ctx.m_xli - g22)         +
+                dp_d3210 * cos( xomi + ctx.m_xli - g32) +
+                dp_d3222 * cos(-xomi + ctx.m_xli - g32) +
+                dp_d5220 * cos( xomi + ctx.m_xli - g52) +
+                dp_d5232 * cos(-xomi + ctx.m_xli - g52) +
                 2.0 * (dp_d4410 * cos(x2omi + x2li - g44) +
                 dp_d4422 * cos(x2li - g44)         +
                 dp_d5421 * cos( xomi + x2li - g54) +
                 dp_d5433 * cos(-xomi + x2li - g54));
    }
 
-   *pxldot = dp_xni + dp_xfact;
+   *pxldot = ctx.m_xni + dp_xfact;
    *pxnddt = (*pxnddt) * (*pxldot);
 
    return true;
@@ -437,26 +442,101 @@ bool cNoradSDP4::DeepCalcDotTerms(double *pxndot, double *pxnddt, double *pxldot
 
 //////////////////////////////////////////////////////////////////////////////
 void cNoradSDP4::DeepCalcIntegrator(double *pxndot, double *pxnddt, 
-                                    double *pxldot, double delt)
+                                    double *pxldot, double delt,
+                                    cPropagationContext &ctx) const
 {
-   DeepCalcDotTerms(pxndot, pxnddt, pxldot);
+   DeepCalcDotTerms(pxndot, pxnddt, pxldot, ctx);
 
-   dp_xli = dp_xli + (*pxldot) * delt + (*pxndot) * dp_step2;
-   dp_xni = dp_xni + (*pxndot) * delt + (*pxnddt) * dp_step2;
-   dp_atime = dp_atime + delt;
+   ctx.m_xli   = ctx.m_xli + (*pxldot) * delt + (*pxndot) * dp_step2;
+   ctx.m_xni   = ctx.m_xni + (*pxndot) * delt + (*pxnddt) * dp_step2;
+   ctx.m_atime = ctx.m_atime + delt;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// DeepCanContinue()
+// True if the integrator may step from the context's state to tsince: the
+// state is on the same side of epoch, not past tsince, and at least as
+// close to it as the nearest checkpoint.
+bool cNoradSDP4::DeepCanContinue(double tsince, 
+                                 const cPropagationContext &ctx) const
+{
+   if ((ctx.m_atime == 0.0)                     ||
+      ((tsince >= 0.0) && (ctx.m_atime <  0.0)) ||
+      ((tsince <  0.0) && (ctx.m_atime >= 0.0)))
+   {
+      return false;
+   }
+
+   double span = DP_CHECKPOINT_STEPS * dp_stepp;
+   double cp   = floor(fabs(tsince) / span) * span;
+
+   return (fabs(ctx.m_atime) <= fabs(tsince)) && (fabs(ctx.m_atime) >= cp);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// DeepLoadCheckpoint()
+// Sets the context to the last checkpoint at or before tsince (counting
+// outward from epoch), integrating any missing checkpoints first.
+void cNoradSDP4::DeepLoadCheckpoint(double tsince, 
+                                    cPropagationContext &ctx) const
+{
+   size_t k = (size_t)(fabs(tsince) / (DP_CHECKPOINT_STEPS * dp_stepp));
+
+   // Epoch restart 
+   if (k == 0)
+   {
+      ctx.m_atime = 0.0;
+      ctx.m_xni   = m_El.m_xnodp;
+      ctx.m_xli   = dp_xlamo;
+
+      return;
+   }
+
+   double delt = (tsince < 0.0) ? dp_stepn : dp_stepp;
+   vector<cPropagationContext> &table = (tsince < 0.0) ? dp_cpBackward 
+                                                       : dp_cpForward;
+
+   lock_guard<mutex> lock(dp_cpMutex);
+
+   while (table.size() < k)
+   {
+      cPropagationContext cp;
+
+      if (table.empty())
+      {
+         cp.m_atime = 0.0;
+         cp.m_xni   = m_El.m_xnodp;
+         cp.m_xli   = dp_xlamo;
+      }
+      else
+      {
+         cp = table.back();
+      }
+
+      double xndot, xnddt, xldot;
+
+      for (int step = 0; step < DP_CHECKPOINT_STEPS; step++)
+      {
+         DeepCalcIntegrator(&xndot, &xnddt, &xldot, delt, cp);
+      }
+
+      table.push_back(cp);
+   }
+
+   ctx = table[k - 1];
 }
 
 //////////////////////////////////////////////////////////////////////////////
 bool cNoradSDP4::DeepSecular(double *xmdf, double *omgadf, double *xnode,
                              double *emm,  double *xincc,  double *xnn,
-                             double tsince)
+                             double tsince, cPropagationContext &ctx) const
 {
    // Deep space secular effects 
    *xmdf   = (*xmdf)   + dp_ssl * tsince;
    *omgadf = (*omgadf) + dp_ssg * tsince;
    *xnode  = (*xnode)  + dp_ssh * tsince;
-   *emm    = m_Orbit.Eccentricity() + dp_sse * tsince;
-   *xincc  = m_Orbit.Inclination()  + dp_ssi * tsince;
+   *emm    = m_El.m_eo + dp_sse * tsince;
+   *xincc  = m_El.m_xincl  + dp_ssi * tsince;
 
    if ((*xincc) < 0.0)
    {
@@ -469,66 +549,29 @@ bool cNoradSDP4::DeepSecular(double *xmdf, double *omgadf, double *xnode,
    double xndot = 0.0;
    double xldot = 0.0;
    double ft    = 0.0;
-   double delt  = 0.0;
-
-   bool fDone = false;
+   double delt  = (tsince < 0.0) ? dp_stepn : dp_stepp;
 
    if (gp_reso) 
    {
-      while (!fDone)
+      // The integrator only ever steps away from epoch, so the state at a
+      // given atime does not depend on the order of earlier queries.
+      if (!DeepCanContinue(tsince, ctx))
       {
-         if ((dp_atime == 0.0)                     ||
-            ((tsince >= 0.0) && (dp_atime <  0.0)) ||
-            ((tsince <  0.0) && (dp_atime >= 0.0)))
-         {
-            delt = (tsince < 0) ? dp_stepn : dp_stepp;
-
-            // Epoch restart 
-            dp_atime = 0.0;
-            dp_xni = m_Orbit.MeanMotion();
-            dp_xli = dp_xlamo;
-
-            fDone = true;
-         }
-         else
-         {
-            if (fabs(tsince) < fabs(dp_atime))
-            {
-               delt = dp_stepp;
-
-               if (tsince >= 0.0)
-               {
-                  delt = dp_stepn;
-               }
-
-               DeepCalcIntegrator(&xndot, &xnddt, &xldot, delt);
-            }
-            else
-            {
-               delt = dp_stepn;
-
-               if (tsince > 0.0)
-               {
-                  delt = dp_stepp;
-               }
-
-               fDone = true;
-            }
-         }
+         DeepLoadCheckpoint(tsince, ctx);
       }
 
-      while (fabs(tsince - dp_atime) >= dp_stepp)
+      while (fabs(tsince - ctx.m_atime) >= dp_stepp)
       {
-         DeepCalcIntegrator(&xndot, &xnddt, &xldot, delt);
+         DeepCalcIntegrator(&xndot, &xnddt, &xldot, delt, ctx);
       }
 
-      ft = tsince - dp_atime;
+      ft = tsince - ctx.m_atime;
 
-      DeepCalcDotTerms(&xndot, &xnddt, &xldot);
+      DeepCalcDotTerms(&xndot, &xnddt, &xldot, ctx);
 
-      *xnn = dp_xni + xndot * ft + xnddt * ft * ft * 0.5;
+      *xnn = ctx.m_xni + xndot * ft + xnddt * ft * ft * 0.5;
 
-      double xl   = dp_xli + xldot * ft + xndot * ft * ft * 0.5;
+      double xl   = ctx.m_xli + xldot * ft + xndot * ft * ft * 0.5;
       double temp = -(*xnode) + dp_thgr + tsince * thdt;
 
       *xmdf = xl - (*omgadf) + temp;
@@ -545,7 +588,7 @@ bool cNoradSDP4::DeepSecular(double *xmdf, double *omgadf, double *xnode,
 //////////////////////////////////////////////////////////////////////////////
 bool cNoradSDP4::DeepPeriodics(double *e,      double *xincc,
                                double *omgadf, double *xnode,
-                               double *xmam,   double tsince)
+                               double *xmam,   double tsince) const
 {
    // Lunar-solar periodics 
    double sinis = sin(*xincc);
@@ -598,11 +641,11 @@ bool cNoradSDP4::DeepPeriodics(double *e,      double *xincc,
    *xincc = (*xincc) + pinc;
    *e  = (*e) + pe;
 
-   if (m_Orbit.Inclination() >= 0.2)
+   if (m_El.m_xincl >= 0.2)
    {
       // Apply periodics directly 
-      ph  = ph / m_sinio;
-      pgh = pgh - m_cosio * ph;
+      ph  = ph / m_El.m_sinio;
+      pgh = pgh - m_El.m_cosio * ph;
       *omgadf = (*omgadf) + pgh;
       *xnode  = (*xnode) + ph;
       *xmam   = (*xmam) + pl;
@@ -633,40 +676,57 @@ bool cNoradSDP4::DeepPeriodics(double *e,      double *xincc,
 }
 
 //////////////////////////////////////////////////////////////////////////////
+// GetPositionBatch()
 // This procedure returns the ECI position and velocity for the satellite
-// in the orbit at the given number of minutes since the TLE epoch time
+// in the orbit at the given numbers of minutes since the TLE epoch time
 // using the NORAD Simplified General Perturbation 4, "deep space" orbit
 // model.
 //
-// tsince - Time in minutes since the TLE epoch (GMT).
-cEciTime cNoradSDP4::GetPosition(double tsince)
+// tsince  - Times in minutes since the TLE epoch (GMT).
+// count   - Number of elements in tsince.
+// eci     - Output arrays of at least "count" elements.
+// context - Resonance integrator state; continued from and updated.
+void cNoradSDP4::GetPositionBatch(const double *tsince, size_t count,
+                                  const cEciArrays &eci,
+                                  cPropagationContext &context) const
 {
-   // Update for secular gravity and atmospheric drag 
-   double xmdf   = m_Orbit.MeanAnomaly() + m_xmdot  * tsince;
-   double omgadf = m_Orbit.ArgPerigee()  + m_omgdot * tsince;
-   double xnoddf = m_Orbit.RAAN() + m_xnodot * tsince;
-   double tsq    = tsince * tsince;
-   double xnode  = xnoddf + m_xnodcf * tsq;
-   double tempa  = 1.0 - m_c1 * tsince;
-   double tempe  = m_Orbit.BStar() * m_c4 * tsince;
-   double templ  = m_t2cof * tsq;
-   double xn     = m_Orbit.MeanMotion();
-   double em;
-   double xinc;
+   for (size_t index = 0; index < count; index++)
+   {
+      const double t = tsince[index];
+
+      // Update for secular gravity and atmospheric drag 
+      double xmdf   = m_El.m_xmo    + m_El.m_xmdot  * t;
+      double omgadf = m_El.m_omegao + m_El.m_omgdot * t;
+      double xnoddf = m_El.m_xnodeo + m_El.m_xnodot * t;
+      double tsq    = t * t;
+      double xnode  = xnoddf + m_El.m_xnodcf * tsq;
+      double tempa  = 1.0 - m_El.m_c1 * t;
+      double tempe  = m_El.m_bstar * m_El.m_c4 * t;
+      double templ  = m_El.m_t2cof * tsq;
+      double xn     = m_El.m_xnodp;
+      double em;
+      double xinc;
+
+      DeepSecular(&xmdf, &omgadf, &xnode, &em, &xinc, &xn, t, context);
 
-   DeepSecular(&xmdf, &omgadf, &xnode, &em, &xinc, &xn, tsince);
+      double a    = pow(XKE / xn, 2.0 / 3.0) * sqr(tempa);
+      double e    = em - tempe;
+      double xmam = xmdf + m_El.m_xnodp * templ;
 
-   double a    = pow(XKE / xn, 2.0 / 3.0) * sqr(tempa);
-   double e    = em - tempe;
-   double xmam = xmdf + m_Orbit.MeanMotion() * templ;
+      DeepPeriodics(&e, &xinc, &omgadf, &xnode, &xmam, t);
 
-   DeepPeriodics(&e, &xinc, &omgadf, &xnode, &xmam, tsince);
+      double xl = xmam + omgadf + xnode;
 
-   double xl = xmam + omgadf + xnode;
+      xn = XKE / pow(a, 1.5);
 
-   xn = XKE / pow(a, 1.5);
+      ePositionStatus status = 
+         FinalPosition(m_El, xinc, omgadf, e, a, xl, xnode, xn, eci, index);
 
-   return FinalPosition(xinc, omgadf, e, a, xl, xnode, xn, tsince);
+      if (status != POS_OK)
+      {
+         ThrowPositionError(status, t);
+      }
+   }
 }
 }
 }
\ No newline at end of file
@@ -10,6 +10,9 @@
 //
 #pragma once
 
+#include <mutex>
+#include <vector>
+
 #include "cNoradBase.h"
 
 namespace Zeptomoby
@@ -20,24 +23,12 @@ namespace OrbitTools
 class cOrbit;
 
 //////////////////////////////////////////////////////////////////////////////
-class cNoradSDP4 : public cNoradBase
+// struct cDeepElements
+// The deep-space part of the compiled element record: the lunar-solar and
+// resonance terms set up by the cNoradSDP4 constructor. Like
+// cNoradElements it is plain data, only read after construction.
+struct cDeepElements
 {
-public: 
-   cNoradSDP4(const cOrbit &orbit);
-   virtual ~cNoradSDP4();
-
-   virtual cEciTime GetPosition(double tsince);
-
-   virtual cNoradBase* Clone(const cOrbit& orbit) { return new cNoradSDP4(orbit); }
-
-protected:
-   bool DeepSecular(double *xmdf,  double *omgadf,double *xnode, double *emm, 
-                    double *xincc, double *xnn,   double tsince);
-   bool DeepCalcDotTerms  (double *pxndot, double *pxnddt, double *pxldot);
-   void DeepCalcIntegrator(double *pxndot, double *pxnddt, double *pxldot, double delt);
-   bool DeepPeriodics(double *e,     double *xincc,  double *omgadf, 
-                      double *xnode, double *xmam,   double tsince);
-   
    double dp_e3;     double dp_ee2;    double dp_se2;    double dp_se3;
    double dp_sgh2;   double dp_sgh3;   double dp_sgh4;   double dp_sh2;
    double dp_sh3;    double dp_si2;    double dp_si3;    double dp_sl2;
@@ -46,16 +37,62 @@ protected:
    double dp_xi3;    double dp_xl2;    double dp_xl3;    double dp_xl4;
    double dp_zmol;   double dp_zmos;
 
-   double dp_atime;  double dp_d2201;  double dp_d2211;  double dp_d3210;
-   double dp_d3222;  double dp_d4410;  double dp_d4422;  double dp_d5220;
-   double dp_d5232;  double dp_d5421;  double dp_d5433;  double dp_del1;
-   double dp_del2;   double dp_del3;   double dp_sse;    double dp_ssg;
-   double dp_ssh;    double dp_ssi;    double dp_ssl;    double dp_step2;
-   double dp_stepn;  double dp_stepp;  double dp_thgr;   double dp_xfact;
-   double dp_xlamo;  double dp_xli;    double dp_xni;
+   double dp_d2201;  double dp_d2211;  double dp_d3210;  double dp_d3222;
+   double dp_d4410;  double dp_d4422;  double dp_d5220;  double dp_d5232;
+   double dp_d5421;  double dp_d5433;  double dp_del1;   double dp_del2;
+   double dp_del3;   double dp_sse;    double dp_ssg;    double dp_ssh;
+   double dp_ssi;    double dp_ssl;    double dp_step2;  double dp_stepn;
+   double dp_stepp;  double dp_thgr;   double dp_xfact;  double dp_xlamo;
 
    bool gp_reso;
    bool gp_sync;
 };
+
+//////////////////////////////////////////////////////////////////////////////
+class cNoradSDP4 : public cNoradBase, protected cDeepElements
+{
+public: 
+   cNoradSDP4(const cOrbit &orbit);
+   virtual ~cNoradSDP4();
+
+   // Restores a model from records saved by an earlier instance (see
+   // NoradElements() and DeepElements()), skipping the initialization.
+   cNoradSDP4(const cOrbit &orbit, const cNoradElements &el,
+              const cDeepElements &deep);
+
+   const cDeepElements& DeepElements() const { return *this; }
+
+   using cNoradBase::GetPositionBatch;
+
+   virtual void GetPositionBatch(const double *tsince, size_t count,
+                                 const cEciArrays &eci,
+                                 cPropagationContext &context) const;
+
+   virtual cNoradBase* Clone(const cOrbit& orbit) { return new cNoradSDP4(orbit, m_El, *this); }
+
+protected:
+   bool DeepSecular(double *xmdf,  double *omgadf,double *xnode, double *emm, 
+                    double *xincc, double *xnn,   double tsince,
+                    cPropagationContext &ctx) const;
+   bool DeepCalcDotTerms  (double *pxndot, double *pxnddt, double *pxldot,
+                           const cPropagationContext &ctx) const;
+   void DeepCalcIntegrator(double *pxndot, double *pxnddt, double *pxldot, double delt,
+                           cPropagationContext &ctx) const;
+   bool DeepPeriodics(double *e,     double *xincc,  double *omgadf, 
+                      double *xnode, double *xmam,   double tsince) const;
+   bool DeepCanContinue  (double tsince, const cPropagationContext &ctx) const;
+   void DeepLoadCheckpoint(double tsince, cPropagationContext &ctx) const;
+   
+   // The integrator state (atime, xli, xni) is kept in cPropagationContext.
+   // Checkpoints of that state, every DP_CHECKPOINT_STEPS integrator steps
+   // after (dp_cpForward) and before (dp_cpBackward) epoch, are added on
+   // demand; entry k is the state at atime = +/-k * DP_CHECKPOINT_STEPS *
+   // dp_stepp. Entry 0 (epoch) is not stored.
+   static const int DP_CHECKPOINT_STEPS = 16;
+
+   mutable std::vector<cPropagationContext> dp_cpForward;
+   mutable std::vector<cPropagationContext> dp_cpBackward;
+   mutable std::mutex                       dp_cpMutex;
+};
 }
 }
\ No newline at end of file
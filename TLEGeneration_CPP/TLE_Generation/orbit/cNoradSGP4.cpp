@@ -9,6 +9,7 @@
 #include "stdafx.h"
 
 #include "cNoradSGP4.h"
+#include "cSgp4Kernel.h"
 #include "cOrbit.h"
 
 namespace Zeptomoby 
@@ -20,14 +21,48 @@ namespace OrbitTools
 cNoradSGP4::cNoradSGP4(const cOrbit &orbit) :
    cNoradBase(orbit)
 {
-   double etasq = m_eta * m_eta;
-
-   m_c5     = 2.0 * m_coef1 * m_Orbit.SemiMajor() * m_betao2 * 
-              (1.0 + 2.75 * (etasq + m_eeta) + m_eeta * etasq);
-   m_omgcof = m_Orbit.BStar() * m_c3 * cos(m_Orbit.ArgPerigee());
-   m_xmcof  = -(2.0 / 3.0) * m_coef * m_Orbit.BStar() * AE / m_eeta;
-   m_delmo  = pow(1.0 + m_eta * cos(m_Orbit.MeanAnomaly()), 3.0);
-   m_sinmo  = sin(m_Orbit.MeanAnomaly());
+   double etasq = m_El.m_eta * m_El.m_eta;
+
+   m_El.m_c5     = 2.0 * m_El.m_coef1 * m_Orbit.SemiMajor() * m_El.m_betao2 * 
+                   (1.0 + 2.75 * (etasq + m_El.m_eeta) + m_El.m_eeta * etasq);
+   m_El.m_omgcof = m_Orbit.BStar() * m_El.m_c3 * cos(m_Orbit.ArgPerigee());
+   m_El.m_xmcof  = -(2.0 / 3.0) * m_El.m_coef * m_Orbit.BStar() * AE / m_El.m_eeta;
+   m_El.m_delmo  = pow(1.0 + m_El.m_eta * cos(m_Orbit.MeanAnomaly()), 3.0);
+   m_El.m_sinmo  = sin(m_Orbit.MeanAnomaly());
+
+   // For m_perigee less than 220 kilometers, the isimp flag is set and
+   // the equations are truncated to linear variation in sqrt a and
+   // quadratic variation in mean anomaly.  Also, the m_c3 term, the
+   // delta omega term, and the delta m term are dropped.
+   m_El.m_isimp = false;
+
+   if ((m_Orbit.SemiMajor() * (1.0 - m_Orbit.Eccentricity()) / AE) < (220.0 / XKMPER_WGS72 + AE))
+   {
+      m_El.m_isimp = true;
+   }
+
+   if (!m_El.m_isimp)
+   {
+      double c1sq = m_El.m_c1 * m_El.m_c1;
+
+      m_El.m_d2 = 4.0 * m_Orbit.SemiMajor() * m_El.m_tsi * c1sq;
+
+      double temp = m_El.m_d2 * m_El.m_tsi * m_El.m_c1 / 3.0;
+
+      m_El.m_d3 = (17.0 * m_Orbit.SemiMajor() + m_El.m_s4) * temp;
+      m_El.m_d4 = 0.5 * temp * m_Orbit.SemiMajor() * m_El.m_tsi * 
+                  (221.0 * m_Orbit.SemiMajor() + 31.0 * m_El.m_s4) * m_El.m_c1;
+      m_El.m_t3cof = m_El.m_d2 + 2.0 * c1sq;
+      m_El.m_t4cof = 0.25 * (3.0 * m_El.m_d3 + m_El.m_c1 * (12.0 * m_El.m_d2 + 10.0 * c1sq));
+      m_El.m_t5cof = 0.2 * (3.0 * m_El.m_d4 + 12.0 * m_El.m_c1 * m_El.m_d3 + 6.0 * 
+                            m_El.m_d2 * m_El.m_d2 + 15.0 * c1sq * (2.0 * m_El.m_d2 + c1sq));
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cNoradSGP4::cNoradSGP4(const cOrbit &orbit, const cNoradElements &el) :
+   cNoradBase(orbit, el)
+{
 }
 
 cNoradSGP4::~cNoradSGP4(void)
@@ -35,86 +70,113 @@ cNoradSGP4::~cNoradSGP4(void)
 }
 
 //////////////////////////////////////////////////////////////////////////////
-// GetPosition() 
+// GetPositionBatch() 
 // This procedure returns the ECI position and velocity for the satellite
-// in the orbit at the given number of minutes since the TLE epoch time
+// in the orbit at the given numbers of minutes since the TLE epoch time
 // using the NORAD Simplified General Perturbation 4, near earth orbit
 // model.
 //
-// tsince - Time in minutes since the TLE epoch (GMT).
-cEciTime cNoradSGP4::GetPosition(double tsince)
+// tsince - Times in minutes since the TLE epoch (GMT).
+// count  - Number of elements in tsince.
+// eci    - Output arrays of at least "count" elements.
+// The model has no propagation state; "context" is not used.
+//
+// When the CPU supports it, whole groups of 4 or 8 samples are evaluated
+// at once by a time kernel; the remainder, and any group containing a
+// failing sample, go through Propagate().
+void cNoradSGP4::GetPositionBatch(const double *tsince, size_t count,
+                                  const cEciArrays &eci,
+                                  cPropagationContext &) const
 {
-   // For m_perigee less than 220 kilometers, the isimp flag is set and
-   // the equations are truncated to linear variation in sqrt a and
-   // quadratic variation in mean anomaly.  Also, the m_c3 term, the
-   // delta omega term, and the delta m term are dropped.
-   bool isimp = false;
+   size_t first = 0;
 
-   if ((m_Orbit.SemiMajor() * (1.0 - m_Orbit.Eccentricity()) / AE) < (220.0 / XKMPER_WGS72 + AE))
+#ifdef SGP4_X86_KERNELS
+   eSimdLevel level = SimdLevelSupported();
+
+   if (level != SIMD_SCALAR)
    {
-      isimp = true;
+      cSgp4KernelArgs args = cSgp4KernelArgs();
+
+      args.m_pTsince  = tsince;
+      args.m_Count    = count;
+      args.m_Xke      = XKE;
+      args.m_Ck2      = CK2;
+      args.m_Xkmper   = XKMPER_WGS72;
+      args.m_PosScale = 1.0;   // AE
+      args.m_VelScale = 1.0;   // AE/min
+      args.m_pX       = eci.m_x;
+      args.m_pY       = eci.m_y;
+      args.m_pZ       = eci.m_z;
+      args.m_pVx      = eci.m_vx;
+      args.m_pVy      = eci.m_vy;
+      args.m_pVz      = eci.m_vz;
+
+      if (level == SIMD_AVX512)
+      {
+         first = Sgp4TimeKernelAvx512(m_El, args);
+      }
+      else
+      {
+         first = Sgp4TimeKernelAvx2(m_El, args);
+      }
    }
+#endif
 
-   double d2 = 0.0;
-   double d3 = 0.0;
-   double d4 = 0.0;
-
-   double t3cof = 0.0;
-   double t4cof = 0.0;
-   double t5cof = 0.0;
-
-   if (!isimp)
+   for (size_t index = first; index < count; index++)
    {
-      double c1sq = m_c1 * m_c1;
-
-      d2 = 4.0 * m_Orbit.SemiMajor() * m_tsi * c1sq;
+      ePositionStatus status = Propagate(m_El, tsince[index], eci, index);
 
-      double temp = d2 * m_tsi * m_c1 / 3.0;
-
-      d3 = (17.0 * m_Orbit.SemiMajor() + m_s4) * temp;
-      d4 = 0.5 * temp * m_Orbit.SemiMajor() * m_tsi * 
-           (221.0 * m_Orbit.SemiMajor() + 31.0 * m_s4) * m_c1;
-      t3cof = d2 + 2.0 * c1sq;
-      t4cof = 0.25 * (3.0 * d3 + m_c1 * (12.0 * d2 + 10.0 * c1sq));
-      t5cof = 0.2 * (3.0 * d4 + 12.0 * m_c1 * d3 + 6.0 * 
-                     d2 * d2 + 15.0 * c1sq * (2.0 * d2 + c1sq));
+      if (status != POS_OK)
+      {
+         ThrowPositionError(status, tsince[index]);
+      }
    }
+}
 
+//////////////////////////////////////////////////////////////////////////////
+// Propagate()
+// Calculates a single SGP4 position from a compiled element record and
+// stores it in element "index" of the output arrays (AE, AE/min). This is
+// the scalar reference for the vector kernels in cSgp4Table.
+cNoradBase::ePositionStatus 
+cNoradSGP4::Propagate(const cNoradElements &el, double t,
+                      const cEciArrays &eci, size_t index)
+{
    // Update for secular gravity and atmospheric drag. 
-   double xmdf   = m_Orbit.MeanAnomaly() + m_xmdot * tsince;
-   double omgadf = m_Orbit.ArgPerigee()  + m_omgdot * tsince;
-   double xnoddf = m_Orbit.RAAN() + m_xnodot * tsince;
+   double xmdf   = el.m_xmo    + el.m_xmdot  * t;
+   double omgadf = el.m_omegao + el.m_omgdot * t;
+   double xnoddf = el.m_xnodeo + el.m_xnodot * t;
    double omega  = omgadf;
    double xmp    = xmdf;
-   double tsq    = tsince * tsince;
-   double xnode  = xnoddf + m_xnodcf * tsq;
-   double tempa  = 1.0 - m_c1 * tsince;
-   double tempe  = m_Orbit.BStar() * m_c4 * tsince;
-   double templ  = m_t2cof * tsq;
+   double tsq    = t * t;
+   double xnode  = xnoddf + el.m_xnodcf * tsq;
+   double tempa  = 1.0 - el.m_c1 * t;
+   double tempe  = el.m_bstar * el.m_c4 * t;
+   double templ  = el.m_t2cof * tsq;
 
-   if (!isimp)
+   if (!el.m_isimp)
    {
-      double delomg = m_omgcof * tsince;
-      double delm = m_xmcof * (pow(1.0 + m_eta * cos(xmdf), 3.0) - m_delmo);
+      double delomg = el.m_omgcof * t;
+      double delm = el.m_xmcof * (pow(1.0 + el.m_eta * cos(xmdf), 3.0) - el.m_delmo);
       double temp = delomg + delm;
 
       xmp   = xmdf   + temp;
       omega = omgadf - temp;
 
-      double tcube = tsq * tsince;
-      double tfour = tsince * tcube;
+      double tcube = tsq * t;
+      double tfour = t * tcube;
 
-      tempa = tempa - d2 * tsq - d3 * tcube - d4 * tfour;
-      tempe = tempe + m_Orbit.BStar() * m_c5 * (sin(xmp) - m_sinmo);
-      templ = templ + t3cof * tcube + tfour * (t4cof + tsince * t5cof);
+      tempa = tempa - el.m_d2 * tsq - el.m_d3 * tcube - el.m_d4 * tfour;
+      tempe = tempe + el.m_bstar * el.m_c5 * (sin(xmp) - el.m_sinmo);
+      templ = templ + el.m_t3cof * tcube + tfour * (el.m_t4cof + t * el.m_t5cof);
    }
 
-   double a  = m_Orbit.SemiMajor() * sqr(tempa);
-   double e  = m_Orbit.Eccentricity() - tempe;
-   double xl = xmp + omega + xnode + m_Orbit.MeanMotion() * templ;
+   double a  = el.m_aodp * sqr(tempa);
+   double e  = el.m_eo - tempe;
+   double xl = xmp + omega + xnode + el.m_xnodp * templ;
    double xn = XKE / pow(a, 1.5);
 
-   return FinalPosition(m_Orbit.Inclination(), omgadf, e, a, xl, xnode, xn, tsince);
+   return FinalPosition(el, el.m_xincl, omgadf, e, a, xl, xnode, xn, eci, index);
 }
 }
 }
\ No newline at end of file
@@ -25,16 +25,20 @@ public:
    cNoradSGP4(const cOrbit &orbit);
    virtual ~cNoradSGP4();
 
-   virtual cEciTime GetPosition(double tsince);
+   // Restores a model from the element record of an earlier instance,
+   // skipping the initialization.
+   cNoradSGP4(const cOrbit &orbit, const cNoradElements &el);
 
-   virtual cNoradBase* Clone(const cOrbit& orbit) { return new cNoradSGP4(orbit); }
+   using cNoradBase::GetPositionBatch;
 
-protected:
-   double m_c5; 
-   double m_omgcof;
-   double m_xmcof;
-   double m_delmo;
-   double m_sinmo;
+   virtual void GetPositionBatch(const double *tsince, size_t count,
+                                 const cEciArrays &eci,
+                                 cPropagationContext &context) const;
+
+   virtual cNoradBase* Clone(const cOrbit& orbit) { return new cNoradSGP4(orbit, m_El); }
+
+   static ePositionStatus Propagate(const cNoradElements &el, double tsince,
+                                    const cEciArrays &eci, size_t index);
 };
 }
 }
\ No newline at end of file
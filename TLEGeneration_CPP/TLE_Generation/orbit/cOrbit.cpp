@@ -11,6 +11,7 @@
 #include "cOrbit.h"
 #include "cNoradSGP4.h"
 #include "cNoradSDP4.h"
+#include "cOrbitSnapshot.h"
 
 namespace Zeptomoby
 {
@@ -37,8 +38,6 @@ cOrbit::cOrbit(const cTle &tle) :
 
    m_jdEpoch = cJulian(epochYear, epochDay);
 
-   m_secPeriod = -1.0;
-
    // Recover the original mean motion and semimajor axis from the
    // input elements.
    double mm     = MeanMotionTle();
@@ -63,7 +62,19 @@ cOrbit::cOrbit(const cTle &tle) :
    m_kmPerigeeRec       = XKMPER_WGS72 * (m_aeAxisSemiMajorRec * (1.0 - e) - AE);
    m_kmApogeeRec        = XKMPER_WGS72 * (m_aeAxisSemiMajorRec * (1.0 + e) - AE);
 
-   if (TWOPI / m_rmMeanMotionRec >= 225.0)
+   // Calculate the period using the recovered mean motion. It is computed
+   // here, rather than on first use, so that a shared cOrbit is never
+   // written to after construction.
+   if (m_rmMeanMotionRec == 0)
+   {
+      m_secPeriod = 0.0;
+   }
+   else
+   {
+      m_secPeriod = TWOPI / m_rmMeanMotionRec * 60.0;
+   }
+
+   if (IsDeepSpace())
    {
       // SDP4 - period >= 225 minutes.
       m_pNoradModel = new cNoradSDP4(*this);
@@ -75,6 +86,42 @@ cOrbit::cOrbit(const cTle &tle) :
    }
 }
 
+//////////////////////////////////////////////////////////////////////
+// RecordTle()
+static cTle RecordTle(const cOrbitRecord &rec)
+{
+   string name (rec.m_Name);
+   string line1(rec.m_Line1);
+   string line2(rec.m_Line2);
+
+   return cTle(name, line1, line2);
+}
+
+//////////////////////////////////////////////////////////////////////
+cOrbit::cOrbit(const cOrbitRecord &rec) :
+   m_tle(RecordTle(rec)),
+   m_jdEpoch(rec.m_jdEpoch),
+   m_pNoradModel(NULL)
+{
+   InitializeCachingVars();
+
+   m_rmMeanMotionRec    = rec.m_rmMeanMotionRec;
+   m_aeAxisSemiMajorRec = rec.m_aeAxisSemiMajorRec;
+   m_aeAxisSemiMinorRec = rec.m_aeAxisSemiMinorRec;
+   m_kmPerigeeRec       = rec.m_kmPerigeeRec;
+   m_kmApogeeRec        = rec.m_kmApogeeRec;
+   m_secPeriod          = rec.m_secPeriod;
+
+   if (IsDeepSpace())
+   {
+      m_pNoradModel = new cNoradSDP4(*this, rec.m_El, rec.m_Deep);
+   }
+   else
+   {
+      m_pNoradModel = new cNoradSGP4(*this, rec.m_El);
+   }
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // Copy constructor
 cOrbit::cOrbit(const cOrbit& src) :
@@ -157,26 +204,6 @@ void cOrbit::InitializeCachingVars()
    m_MeanAnomaly   = RadGet(cTle::FLD_M);
 }
 
-//////////////////////////////////////////////////////////////////////////////
-// Return the period in seconds
-double cOrbit::Period() const
-{
-   if (m_secPeriod < 0.0)
-   {
-      // Calculate the period using the recovered mean motion.
-      if (m_rmMeanMotionRec == 0)
-      {
-         m_secPeriod = 0.0;
-      }
-      else
-      {
-         m_secPeriod = TWOPI / m_rmMeanMotionRec * 60.0;
-      }
-   }
-
-   return m_secPeriod;
-}
-
 //////////////////////////////////////////////////////////////////////////////
 // Returns elapsed number of seconds from epoch to given time.
 // Note: "Predicted" TLEs can have epochs in the future.
@@ -198,7 +225,15 @@ cEciTime cOrbit::GetPosition(double mpe) const
 // returned in the ECI object are kilometer-based.
 cEciTime cOrbit::PositionEci(double mpe) const
 {
-   cEciTime eci = m_pNoradModel->GetPosition(mpe);
+   cPropagationContext context;
+
+   return PositionEci(mpe, context);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cEciTime cOrbit::PositionEci(double mpe, cPropagationContext &context) const
+{
+   cEciTime eci = m_pNoradModel->GetPosition(mpe, context);
 
    // Convert ECI vector units from AU to kilometers
    double radiusAe = XKMPER_WGS72 / AE;
@@ -209,6 +244,51 @@ cEciTime cOrbit::PositionEci(double mpe) const
    return eci;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// PositionEciBatch()
+// This procedure returns the ECI position and velocity for the satellite
+// at each of the "count" given minutes past the (GMT) TLE epoch. Element i
+// of the output arrays corresponds to mpe[i]. The arrays are filled in
+// kilometer-based units, the same as PositionEci(), but no cEciTime
+// objects are built and the orbit model is dispatched once per batch.
+void cOrbit::PositionEciBatch(const double *mpe, size_t count, 
+                              const cEciArrays &eci) const
+{
+   cPropagationContext context;
+
+   PositionEciBatch(mpe, count, eci, context);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void cOrbit::PositionEciBatch(const double *mpe, size_t count, 
+                              const cEciArrays &eci,
+                              cPropagationContext &context) const
+{
+   m_pNoradModel->GetPositionBatch(mpe, count, eci, context);
+
+   // Convert ECI vector units from AU to kilometers
+   const double radiusAe = XKMPER_WGS72 / AE;
+   const double velScale = radiusAe * (MIN_PER_DAY / 86400);
+
+   for (size_t i = 0; i < count; i++)
+   {
+      eci.m_x [i] *= radiusAe;   // km
+      eci.m_y [i] *= radiusAe;
+      eci.m_z [i] *= radiusAe;
+      eci.m_vx[i] *= velScale;   // km/sec
+      eci.m_vy[i] *= velScale;
+      eci.m_vz[i] *= velScale;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// IsDeepSpace()
+// Orbits with a period of 225 minutes or more use the SDP4 model.
+bool cOrbit::IsDeepSpace() const
+{
+   return (TWOPI / m_rmMeanMotionRec >= 225.0);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // SatName()
 // Return the name of the satellite. If requested, the NORAD number is
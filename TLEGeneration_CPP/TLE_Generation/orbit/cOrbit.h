@@ -25,11 +25,18 @@ namespace Zeptomoby
 namespace OrbitTools
 {
 
+struct cOrbitRecord;
+
 //////////////////////////////////////////////////////////////////////////////
 class cOrbit  
 {
 public:
    cOrbit(const cTle &tle);
+
+   // Restores an orbit from a snapshot record (see cOrbitSnapshot) without
+   // recovering the elements or initializing the orbit model again.
+   explicit cOrbit(const cOrbitRecord &rec);
+
    cOrbit(const cOrbit& src);
    cOrbit& operator=(const cOrbit& rhs);
    virtual ~cOrbit();
@@ -37,6 +44,20 @@ public:
    // Return satellite ECI data at given minutes past epoch.
    cEciTime PositionEci(double mpe) const;
    cEciTime GetPosition(double mpe) const; // Deprecated, use PositionEci().
+
+   // Return satellite ECI data at each of the given minutes past epoch,
+   // written to caller-owned arrays (km, km/sec).
+   void PositionEciBatch(const double *mpe, size_t count, 
+                         const cEciArrays &eci) const;
+
+   // As above, continuing from (and updating) the caller's propagation
+   // context; see cPropagationContext. A cOrbit may be shared between
+   // threads provided each thread uses its own context. The forms without
+   // a context are equivalent to passing a new one.
+   cEciTime PositionEci(double mpe, cPropagationContext &context) const;
+   void PositionEciBatch(const double *mpe, size_t count, 
+                         const cEciArrays &eci,
+                         cPropagationContext &context) const;
    
    double Inclination()   const { return m_Inclination;   }
    double Eccentricity()  const { return m_Eccentricity;  }
@@ -65,7 +86,14 @@ public:
    double Minor()      const { return 2.0 * SemiMinor();    }  // minor axis in AE
    double Perigee()    const { return m_kmPerigeeRec;       }  // perigee in km
    double Apogee()     const { return m_kmApogeeRec;        }  // apogee in km
-   double Period()     const;                                  // period in seconds
+   double Period()     const { return m_secPeriod;          }  // period in seconds
+
+   // True if the orbit is propagated with the SDP4 (deep space) model
+   bool IsDeepSpace() const;
+
+   // The orbit model and its compiled element record
+   const cNoradBase&     NoradModel()    const { return *m_pNoradModel; }
+   const cNoradElements& NoradElements() const { return m_pNoradModel->Elements(); }
 
 protected:
    double RadGet(cTle::eField fld) const { return m_tle.GetField(fld, cTle::U_RAD); }
@@ -77,7 +105,7 @@ private:
    cNoradBase *m_pNoradModel;
 
    // Caching variables; note units are not necessarily the same as tle units
-   mutable double m_secPeriod;
+   double m_secPeriod;
 
    // Caching variables for standard TLE elements
    double m_Inclination;
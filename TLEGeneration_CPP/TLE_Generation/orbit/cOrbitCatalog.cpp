@@ -0,0 +1,294 @@
+//
+// cOrbitCatalog.cpp
+//
+#include "stdafx.h"
+
+#include <algorithm>
+
+#include "cOrbitCatalog.h"
+#include "cSatellite.h"
+#include "cTle.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+//////////////////////////////////////////////////////////////////////////////
+// A registration. m_Epoch is the epoch the reader's open read section
+// started in, 0 if none is open. Records are padded so that readers do not
+// share cache lines; a record given up is reused by the next reader to
+// register, and freed only with the catalog.
+struct cOrbitCatalog::cReaderRecord
+{
+   cReaderRecord() : m_Epoch(0), m_fUsed(true), m_pNext(NULL) { }
+
+   std::atomic<uint64_t> m_Epoch;
+   std::atomic<bool>     m_fUsed;
+   cReaderRecord        *m_pNext;       // set before the record is listed
+   char                  m_Pad[64];
+};
+
+// One NORAD id's entry; it keeps its address for the catalog's lifetime.
+struct cOrbitCatalog::cSlot
+{
+   explicit cSlot(int noradId) : m_NoradId(noradId), m_pSat(NULL) { }
+
+   int                      m_NoradId;
+   std::atomic<cSatellite*> m_pSat;
+};
+
+// The entries, sorted by NORAD id. Never changed once published; a new id
+// publishes a new copy.
+struct cOrbitCatalog::cIndex
+{
+   vector<int>    m_Ids;
+   vector<cSlot*> m_Slots;
+};
+
+// Unlinked in epoch m_Epoch; one of the pointers is set.
+struct cOrbitCatalog::cRetired
+{
+   uint64_t      m_Epoch;
+   cSatellite   *m_pSat;
+   const cIndex *m_pIndex;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+cOrbitCatalog::cOrbitCatalog() :
+   m_Epoch(1),
+   m_pIndex(new cIndex),
+   m_pReaders(NULL)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cOrbitCatalog::~cOrbitCatalog()
+{
+   for (size_t i = 0; i < m_Retired.size(); i++)
+   {
+      delete m_Retired[i].m_pSat;
+      delete m_Retired[i].m_pIndex;
+   }
+
+   for (size_t i = 0; i < m_Slots.size(); i++)
+   {
+      delete m_Slots[i]->m_pSat.load();
+      delete m_Slots[i];
+   }
+
+   delete m_pIndex.load();
+
+   for (cReaderRecord *pRecord = m_pReaders.load(); pRecord != NULL; )
+   {
+      cReaderRecord *pNext = pRecord->m_pNext;
+      delete pRecord;
+      pRecord = pNext;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// cReader
+// Takes a record given up by an earlier reader, or lists a new one.
+cOrbitCatalog::cReader::cReader(cOrbitCatalog &catalog) :
+   m_Catalog(catalog),
+   m_pRecord(NULL)
+{
+   for (cReaderRecord *pRecord = catalog.m_pReaders.load(); pRecord != NULL;
+        pRecord = pRecord->m_pNext)
+   {
+      bool fUsed = false;
+
+      if (!pRecord->m_fUsed.load() &&
+          pRecord->m_fUsed.compare_exchange_strong(fUsed, true))
+      {
+         m_pRecord = pRecord;
+         return;
+      }
+   }
+
+   m_pRecord = new cReaderRecord;
+   m_pRecord->m_pNext = catalog.m_pReaders.load();
+
+   while (!catalog.m_pReaders.compare_exchange_weak(m_pRecord->m_pNext, m_pRecord))
+   {
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cOrbitCatalog::cReader::~cReader()
+{
+   m_pRecord->m_Epoch.store(0);
+   m_pRecord->m_fUsed.store(false);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// cReadGuard
+// The announcement is sequentially consistent with the writer's exchange
+// and its scan of the records: either the writer sees this reader's epoch
+// and keeps what it unlinked, or the reader's lookups come after the
+// exchange and find the new satellite.
+cOrbitCatalog::cReadGuard::cReadGuard(cReader &reader) :
+   m_Reader(reader)
+{
+   reader.m_pRecord->m_Epoch.store(reader.m_Catalog.m_Epoch.load());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cOrbitCatalog::cReadGuard::~cReadGuard()
+{
+   m_Reader.m_pRecord->m_Epoch.store(0, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+const cSatellite* cOrbitCatalog::cReadGuard::Find(int noradId) const
+{
+   return m_Reader.m_Catalog.Find(noradId);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Find()
+// Only valid inside a read section.
+const cSatellite* cOrbitCatalog::Find(int noradId) const
+{
+   const cIndex *pIndex = m_pIndex.load();
+
+   vector<int>::const_iterator it =
+      lower_bound(pIndex->m_Ids.begin(), pIndex->m_Ids.end(), noradId);
+
+   if (it == pIndex->m_Ids.end() || *it != noradId)
+   {
+      return NULL;
+   }
+
+   return pIndex->m_Slots[it - pIndex->m_Ids.begin()]->m_pSat.load();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Publish()
+void cOrbitCatalog::Publish(int noradId, cSatellite *pSat)
+{
+   std::lock_guard<std::mutex> lock(m_WriteMutex);
+
+   const cIndex *pIndex = m_pIndex.load();
+   const cIndex *pOldIndex = NULL;
+
+   vector<int>::const_iterator it =
+      lower_bound(pIndex->m_Ids.begin(), pIndex->m_Ids.end(), noradId);
+   size_t pos = it - pIndex->m_Ids.begin();
+
+   cSlot *pSlot = NULL;
+
+   if (it != pIndex->m_Ids.end() && *it == noradId)
+   {
+      pSlot = pIndex->m_Slots[pos];
+   }
+   else
+   {
+      pSlot = new cSlot(noradId);
+      m_Slots.push_back(pSlot);
+
+      cIndex *pNewIndex = new cIndex(*pIndex);
+      pNewIndex->m_Ids.insert(pNewIndex->m_Ids.begin() + pos, noradId);
+      pNewIndex->m_Slots.insert(pNewIndex->m_Slots.begin() + pos, pSlot);
+
+      pOldIndex = pIndex;
+      m_pIndex.store(pNewIndex);
+   }
+
+   cSatellite *pOldSat = pSlot->m_pSat.exchange(pSat);
+
+   // Read sections that start from here on cannot find what was unlinked.
+   uint64_t epoch = m_Epoch.fetch_add(1);
+
+   if (pOldSat != NULL)
+   {
+      cRetired retired = { epoch, pOldSat, NULL };
+      m_Retired.push_back(retired);
+   }
+
+   if (pOldIndex != NULL)
+   {
+      cRetired retired = { epoch, NULL, pOldIndex };
+      m_Retired.push_back(retired);
+   }
+
+   ReclaimLocked();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Update()
+void cOrbitCatalog::Update(const cTle &tle)
+{
+   cSatellite *pSat = new cSatellite(tle);
+
+   Publish(int(tle.GetField(cTle::FLD_NORADNUM)), pSat);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Reclaim()
+void cOrbitCatalog::Reclaim()
+{
+   std::lock_guard<std::mutex> lock(m_WriteMutex);
+
+   ReclaimLocked();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// ReclaimLocked()
+// What was unlinked in epoch e can be freed once every open read section
+// started after e.
+void cOrbitCatalog::ReclaimLocked()
+{
+   if (m_Retired.empty())
+   {
+      return;
+   }
+
+   uint64_t oldest = UINT64_MAX;
+
+   for (cReaderRecord *pRecord = m_pReaders.load(); pRecord != NULL;
+        pRecord = pRecord->m_pNext)
+   {
+      uint64_t epoch = pRecord->m_Epoch.load();
+
+      if (epoch != 0)
+      {
+         oldest = min(oldest, epoch);
+      }
+   }
+
+   size_t kept = 0;
+
+   for (size_t i = 0; i < m_Retired.size(); i++)
+   {
+      if (m_Retired[i].m_Epoch < oldest)
+      {
+         delete m_Retired[i].m_pSat;
+         delete m_Retired[i].m_pIndex;
+      }
+      else
+      {
+         m_Retired[kept++] = m_Retired[i];
+      }
+   }
+
+   m_Retired.resize(kept);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+size_t cOrbitCatalog::Size() const
+{
+   std::lock_guard<std::mutex> lock(m_WriteMutex);
+
+   return m_Slots.size();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+size_t cOrbitCatalog::Retired() const
+{
+   std::lock_guard<std::mutex> lock(m_WriteMutex);
+
+   return m_Retired.size();
+}
+}
+}
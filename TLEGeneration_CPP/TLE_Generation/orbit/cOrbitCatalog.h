@@ -0,0 +1,123 @@
+//
+// cOrbitCatalog.h
+//
+// This class holds the current satellite (and so the current cOrbit) of
+// each NORAD id for a long-running process, and lets a new element set
+// replace a satellite while other threads are propagating it.
+//
+// Readers never lock. A reader thread registers once (cReader) and opens
+// a read section (cReadGuard) around each use of the catalog: entering
+// announces the global epoch the reader started in, leaving clears it.
+// A satellite found in a read section stays valid until the section ends.
+//
+// A writer builds the new satellite first, outside any lock (the model
+// initialization is the expensive part), then swaps it into the entry's
+// slot with one atomic exchange and advances the epoch. The old satellite
+// is retired with the epoch it was unlinked in, and freed once every open
+// read section started in a later epoch: a section that started earlier
+// might still hold it, one that started later cannot have found it.
+// Writers are serialized among themselves by a lock that readers never
+// take. A new NORAD id publishes a new copy of the id index the same way.
+//
+// A long read section only delays reclamation; it never blocks a writer.
+//
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+class cSatellite;
+class cTle;
+
+//////////////////////////////////////////////////////////////////////////////
+class cOrbitCatalog
+{
+protected:
+   struct cReaderRecord;
+
+public:
+   cOrbitCatalog();
+
+   // No reader may be registered any more.
+   ~cOrbitCatalog();
+
+   class cReadGuard;
+
+   // A reader thread's registration, held for as long as the thread reads
+   // the catalog. Registering and unregistering are lock-free, but meant
+   // to be done once per thread, not per read.
+   class cReader
+   {
+   public:
+      explicit cReader(cOrbitCatalog &catalog);
+      ~cReader();
+
+   private:
+      friend class cReadGuard;
+
+      cOrbitCatalog &m_Catalog;
+      cReaderRecord *m_pRecord;
+   };
+
+   // A read section. Sections of one reader may not be nested.
+   class cReadGuard
+   {
+   public:
+      explicit cReadGuard(cReader &reader);
+      ~cReadGuard();
+
+      // The satellite of "noradId", or NULL if it is not in the catalog.
+      // Valid until the guard is destroyed.
+      const cSatellite* Find(int noradId) const;
+
+   private:
+      cReader &m_Reader;
+   };
+
+   // Makes "pSat", which the catalog takes over, the satellite of
+   // "noradId", replacing any earlier one.
+   void Publish(int noradId, cSatellite *pSat);
+
+   // Builds the satellite of "tle" on the calling thread and publishes it
+   // under the element set's NORAD id. Throws as cSatellite does, leaving
+   // the catalog unchanged.
+   void Update(const cTle &tle);
+
+   // Frees the retired satellites that no open read section can hold.
+   // Publish() does this too.
+   void Reclaim();
+
+   size_t Size() const;
+
+   // Retired, not yet freed
+   size_t Retired() const;
+
+   uint64_t Epoch() const { return m_Epoch.load(); }
+
+protected:
+   struct cSlot;
+   struct cIndex;
+   struct cRetired;
+
+   const cSatellite* Find(int noradId) const;
+
+   void ReclaimLocked();
+
+   std::atomic<uint64_t>       m_Epoch;
+   std::atomic<const cIndex*>  m_pIndex;
+   std::atomic<cReaderRecord*> m_pReaders;   // list of registrations, never shrinks
+
+   // Writers only
+   mutable std::mutex          m_WriteMutex;
+   vector<cSlot*>              m_Slots;
+   vector<cRetired>            m_Retired;
+};
+}
+}
@@ -0,0 +1,252 @@
+//
+// cOrbitSnapshot.cpp
+//
+#include "stdafx.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "cOrbitSnapshot.h"
+#include "cTleCatalog.h"
+#include "cOrbit.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+static const char     SNAPSHOT_MAGIC[8]  = { 'O', 'R', 'B', 'S', 'N', 'A', 'P', '\0' };
+static const uint32_t SNAPSHOT_VERSION   = 1;
+static const uint32_t SNAPSHOT_BYTE_MARK = 0x01020304;
+
+static const size_t   SNAPSHOT_LEN_LINE  = 69;
+
+// FNV-1a, 64 bit
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME  = 1099511628211ULL;
+
+//////////////////////////////////////////////////////////////////////////////
+// File header; the records follow it directly.
+struct cSnapshotHeader
+{
+   char     m_Magic[8];
+   uint32_t m_Version;
+   uint32_t m_RecordSize;     // sizeof(cOrbitRecord)
+   uint32_t m_ByteMark;
+   uint32_t m_Reserved;
+   uint64_t m_Count;
+   uint64_t m_CatalogHash;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+static uint64_t HashBytes(uint64_t hash, const void *p, size_t len)
+{
+   const unsigned char *pb = (const unsigned char *)p;
+
+   for (size_t i = 0; i < len; i++)
+   {
+      hash = (hash ^ pb[i]) * FNV_PRIME;
+   }
+
+   return hash;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+static void CopyText(char *pDst, size_t cbDst, const string &src)
+{
+   size_t len = min(src.size(), cbDst - 1);
+
+   memset(pDst, 0, cbDst);
+   memcpy(pDst, src.data(), len);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+cOrbitSnapshot::cOrbitSnapshot() :
+   m_pRecords(NULL),
+   m_Count(0),
+   m_CatalogHash(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// TleHash()
+uint64_t cOrbitSnapshot::TleHash(const char *pLine1, const char *pLine2)
+{
+   uint64_t hash = HashBytes(FNV_OFFSET, pLine1, SNAPSHOT_LEN_LINE);
+
+   return HashBytes(hash, pLine2, SNAPSHOT_LEN_LINE);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// CatalogHash()
+// Hash of the per-record hashes, in catalog order.
+uint64_t cOrbitSnapshot::CatalogHash(const cTleCatalog &catalog)
+{
+   uint64_t hash = FNV_OFFSET;
+
+   for (size_t i = 0; i < catalog.Size(); i++)
+   {
+      uint64_t tleHash = TleHash(catalog.Line1(i).c_str(),
+                                 catalog.Line2(i).c_str());
+
+      hash = HashBytes(hash, &tleHash, sizeof(tleHash));
+   }
+
+   return hash;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Write()
+bool cOrbitSnapshot::Write(const string &path, const cTleCatalog &catalog)
+{
+   vector<cOrbitRecord> records(catalog.Size());
+
+   for (size_t i = 0; i < catalog.Size(); i++)
+   {
+      cOrbitRecord &rec = records[i];
+
+      string name  = catalog.Name(i);
+      string line1 = catalog.Line1(i);
+      string line2 = catalog.Line2(i);
+
+      cTle   tle(name, line1, line2);
+      cOrbit orbit(tle);
+
+      rec.m_TleHash    = TleHash(line1.c_str(), line2.c_str());
+      rec.m_NoradId    = catalog.NoradId(i);
+      rec.m_fDeepSpace = orbit.IsDeepSpace();
+
+      CopyText(rec.m_Name,  sizeof(rec.m_Name),  name);
+      CopyText(rec.m_Line1, sizeof(rec.m_Line1), line1);
+      CopyText(rec.m_Line2, sizeof(rec.m_Line2), line2);
+
+      rec.m_jdEpoch            = orbit.Epoch();
+      rec.m_rmMeanMotionRec    = orbit.MeanMotion();
+      rec.m_aeAxisSemiMajorRec = orbit.SemiMajor();
+      rec.m_aeAxisSemiMinorRec = orbit.SemiMinor();
+      rec.m_kmPerigeeRec       = orbit.Perigee();
+      rec.m_kmApogeeRec        = orbit.Apogee();
+      rec.m_secPeriod          = orbit.Period();
+
+      rec.m_El = orbit.NoradElements();
+
+      if (orbit.IsDeepSpace())
+      {
+         rec.m_Deep = static_cast<const cNoradSDP4&>(orbit.NoradModel()).DeepElements();
+      }
+   }
+
+   stable_sort(records.begin(), records.end(),
+               [](const cOrbitRecord &a, const cOrbitRecord &b)
+               { return a.m_NoradId < b.m_NoradId; });
+
+   cSnapshotHeader hdr;
+
+   memset(&hdr, 0, sizeof(hdr));
+   memcpy(hdr.m_Magic, SNAPSHOT_MAGIC, sizeof(hdr.m_Magic));
+
+   hdr.m_Version     = SNAPSHOT_VERSION;
+   hdr.m_RecordSize  = sizeof(cOrbitRecord);
+   hdr.m_ByteMark    = SNAPSHOT_BYTE_MARK;
+   hdr.m_Count       = records.size();
+   hdr.m_CatalogHash = CatalogHash(catalog);
+
+   string pathTmp = path + ".tmp";
+   FILE  *pFile   = fopen(pathTmp.c_str(), "wb");
+
+   if (pFile == NULL)
+   {
+      return false;
+   }
+
+   bool fOk = (fwrite(&hdr, sizeof(hdr), 1, pFile) == 1);
+
+   if (fOk && !records.empty())
+   {
+      fOk = (fwrite(&records[0], sizeof(cOrbitRecord), records.size(), pFile) ==
+             records.size());
+   }
+
+   fOk = (fclose(pFile) == 0) && fOk;
+
+   if (fOk)
+   {
+      fOk = ReplaceWithFile(pathTmp, path);
+   }
+
+   if (!fOk)
+   {
+      remove(pathTmp.c_str());
+   }
+
+   return fOk;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Open()
+bool cOrbitSnapshot::Open(const string &path)
+{
+   Close();
+
+   if (!m_File.Open(path) || (m_File.Size() < sizeof(cSnapshotHeader)))
+   {
+      Close();
+      return false;
+   }
+
+   const cSnapshotHeader *pHdr = (const cSnapshotHeader *)m_File.Data();
+
+   if ((memcmp(pHdr->m_Magic, SNAPSHOT_MAGIC, sizeof(pHdr->m_Magic)) != 0) ||
+       (pHdr->m_Version    != SNAPSHOT_VERSION)      ||
+       (pHdr->m_RecordSize != sizeof(cOrbitRecord))  ||
+       (pHdr->m_ByteMark   != SNAPSHOT_BYTE_MARK)    ||
+       (m_File.Size() != sizeof(cSnapshotHeader) + pHdr->m_Count * sizeof(cOrbitRecord)))
+   {
+      Close();
+      return false;
+   }
+
+   m_pRecords    = (const cOrbitRecord *)(m_File.Data() + sizeof(cSnapshotHeader));
+   m_Count       = (size_t)pHdr->m_Count;
+   m_CatalogHash = pHdr->m_CatalogHash;
+
+   return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Close()
+void cOrbitSnapshot::Close()
+{
+   m_File.Close();
+
+   m_pRecords    = NULL;
+   m_Count       = 0;
+   m_CatalogHash = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// IsCurrent()
+bool cOrbitSnapshot::IsCurrent(const cTleCatalog &catalog) const
+{
+   return m_File.IsOpen() &&
+          (m_Count == catalog.Size()) &&
+          (m_CatalogHash == CatalogHash(catalog));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Find()
+size_t cOrbitSnapshot::Find(int noradId) const
+{
+   const cOrbitRecord *pEnd = m_pRecords + m_Count;
+   const cOrbitRecord *p    =
+      lower_bound(m_pRecords, pEnd, noradId,
+                  [](const cOrbitRecord &rec, int id) { return rec.m_NoradId < id; });
+
+   if ((p == pEnd) || (p->m_NoradId != noradId))
+   {
+      return NOT_FOUND;
+   }
+
+   return p - m_pRecords;
+}
+}
+}
@@ -0,0 +1,104 @@
+//
+// cOrbitSnapshot.h
+//
+// This class writes and reads a binary snapshot of a whole catalog of
+// initialized orbits: for each element set, the recovered elements and the
+// compiled SGP4/SDP4 element records (cNoradElements, cDeepElements) that
+// the cOrbit and model constructors would otherwise compute. The file is
+// memory mapped and its records are used in place:
+//
+//  - cOrbit(const cOrbitRecord&) restores an orbit without recovering the
+//    elements or running the SDP4 lunar-solar setup;
+//  - cSgp4Table::Add(const cNoradElements&, const cJulian&) takes the
+//    elements of near-earth records straight from the mapping.
+//
+// Each record carries a hash of its two data lines, and the header a hash
+// of the whole catalog, so a snapshot built from different element sets
+// is detected by IsCurrent(). Records are sorted by NORAD number.
+//
+// The records are raw structures of this build: the header stores the
+// format version, the record size and a byte-order mark, and Open()
+// rejects a file written by an incompatible build.
+//
+#pragma once
+
+#include <stdint.h>
+
+#include "cJulian.h"
+#include "cMappedFile.h"
+#include "cNoradBase.h"
+#include "cNoradSDP4.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+class cTleCatalog;
+
+//////////////////////////////////////////////////////////////////////////////
+// struct cOrbitRecord
+struct cOrbitRecord
+{
+   uint64_t m_TleHash;        // cOrbitSnapshot::TleHash() of the data lines
+   int32_t  m_NoradId;
+   int32_t  m_fDeepSpace;
+
+   char     m_Name [32];      // NUL terminated
+   char     m_Line1[72];
+   char     m_Line2[72];
+
+   cJulian  m_jdEpoch;
+
+   // Recovered elements (see cOrbit)
+   double   m_rmMeanMotionRec;
+   double   m_aeAxisSemiMajorRec;
+   double   m_aeAxisSemiMinorRec;
+   double   m_kmPerigeeRec;
+   double   m_kmApogeeRec;
+   double   m_secPeriod;
+
+   cNoradElements m_El;
+   cDeepElements  m_Deep;     // zero for SGP4 orbits
+};
+
+//////////////////////////////////////////////////////////////////////////////
+class cOrbitSnapshot
+{
+public:
+   static const size_t NOT_FOUND = (size_t)-1;
+
+   cOrbitSnapshot();
+
+   // Initializes an orbit for every element set of the catalog and writes
+   // the snapshot (via a temporary file that replaces "path"). Returns
+   // false if the file cannot be written.
+   static bool Write(const string &path, const cTleCatalog &catalog);
+
+   // Returns false if the file is missing, unreadable or not a snapshot
+   // of this format and build.
+   bool Open(const string &path);
+   void Close();
+
+   // True if the snapshot was written from exactly the element sets of
+   // "catalog", in the same order.
+   bool IsCurrent(const cTleCatalog &catalog) const;
+
+   size_t Size() const { return m_Count; }
+
+   const cOrbitRecord& Record(size_t i) const { return m_pRecords[i]; }
+
+   // Index of the first record with the given NORAD number, or NOT_FOUND.
+   size_t Find(int noradId) const;
+
+   static uint64_t TleHash(const char *pLine1, const char *pLine2);
+   static uint64_t CatalogHash(const cTleCatalog &catalog);
+
+protected:
+   cMappedFile         m_File;
+   const cOrbitRecord *m_pRecords;
+   size_t              m_Count;
+   uint64_t            m_CatalogHash;
+};
+}
+}
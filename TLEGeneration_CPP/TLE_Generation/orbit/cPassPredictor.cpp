@@ -0,0 +1,354 @@
+//
+// cPassPredictor.cpp
+//
+#include "stdafx.h"
+
+#include "cPassPredictor.h"
+#include "cSatellite.h"
+#include "cSite.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+// Coarse grid points per orbital revolution, and the default time
+// tolerance of AOS, TCA and LOS in minutes (0.6 ms).
+static const double PASS_STEPS_PER_REV = 64.0;
+static const double PASS_TOLERANCE_MIN = 1.0e-5;
+
+static const double GOLDEN = 0.3819660112501051;   // (3 - sqrt(5)) / 2
+
+//////////////////////////////////////////////////////////////////////////////
+cPassPredictor::cPassPredictor(const cSatellite &sat, const cSite &site) :
+   m_Sat(sat),
+   m_Site(site),
+   m_minStep(sat.Orbit().Period() / 60.0 / PASS_STEPS_PER_REV),
+   m_minTolerance(PASS_TOLERANCE_MIN),
+   m_Evaluations(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// ElevationRad()
+double cPassPredictor::ElevationRad(double mpe)
+{
+   m_Evaluations++;
+
+   cEciTime eci = m_Sat.PositionEci(mpe, m_Context);
+
+   return m_Site.GetLookAngle(eci).ElevationRad();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// FindCrossing()
+// Brent's method for the horizon crossing in [a, b], given that fa and fb
+// (the elevations at a and b) lie on opposite sides of it. Returns the
+// earliest visible time of the final bracket, so the result is always
+// on the visible side.
+double cPassPredictor::FindCrossing(double a, double fa, double b, double fb)
+{
+   // Work with "visible" as >= 0, so crossings are where g changes sign
+   // between g < 0 and g >= 0.
+   double c  = a;
+   double fc = fa;
+   double d  = b - a;
+   double e  = d;
+
+   for (int iter = 0; iter < 100; iter++)
+   {
+      if ((fb < 0.0) == (fc < 0.0))
+      {
+         c  = a;
+         fc = fa;
+         d  = b - a;
+         e  = d;
+      }
+
+      if (fabs(fc) < fabs(fb))
+      {
+         a  = b;   b  = c;   c  = a;
+         fa = fb;  fb = fc;  fc = fa;
+      }
+
+      double tol = 0.5 * m_minTolerance;
+      double xm  = 0.5 * (c - b);
+
+      if ((fabs(xm) <= tol) || (fb == 0.0))
+      {
+         break;
+      }
+
+      if ((fabs(e) >= tol) && (fabs(fa) > fabs(fb)))
+      {
+         // Attempt inverse quadratic interpolation
+         double s = fb / fa;
+         double p, q;
+
+         if (a == c)
+         {
+            p = 2.0 * xm * s;
+            q = 1.0 - s;
+         }
+         else
+         {
+            double qa = fa / fc;
+            double r  = fb / fc;
+
+            p = s * (2.0 * xm * qa * (qa - r) - (b - a) * (r - 1.0));
+            q = (qa - 1.0) * (r - 1.0) * (s - 1.0);
+         }
+
+         if (p > 0.0)
+         {
+            q = -q;
+         }
+
+         p = fabs(p);
+
+         if (2.0 * p < min(3.0 * xm * q - fabs(tol * q), fabs(e * q)))
+         {
+            e = d;
+            d = p / q;
+         }
+         else
+         {
+            d = xm;
+            e = d;
+         }
+      }
+      else
+      {
+         d = xm;
+         e = d;
+      }
+
+      a  = b;
+      fa = fb;
+
+      if (fabs(d) > tol)
+      {
+         b += d;
+      }
+      else
+      {
+         b += (xm > 0.0) ? tol : -tol;
+      }
+
+      fb = ElevationRad(b);
+   }
+
+   // b and c bracket the crossing; return the visible end.
+   return (fb >= 0.0) ? b : c;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// FindMaximum()
+// Brent's minimizer (golden section with parabolic steps) applied to
+// -elevation on [a, b]. Returns the time of the maximum found and stores
+// the elevation there in *pfMax.
+double cPassPredictor::FindMaximum(double a, double b, double *pfMax)
+{
+   double x  = a + GOLDEN * (b - a);
+   double w  = x;
+   double v  = x;
+   double fx = -ElevationRad(x);
+   double fw = fx;
+   double fv = fx;
+   double d  = 0.0;
+   double e  = 0.0;
+
+   for (int iter = 0; iter < 100; iter++)
+   {
+      double xm   = 0.5 * (a + b);
+      double tol1 = 0.5 * m_minTolerance;
+      double tol2 = 2.0 * tol1;
+
+      if (fabs(x - xm) <= (tol2 - 0.5 * (b - a)))
+      {
+         break;
+      }
+
+      bool fGolden = true;
+
+      if (fabs(e) > tol1)
+      {
+         // Try a parabolic fit through x, w and v
+         double r = (x - w) * (fx - fv);
+         double q = (x - v) * (fx - fw);
+         double p = (x - v) * q - (x - w) * r;
+
+         q = 2.0 * (q - r);
+
+         if (q > 0.0)
+         {
+            p = -p;
+         }
+
+         q = fabs(q);
+
+         if ((fabs(p) < fabs(0.5 * q * e)) &&
+             (p > q * (a - x)) && (p < q * (b - x)))
+         {
+            e = d;
+            d = p / q;
+
+            double u = x + d;
+
+            if (((u - a) < tol2) || ((b - u) < tol2))
+            {
+               d = (xm >= x) ? tol1 : -tol1;
+            }
+
+            fGolden = false;
+         }
+      }
+
+      if (fGolden)
+      {
+         e = (x >= xm) ? (a - x) : (b - x);
+         d = GOLDEN * e;
+      }
+
+      double u  = (fabs(d) >= tol1) ? (x + d) : (x + ((d > 0.0) ? tol1 : -tol1));
+      double fu = -ElevationRad(u);
+
+      if (fu <= fx)
+      {
+         if (u >= x) { a = x; } else { b = x; }
+
+         v = w;  fv = fw;
+         w = x;  fw = fx;
+         x = u;  fx = fu;
+      }
+      else
+      {
+         if (u < x) { a = u; } else { b = u; }
+
+         if ((fu <= fw) || (w == x))
+         {
+            v = w;  fv = fw;
+            w = u;  fw = fu;
+         }
+         else if ((fu <= fv) || (v == x) || (v == w))
+         {
+            v = u;  fv = fu;
+         }
+      }
+   }
+
+   *pfMax = -fx;
+
+   return x;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// FindPasses()
+vector<cPass> cPassPredictor::FindPasses(double mpeBegin, double mpeEnd)
+{
+   vector<cPass> passes;
+
+   if (!(mpeEnd > mpeBegin))
+   {
+      return passes;
+   }
+
+   // Coarse grid, window edges included.
+   vector<double> t;
+   vector<double> f;
+
+   for (double mpe = mpeBegin; ; mpe += m_minStep)
+   {
+      mpe = min(mpe, mpeEnd);
+
+      t.push_back(mpe);
+      f.push_back(ElevationRad(mpe));
+
+      if (mpe >= mpeEnd)
+      {
+         break;
+      }
+   }
+
+   // A pass too short to show on the grid appears as a local maximum
+   // below the horizon. Refine each one and, if it reaches the horizon,
+   // insert it as an extra grid point.
+   size_t n = t.size();
+
+   for (size_t i = 0; i < n; i++)
+   {
+      double fPrev = (i > 0)     ? f[i - 1] : -HUGE_VAL;
+      double fNext = (i + 1 < n) ? f[i + 1] : -HUGE_VAL;
+
+      if ((f[i] < 0.0) && (f[i] >= fPrev) && (f[i] > fNext))
+      {
+         double fMax;
+         double tMax = FindMaximum(t[(i > 0) ? i - 1 : i],
+                                   t[(i + 1 < n) ? i + 1 : i], &fMax);
+
+         if ((fMax >= 0.0) && (tMax != t[i]))
+         {
+            size_t at = (tMax < t[i]) ? i : i + 1;
+
+            t.insert(t.begin() + at, tMax);
+            f.insert(f.begin() + at, fMax);
+            n++;
+            i++;
+         }
+      }
+   }
+
+   // Each visible run of grid points is one pass.
+   for (size_t i = 0; i < n; i++)
+   {
+      if (f[i] < 0.0)
+      {
+         continue;
+      }
+
+      cPass pass;
+      size_t first = i;
+
+      while ((i + 1 < n) && (f[i + 1] >= 0.0))
+      {
+         i++;
+      }
+
+      size_t last = i;
+
+      pass.m_fAosClipped = (first == 0);
+      pass.m_fLosClipped = (last  == n - 1);
+
+      pass.m_mpeAos = pass.m_fAosClipped ? t[first] :
+                      FindCrossing(t[first - 1], f[first - 1], t[first], f[first]);
+      pass.m_mpeLos = pass.m_fLosClipped ? t[last] :
+                      FindCrossing(t[last + 1], f[last + 1], t[last], f[last]);
+
+      // TCA: refine around the highest grid point of the pass.
+      size_t top = first;
+
+      for (size_t k = first; k <= last; k++)
+      {
+         if (f[k] > f[top])
+         {
+            top = k;
+         }
+      }
+
+      double a = (top > first) ? t[top - 1] : pass.m_mpeAos;
+      double b = (top < last)  ? t[top + 1] : pass.m_mpeLos;
+
+      pass.m_mpeTca = FindMaximum(a, b, &pass.m_radMaxEl);
+
+      if (pass.m_radMaxEl < f[top])
+      {
+         pass.m_mpeTca   = t[top];
+         pass.m_radMaxEl = f[top];
+      }
+
+      passes.push_back(pass);
+   }
+
+   return passes;
+}
+}
+}
@@ -0,0 +1,78 @@
+//
+// cPassPredictor.h
+//
+// This class finds the passes of a satellite over a ground site: the
+// acquisition (AOS), closest approach (TCA) and loss-of-signal (LOS)
+// times, where "visible" means the elevation returned by
+// cSite::GetLookAngle() is >= 0.
+//
+// Elevation is sampled on a coarse grid sized from the orbit period.
+// Horizon crossings are bracketed by sign changes on the grid and refined
+// with Brent's root finder; grazing passes that fall between two grid
+// points are caught as a local elevation maximum, refined with Brent's
+// minimizer and kept if it reaches the horizon.
+//
+#pragma once
+
+#include <vector>
+
+#include "cNoradBase.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+class cSatellite;
+class cSite;
+
+//////////////////////////////////////////////////////////////////////////////
+// struct cPass
+// Times are minutes past the satellite's TLE epoch. A pass already in
+// progress at the start (or still in progress at the end) of the search
+// window starts (or ends) at the window edge and is flagged as clipped.
+struct cPass
+{
+   double m_mpeAos;
+   double m_mpeTca;
+   double m_mpeLos;
+   double m_radMaxEl;    // elevation at TCA
+
+   bool   m_fAosClipped;
+   bool   m_fLosClipped;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+class cPassPredictor
+{
+public:
+   cPassPredictor(const cSatellite &sat, const cSite &site);
+
+   // Passes that overlap [mpeBegin, mpeEnd], in time order.
+   std::vector<cPass> FindPasses(double mpeBegin, double mpeEnd);
+
+   // Elevation (radians) of the satellite at mpe, as cSite::GetLookAngle().
+   double ElevationRad(double mpe);
+
+   // Coarse grid step, minutes, and root/maximum tolerance, minutes.
+   double Step() const { return m_minStep; }
+   double Tolerance() const { return m_minTolerance; }
+   void   SetTolerance(double minTolerance) { m_minTolerance = minTolerance; }
+
+   // Elevation evaluations made so far.
+   size_t EvaluationCount() const { return m_Evaluations; }
+
+protected:
+   double FindCrossing(double a, double fa, double b, double fb);
+   double FindMaximum (double a, double b, double *pfMax);
+
+   const cSatellite   &m_Sat;
+   const cSite        &m_Site;
+   cPropagationContext m_Context;
+
+   double m_minStep;
+   double m_minTolerance;
+   size_t m_Evaluations;
+};
+}
+}
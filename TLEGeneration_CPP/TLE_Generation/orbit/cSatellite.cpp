@@ -29,6 +29,20 @@ cSatellite::cSatellite(const cTle& tle, const std::string* pName /* = NULL */)
    }
 }
 
+cSatellite::cSatellite(const cOrbit& orbit, const std::string* pName /* = NULL */)
+{
+   m_pOrbit = new cOrbit(orbit);
+
+   if (pName != NULL)
+   {
+      m_pName = new string(*pName);
+   }
+   else
+   {
+      m_pName = new string(m_pOrbit->SatName());
+   }
+}
+
 cSatellite::cSatellite(const cSatellite& src)
 {
    cOrbit* pOrbit = dynamic_cast<cOrbit*>(src.m_pOrbit);
@@ -69,6 +83,28 @@ cEciTime cSatellite::PositionEci(double mpe) const
    return m_pOrbit->PositionEci(mpe);
 }
 
+// Calculates the ECI position of the satellite at each of the specified
+// numbers of minutes past the satellite epoch time.
+void cSatellite::PositionEciBatch(const double *mpe, size_t count, 
+                                  const cEciArrays &eci) const
+{
+   m_pOrbit->PositionEciBatch(mpe, count, eci);
+}
+
+// As PositionEci(mpe), continuing from the caller's propagation context.
+cEciTime cSatellite::PositionEci(double mpe, cPropagationContext &context) const
+{
+   return m_pOrbit->PositionEci(mpe, context);
+}
+
+// As PositionEciBatch(), continuing from the caller's propagation context.
+void cSatellite::PositionEciBatch(const double *mpe, size_t count, 
+                                  const cEciArrays &eci,
+                                  cPropagationContext &context) const
+{
+   m_pOrbit->PositionEciBatch(mpe, count, eci, context);
+}
+
 // Calculates the ECI position of the satellite at the specified time.
 cEciTime cSatellite::PositionEci(const cJulian& time) const
 {
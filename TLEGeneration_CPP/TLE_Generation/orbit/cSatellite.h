@@ -22,6 +22,7 @@ class cSatellite
 {
 public:
    cSatellite(const cTle& tle, const std::string* pName = NULL);
+   cSatellite(const cOrbit& orbit, const std::string* pName = NULL);
    cSatellite(const cSatellite& src);
    cSatellite& operator=(const cSatellite& rhs);
    ~cSatellite();
@@ -29,6 +30,14 @@ public:
    string   Name() const;
    cEciTime PositionEci(const cJulian& time) const;
    cEciTime PositionEci(double mpe) const;
+   void     PositionEciBatch(const double *mpe, size_t count, 
+                             const cEciArrays &eci) const;
+
+   // Per-thread forms; see cOrbit and cPropagationContext.
+   cEciTime PositionEci(double mpe, cPropagationContext &context) const;
+   void     PositionEciBatch(const double *mpe, size_t count, 
+                             const cEciArrays &eci,
+                             cPropagationContext &context) const;
 
    const cOrbit& Orbit() const { return *m_pOrbit; }      
 
@@ -0,0 +1,91 @@
+//
+// cSgp4Kernel.cpp
+//
+// Run-time selection of the SGP4 vector kernels.
+//
+#include "stdafx.h"
+
+#include "cSgp4Kernel.h"
+
+#if defined(SGP4_X86_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+static eSimdLevel s_SimdLevelLimit = SIMD_AVX512;
+
+//////////////////////////////////////////////////////////////////////////////
+// DetectSimdLevel()
+// Asks the CPU (and, through XCR0, the OS) which vector registers can be
+// used. Always SIMD_SCALAR on non-x86 builds.
+static eSimdLevel DetectSimdLevel()
+{
+   eSimdLevel level = SIMD_SCALAR;
+
+#if defined(SGP4_X86_KERNELS) && defined(__GNUC__)
+   __builtin_cpu_init();
+
+   if (__builtin_cpu_supports("avx512f"))
+   {
+      level = SIMD_AVX512;
+   }
+   else if (__builtin_cpu_supports("avx2"))
+   {
+      level = SIMD_AVX2;
+   }
+#elif defined(SGP4_X86_KERNELS) && defined(_MSC_VER)
+   int info[4];
+
+   __cpuid(info, 0);
+
+   int maxLeaf = info[0];
+
+   __cpuid(info, 1);
+
+   bool fOsxsave = (info[2] & (1 << 27)) != 0;
+   bool fAvx     = (info[2] & (1 << 28)) != 0;
+
+   if (fOsxsave && fAvx && (maxLeaf >= 7))
+   {
+      unsigned long long xcr0 = _xgetbv(0);
+
+      __cpuidex(info, 7, 0);
+
+      // YMM state enabled, AVX2 present
+      if (((xcr0 & 0x06) == 0x06) && (info[1] & (1 << 5)))
+      {
+         level = SIMD_AVX2;
+
+         // ZMM and opmask state enabled, AVX-512F present
+         if (((xcr0 & 0xE6) == 0xE6) && (info[1] & (1 << 16)))
+         {
+            level = SIMD_AVX512;
+         }
+      }
+   }
+#endif
+
+   return level;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// SimdLevelSupported()
+eSimdLevel SimdLevelSupported()
+{
+   static const eSimdLevel level = DetectSimdLevel();
+
+   return (level > s_SimdLevelLimit) ? s_SimdLevelLimit : level;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// SetSimdLevelLimit()
+void SetSimdLevelLimit(eSimdLevel level)
+{
+   s_SimdLevelLimit = level;
+}
+}
+}
\ No newline at end of file
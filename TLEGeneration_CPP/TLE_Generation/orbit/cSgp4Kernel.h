@@ -0,0 +1,106 @@
+//
+// cSgp4Kernel.h
+//
+// Interface between the SGP4 callers (cSgp4Table, cNoradSGP4) and the
+// instruction-set specific kernels (cSgp4KernelAvx2.cpp,
+// cSgp4KernelAvx512.cpp).
+//
+// The kernel translation units are compiled with AVX code generation
+// enabled, so this header must stay free of anything that emits code the
+// rest of the library could end up linking against: no globals.h (its
+// XKE / QOMS2T constants are dynamically initialized), no cEci.h, no
+// inline utility functions. Everything a kernel needs is passed in
+// cSgp4KernelArgs.
+//
+#pragma once
+
+#include <stddef.h>
+
+#include "cNoradBase.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SGP4_X86_KERNELS
+#endif
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+//////////////////////////////////////////////////////////////////////////////
+// Instruction sets a kernel can be dispatched to, in increasing order.
+enum eSimdLevel
+{
+   SIMD_SCALAR,   // cNoradSGP4::Propagate(), one satellite at a time
+   SIMD_AVX2,     // 4 lanes
+   SIMD_AVX512    // 8 lanes
+};
+
+// Highest level supported by both the build and the running CPU, and no
+// higher than the limit set with SetSimdLevelLimit().
+eSimdLevel SimdLevelSupported();
+
+// Caps the level used by the library, e.g. SIMD_SCALAR to reproduce the
+// scalar results exactly. Meant to be called at start-up.
+void SetSimdLevelLimit(eSimdLevel level);
+
+//////////////////////////////////////////////////////////////////////////////
+// Columns of the SGP4 element table; each is one cNoradElements field
+// (m_isimp is stored as 1.0 / 0.0).
+enum eSgp4Column
+{
+   SGP4_XMO,    SGP4_OMEGAO, SGP4_XNODEO, SGP4_EO,     SGP4_XINCL,
+   SGP4_BSTAR,  SGP4_AODP,   SGP4_XNODP,  SGP4_COSIO,  SGP4_SINIO,
+   SGP4_ETA,    SGP4_C1,     SGP4_C4,     SGP4_XMDOT,  SGP4_OMGDOT,
+   SGP4_XNODOT, SGP4_XNODCF, SGP4_T2COF,  SGP4_AYCOF,  SGP4_XLCOF,
+   SGP4_X3THM1, SGP4_X1MTH2, SGP4_X7THM1, SGP4_ISIMP,  SGP4_C5,
+   SGP4_OMGCOF, SGP4_XMCOF,  SGP4_DELMO,  SGP4_SINMO,  SGP4_D2,
+   SGP4_D3,     SGP4_D4,     SGP4_T3COF,  SGP4_T4COF,  SGP4_T5COF,
+
+   SGP4_COLUMN_COUNT
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// struct cSgp4KernelArgs
+// One kernel call. The catalog kernels propagate satellite i of the
+// columns to tsince[i] minutes past its epoch, for i in [0, count). The
+// time kernels propagate one satellite to every tsince[i]; they do not
+// use m_pCol or m_pStatus.
+struct cSgp4KernelArgs
+{
+   const double *m_pCol[SGP4_COLUMN_COUNT];
+   const double *m_pTsince;
+   size_t        m_Count;
+
+   // Model constants (see globals.h)
+   double m_Xke;
+   double m_Ck2;
+   double m_Xkmper;
+
+   // Output scale factors applied to position and velocity
+   double m_PosScale;
+   double m_VelScale;
+
+   // Outputs. Entries whose status is not POS_OK are set to zero.
+   double        *m_pX;
+   double        *m_pY;
+   double        *m_pZ;
+   double        *m_pVx;
+   double        *m_pVy;
+   double        *m_pVz;
+   unsigned char *m_pStatus;   // cNoradBase::ePositionStatus
+};
+
+#ifdef SGP4_X86_KERNELS
+// Catalog kernels: one satellite per lane.
+void Sgp4KernelAvx2  (const cSgp4KernelArgs &args);
+void Sgp4KernelAvx512(const cSgp4KernelArgs &args);
+
+// Time kernels: one timestamp per lane. Only whole lane groups are
+// processed, and processing stops at the first group in which any sample
+// fails. Returns the number of samples written; the caller finishes the
+// rest with cNoradSGP4::Propagate(), which also reports the failure.
+size_t Sgp4TimeKernelAvx2  (const cNoradElements &el, const cSgp4KernelArgs &args);
+size_t Sgp4TimeKernelAvx512(const cNoradElements &el, const cSgp4KernelArgs &args);
+#endif
+}
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+//
+// cSgp4KernelAvx2.cpp
+//
+// SGP4 kernel, four satellites per AVX2 register. Built with AVX2 code
+// generation; see the note in cSgp4Kernel.h before adding includes.
+//
+#include "cSgp4Kernel.h"
+
+#ifdef SGP4_X86_KERNELS
+
+#include <immintrin.h>
+
+#include "cSgp4KernelImpl.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+namespace
+{
+//////////////////////////////////////////////////////////////////////////////
+struct cMask4
+{
+   __m256d m;
+
+   cMask4() { }
+   cMask4(__m256d a) : m(a) { }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+struct cLane4
+{
+   enum { WIDTH = 4 };
+   typedef cMask4 Mask;
+
+   __m256d v;
+
+   cLane4() { }
+   cLane4(double d)  : v(_mm256_set1_pd(d)) { }
+   cLane4(__m256d a) : v(a) { }
+
+   static cLane4 Load(const double *p)            { return _mm256_loadu_pd(p); }
+   static void   Store(double *p, const cLane4 &a) { _mm256_storeu_pd(p, a.v); }
+};
+
+inline cLane4 operator+(const cLane4 &a, const cLane4 &b) { return _mm256_add_pd(a.v, b.v); }
+inline cLane4 operator-(const cLane4 &a, const cLane4 &b) { return _mm256_sub_pd(a.v, b.v); }
+inline cLane4 operator*(const cLane4 &a, const cLane4 &b) { return _mm256_mul_pd(a.v, b.v); }
+inline cLane4 operator/(const cLane4 &a, const cLane4 &b) { return _mm256_div_pd(a.v, b.v); }
+inline cLane4 operator-(const cLane4 &a) { return _mm256_xor_pd(a.v, _mm256_set1_pd(-0.0)); }
+
+inline cMask4 operator< (const cLane4 &a, const cLane4 &b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+inline cMask4 operator> (const cLane4 &a, const cLane4 &b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+inline cMask4 operator<=(const cLane4 &a, const cLane4 &b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ); }
+inline cMask4 operator==(const cLane4 &a, const cLane4 &b) { return _mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ); }
+
+inline cMask4 operator&(const cMask4 &a, const cMask4 &b) { return _mm256_and_pd(a.m, b.m); }
+inline cMask4 operator|(const cMask4 &a, const cMask4 &b) { return _mm256_or_pd(a.m, b.m); }
+inline cMask4 AndNot(const cMask4 &a, const cMask4 &b)    { return _mm256_andnot_pd(b.m, a.m); }
+inline int    MaskBits(const cMask4 &a)                   { return _mm256_movemask_pd(a.m); }
+
+inline cLane4 Select(const cMask4 &m, const cLane4 &a, const cLane4 &b)
+{
+   return _mm256_blendv_pd(b.v, a.v, m.m);
+}
+
+inline cLane4 Sqrt (const cLane4 &a) { return _mm256_sqrt_pd(a.v); }
+inline cLane4 Floor(const cLane4 &a) { return _mm256_floor_pd(a.v); }
+inline cLane4 Abs  (const cLane4 &a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void Sgp4KernelAvx2(const cSgp4KernelArgs &args)
+{
+   Sgp4Lanes::RunKernel<cLane4>(args);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+size_t Sgp4TimeKernelAvx2(const cNoradElements &el, const cSgp4KernelArgs &args)
+{
+   return Sgp4Lanes::RunTimeKernel<cLane4>(el, args);
+}
+}
+}
+
+#endif
\ No newline at end of file
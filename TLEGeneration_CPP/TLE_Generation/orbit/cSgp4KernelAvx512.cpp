@@ -0,0 +1,100 @@
+//
+// cSgp4KernelAvx512.cpp
+//
+// SGP4 kernel, eight satellites per AVX-512 register. Built with AVX-512F
+// code generation; see the note in cSgp4Kernel.h before adding includes.
+// Only AVX-512F instructions are used.
+//
+#include "cSgp4Kernel.h"
+
+#ifdef SGP4_X86_KERNELS
+
+#include <immintrin.h>
+
+#include "cSgp4KernelImpl.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+namespace
+{
+//////////////////////////////////////////////////////////////////////////////
+struct cMask8
+{
+   __mmask8 m;
+
+   cMask8() { }
+   cMask8(__mmask8 a) : m(a) { }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+struct cLane8
+{
+   enum { WIDTH = 8 };
+   typedef cMask8 Mask;
+
+   __m512d v;
+
+   cLane8() { }
+   cLane8(double d)  : v(_mm512_set1_pd(d)) { }
+   cLane8(__m512d a) : v(a) { }
+
+   static cLane8 Load(const double *p)            { return _mm512_loadu_pd(p); }
+   static void   Store(double *p, const cLane8 &a) { _mm512_storeu_pd(p, a.v); }
+};
+
+// Sign-bit manipulation goes through the integer forms; the _pd logic
+// operations need AVX-512DQ.
+inline __m512d SignMaskOp(__m512d a, long long bits, bool fXor)
+{
+   __m512i ai = _mm512_castpd_si512(a);
+   __m512i bi = _mm512_set1_epi64(bits);
+
+   return _mm512_castsi512_pd(fXor ? _mm512_xor_epi64(ai, bi) : _mm512_and_epi64(ai, bi));
+}
+
+inline cLane8 operator+(const cLane8 &a, const cLane8 &b) { return _mm512_add_pd(a.v, b.v); }
+inline cLane8 operator-(const cLane8 &a, const cLane8 &b) { return _mm512_sub_pd(a.v, b.v); }
+inline cLane8 operator*(const cLane8 &a, const cLane8 &b) { return _mm512_mul_pd(a.v, b.v); }
+inline cLane8 operator/(const cLane8 &a, const cLane8 &b) { return _mm512_div_pd(a.v, b.v); }
+inline cLane8 operator-(const cLane8 &a) { return SignMaskOp(a.v, (long long)0x8000000000000000ULL, true); }
+
+inline cMask8 operator< (const cLane8 &a, const cLane8 &b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ); }
+inline cMask8 operator> (const cLane8 &a, const cLane8 &b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ); }
+inline cMask8 operator<=(const cLane8 &a, const cLane8 &b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_LE_OQ); }
+inline cMask8 operator==(const cLane8 &a, const cLane8 &b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_EQ_OQ); }
+
+inline cMask8 operator&(const cMask8 &a, const cMask8 &b) { return (__mmask8)(a.m & b.m); }
+inline cMask8 operator|(const cMask8 &a, const cMask8 &b) { return (__mmask8)(a.m | b.m); }
+inline cMask8 AndNot(const cMask8 &a, const cMask8 &b)    { return (__mmask8)(a.m & ~b.m); }
+inline int    MaskBits(const cMask8 &a)                   { return a.m; }
+
+inline cLane8 Select(const cMask8 &m, const cLane8 &a, const cLane8 &b)
+{
+   return _mm512_mask_blend_pd(m.m, b.v, a.v);
+}
+
+// The unmasked forms pass an undefined source vector to the masked
+// builtins, which GCC 12 reports as uninitialized; with every lane set,
+// the source is never read.
+inline cLane8 Sqrt (const cLane8 &a) { return _mm512_mask_sqrt_pd(a.v, 0xFF, a.v); }
+inline cLane8 Floor(const cLane8 &a) { return _mm512_mask_roundscale_pd(a.v, 0xFF, a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+inline cLane8 Abs  (const cLane8 &a) { return SignMaskOp(a.v, 0x7FFFFFFFFFFFFFFFLL, false); }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void Sgp4KernelAvx512(const cSgp4KernelArgs &args)
+{
+   Sgp4Lanes::RunKernel<cLane8>(args);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+size_t Sgp4TimeKernelAvx512(const cNoradElements &el, const cSgp4KernelArgs &args)
+{
+   return Sgp4Lanes::RunTimeKernel<cLane8>(el, args);
+}
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,575 @@
+//
+// cSgp4KernelImpl.h
+//
+// Lane-generic SGP4: cNoradSGP4::Propagate() and cNoradBase::FinalPosition()
+// transcribed over a vector type V holding one satellite (catalog kernels)
+// or one timestamp (time kernels) per lane. Included only by the kernel
+// translation units, each of which supplies its own V:
+//
+//   V(double)                    broadcast
+//   V::WIDTH, V::Mask            lane count, comparison result
+//   V::Load(p), V::Store(p, v)   unaligned load/store of WIDTH doubles
+//   + - * /, unary -             lane-wise arithmetic
+//   < > <= ==                    lane-wise compare, returning V::Mask
+//   & | AndNot(a, b)             mask logic; AndNot is a & ~b
+//   Select(m, a, b)              a where m is set, b elsewhere
+//   Sqrt(), Floor(), Abs()
+//   MaskBits(m)                  lane i of m as bit i of an int
+//
+// sin/cos/atan are the Cephes double-precision approximations, which agree
+// with the C library to within a couple of ulps over the ranges seen here.
+//
+#pragma once
+
+#include <string.h>
+
+#include "cSgp4Kernel.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+namespace Sgp4Lanes
+{
+// Local copies of the globals.h constants; see the note in cSgp4Kernel.h.
+const double KPI    = 3.141592653589793;
+const double KTWOPI = 2.0 * KPI;
+const double KPIO2  = KPI / 2.0;
+const double KPIO4  = KPI / 4.0;
+
+//////////////////////////////////////////////////////////////////////////////
+// SinCos()
+// Cephes sin()/cos(): reduce by multiples of pi/4 (three-part pi/4 for
+// extra precision), then pick the sine or cosine polynomial by octant.
+template <class V>
+inline void SinCos(const V &x, V &s, V &c)
+{
+   const double FOPI = 1.27323954473516268615;   // 4 / pi
+   const double DP1  = 7.85398125648498535156E-1;
+   const double DP2  = 3.77489470793079817668E-8;
+   const double DP3  = 2.69515142907905952645E-15;
+
+   V ax = Abs(x);
+   V y  = Floor(ax * V(FOPI));
+
+   // Round the octant up to an even number; j is then 0, 2, 4 or 6
+   y = y + (y - V(2.0) * Floor(y * V(0.5)));
+
+   V j = y - V(8.0) * Floor(y * V(0.125));
+   V z = ((ax - y * V(DP1)) - y * V(DP2)) - y * V(DP3);
+   V zz = z * z;
+
+   V ps = ((((( V( 1.58962301576546568060E-10)  * zz +
+                V(-2.50507477628578072866E-8))  * zz +
+                V( 2.75573136213857245213E-6))  * zz +
+                V(-1.98412698295895385996E-4))  * zz +
+                V( 8.33333333332211858878E-3))  * zz +
+                V(-1.66666666666666307295E-1));
+   ps = z + z * zz * ps;
+
+   V pc = ((((( V(-1.13585365213876817300E-11)  * zz +
+                V( 2.08757008419747316778E-9))  * zz +
+                V(-2.75573141792967388112E-7))  * zz +
+                V( 2.48015872888517045348E-5))  * zz +
+                V(-1.38888888888730564116E-3))  * zz +
+                V( 4.16666666666665929218E-2));
+   pc = V(1.0) - V(0.5) * zz + zz * zz * pc;
+
+   typename V::Mask j2 = (j == V(2.0));
+   typename V::Mask j4 = (j == V(4.0));
+   typename V::Mask j6 = (j == V(6.0));
+   typename V::Mask swap = j2 | j6;
+
+   V s0 = Select(swap, pc, ps);
+   V c0 = Select(swap, ps, pc);
+
+   s0 = Select(j4 | j6, -s0, s0);
+   s = Select(x < V(0.0), -s0, s0);
+   c = Select(j2 | j4, -c0, c0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Atan()
+// Cephes atan(): reduce to |x| <= tan(pi/8) by one of two identities and
+// evaluate a P/Q rational approximation.
+template <class V>
+inline V Atan(const V &x)
+{
+   const double T3P8     = 2.41421356237309504880;   // tan(3 pi / 8)
+   const double MOREBITS = 6.123233995736765886130E-17;
+
+   V ax = Abs(x);
+
+   typename V::Mask big = (ax > V(T3P8));
+   typename V::Mask mid = AndNot(ax > V(0.66), big);
+
+   V xr = Select(big, -(V(1.0) / ax),
+                      Select(mid, (ax - V(1.0)) / (ax + V(1.0)), ax));
+   V y0 = Select(big, V(KPIO2), Select(mid, V(KPIO4), V(0.0)));
+   V extra = Select(big, V(MOREBITS), Select(mid, V(0.5 * MOREBITS), V(0.0)));
+
+   V z = xr * xr;
+   V p = ((((V(-8.750608600031904122785E-1)  * z +
+             V(-1.615753718733365076637E1))  * z +
+             V(-7.500855792314704667340E1))  * z +
+             V(-1.228866684490136173410E2))  * z +
+             V(-6.485021904942025371773E1));
+   V q = (((((z + V(2.485846490142306297962E1))  * z +
+                  V(1.650270098316988542046E2))  * z +
+                  V(4.328810604912902668951E2))  * z +
+                  V(4.853903996359136964868E2))  * z +
+                  V(1.945506571482613964425E2));
+
+   V r = y0 + ((xr * (z * p / q) + xr) + extra);
+
+   return Select(x < V(0.0), -r, r);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// AcTan() - see globals.cpp
+template <class V>
+inline V AcTan(const V &sinx, const V &cosx)
+{
+   V r = Atan(sinx / cosx);
+
+   r = Select(cosx > V(0.0), r, r + V(KPI));
+
+   return Select(cosx == V(0.0),
+                 Select(sinx > V(0.0), V(KPI / 2.0), V(3.0 * KPI / 2.0)),
+                 r);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Fmod2p() - see globals.cpp
+template <class V>
+inline V Fmod2p(const V &x)
+{
+   return x - V(KTWOPI) * Floor(x * V(1.0 / KTWOPI));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// struct tElements
+// The cNoradElements fields used by SGP4, one satellite per lane.
+template <class V>
+struct tElements
+{
+   V xmo,    omegao, xnodeo, eo,     xincl,  bstar,  aodp,   xnodp;
+   V cosio,  sinio,  eta,    c1,     c4;
+   V xmdot,  omgdot, xnodot, xnodcf, t2cof;
+   V aycof,  xlcof,  x3thm1, x1mth2, x7thm1;
+   V c5,     omgcof, xmcof,  delmo,  sinmo;
+   V d2,     d3,     d4,     t3cof,  t4cof,  t5cof;
+
+   typename V::Mask full;   // lanes using the full (!isimp) equations
+
+   void Load(const double *const *col, size_t i)
+   {
+      xmo    = V::Load(col[SGP4_XMO]    + i);
+      omegao = V::Load(col[SGP4_OMEGAO] + i);
+      xnodeo = V::Load(col[SGP4_XNODEO] + i);
+      eo     = V::Load(col[SGP4_EO]     + i);
+      xincl  = V::Load(col[SGP4_XINCL]  + i);
+      bstar  = V::Load(col[SGP4_BSTAR]  + i);
+      aodp   = V::Load(col[SGP4_AODP]   + i);
+      xnodp  = V::Load(col[SGP4_XNODP]  + i);
+      cosio  = V::Load(col[SGP4_COSIO]  + i);
+      sinio  = V::Load(col[SGP4_SINIO]  + i);
+      eta    = V::Load(col[SGP4_ETA]    + i);
+      c1     = V::Load(col[SGP4_C1]     + i);
+      c4     = V::Load(col[SGP4_C4]     + i);
+      xmdot  = V::Load(col[SGP4_XMDOT]  + i);
+      omgdot = V::Load(col[SGP4_OMGDOT] + i);
+      xnodot = V::Load(col[SGP4_XNODOT] + i);
+      xnodcf = V::Load(col[SGP4_XNODCF] + i);
+      t2cof  = V::Load(col[SGP4_T2COF]  + i);
+      aycof  = V::Load(col[SGP4_AYCOF]  + i);
+      xlcof  = V::Load(col[SGP4_XLCOF]  + i);
+      x3thm1 = V::Load(col[SGP4_X3THM1] + i);
+      x1mth2 = V::Load(col[SGP4_X1MTH2] + i);
+      x7thm1 = V::Load(col[SGP4_X7THM1] + i);
+      c5     = V::Load(col[SGP4_C5]     + i);
+      omgcof = V::Load(col[SGP4_OMGCOF] + i);
+      xmcof  = V::Load(col[SGP4_XMCOF]  + i);
+      delmo  = V::Load(col[SGP4_DELMO]  + i);
+      sinmo  = V::Load(col[SGP4_SINMO]  + i);
+      d2     = V::Load(col[SGP4_D2]     + i);
+      d3     = V::Load(col[SGP4_D3]     + i);
+      d4     = V::Load(col[SGP4_D4]     + i);
+      t3cof  = V::Load(col[SGP4_T3COF]  + i);
+      t4cof  = V::Load(col[SGP4_T4COF]  + i);
+      t5cof  = V::Load(col[SGP4_T5COF]  + i);
+
+      full = (V::Load(col[SGP4_ISIMP] + i) == V(0.0));
+   }
+
+   void Broadcast(const cNoradElements &el)
+   {
+      xmo    = V(el.m_xmo);
+      omegao = V(el.m_omegao);
+      xnodeo = V(el.m_xnodeo);
+      eo     = V(el.m_eo);
+      xincl  = V(el.m_xincl);
+      bstar  = V(el.m_bstar);
+      aodp   = V(el.m_aodp);
+      xnodp  = V(el.m_xnodp);
+      cosio  = V(el.m_cosio);
+      sinio  = V(el.m_sinio);
+      eta    = V(el.m_eta);
+      c1     = V(el.m_c1);
+      c4     = V(el.m_c4);
+      xmdot  = V(el.m_xmdot);
+      omgdot = V(el.m_omgdot);
+      xnodot = V(el.m_xnodot);
+      xnodcf = V(el.m_xnodcf);
+      t2cof  = V(el.m_t2cof);
+      aycof  = V(el.m_aycof);
+      xlcof  = V(el.m_xlcof);
+      x3thm1 = V(el.m_x3thm1);
+      x1mth2 = V(el.m_x1mth2);
+      x7thm1 = V(el.m_x7thm1);
+      c5     = V(el.m_c5);
+      omgcof = V(el.m_omgcof);
+      xmcof  = V(el.m_xmcof);
+      delmo  = V(el.m_delmo);
+      sinmo  = V(el.m_sinmo);
+      d2     = V(el.m_d2);
+      d3     = V(el.m_d3);
+      d4     = V(el.m_d4);
+      t3cof  = V(el.m_t3cof);
+      t4cof  = V(el.m_t4cof);
+      t5cof  = V(el.m_t5cof);
+
+      full = (V(el.m_isimp ? 1.0 : 0.0) == V(0.0));
+   }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Position()
+// SGP4 position (AE) and velocity (AE/min) of every lane at t. Lanes whose
+// eccentricity goes out of range are flagged in "error", lanes below the
+// surface of the earth in "decayed"; their outputs are meaningless.
+template <class V>
+inline void Position(const tElements<V> &el, const V &t,
+                     const cSgp4KernelArgs &k, V out[6],
+                     typename V::Mask &error, typename V::Mask &decayed)
+{
+   typedef typename V::Mask M;
+
+   // Update for secular gravity and atmospheric drag.
+   V xmdf   = el.xmo    + el.xmdot  * t;
+   V omgadf = el.omegao + el.omgdot * t;
+   V xnoddf = el.xnodeo + el.xnodot * t;
+   V omega  = omgadf;
+   V xmp    = xmdf;
+   V tsq    = t * t;
+   V xnode  = xnoddf + el.xnodcf * tsq;
+   V tempa  = V(1.0) - el.c1 * t;
+   V tempe  = el.bstar * el.c4 * t;
+   V templ  = el.t2cof * tsq;
+
+   // The isimp branch: lanes with the isimp flag keep the truncated
+   // equations above, the rest get the full drag terms.
+   if (MaskBits(el.full))
+   {
+      V sinx, cosx;
+
+      SinCos(xmdf, sinx, cosx);
+
+      V delomg = el.omgcof * t;
+      V delmb  = V(1.0) + el.eta * cosx;
+      V delm   = el.xmcof * (delmb * delmb * delmb - el.delmo);
+      V temp   = delomg + delm;
+
+      V xmpFull = xmdf + temp;
+
+      SinCos(xmpFull, sinx, cosx);
+
+      V tcube = tsq * t;
+      V tfour = t * tcube;
+
+      xmp   = Select(el.full, xmpFull, xmp);
+      omega = Select(el.full, omgadf - temp, omega);
+      tempa = Select(el.full, tempa - el.d2 * tsq - el.d3 * tcube - el.d4 * tfour, tempa);
+      tempe = Select(el.full, tempe + el.bstar * el.c5 * (sinx - el.sinmo), tempe);
+      templ = Select(el.full, templ + el.t3cof * tcube + tfour * (el.t4cof + t * el.t5cof), templ);
+   }
+
+   V a  = el.aodp * tempa * tempa;
+   V e  = el.eo - tempe;
+   V xl = xmp + omega + xnode + el.xnodp * templ;
+   V xn = V(k.m_Xke) / (a * Sqrt(a));
+
+   // FinalPosition(), called with omgadf as in the scalar code
+   error = (e * e > V(1.0));
+
+   V beta = Sqrt(V(1.0) - e * e);
+
+   // Long period periodics
+   V sinw, cosw;
+
+   SinCos(omgadf, sinw, cosw);
+
+   V axn  = e * cosw;
+   V temp = V(1.0) / (a * beta * beta);
+
+   V xll  = temp * el.xlcof * axn;
+   V aynl = temp * el.aycof;
+   V xlt  = xl + xll;
+   V ayn  = e * sinw + aynl;
+
+   // Solve Kepler's Equation. Each lane stops updating once it has
+   // converged, exactly as the scalar loop exits; the group stops when all
+   // lanes are done.
+   const double E6A = 1.0e-06;
+
+   V capu   = Fmod2p(xlt - xnode);
+   V temp2  = capu;
+   V temp3  = V(0.0);
+   V temp4  = V(0.0);
+   V temp5  = V(0.0);
+   V temp6  = V(0.0);
+   V sinepw = V(0.0);
+   V cosepw = V(0.0);
+   M active = AndNot(V(0.0) == V(0.0), error);
+
+   for (int i = 1; (i <= 10) && MaskBits(active); i++)
+   {
+      V s, c;
+
+      SinCos(temp2, s, c);
+
+      sinepw = Select(active, s, sinepw);
+      cosepw = Select(active, c, cosepw);
+      temp3  = Select(active, axn * s, temp3);
+      temp4  = Select(active, ayn * c, temp4);
+      temp5  = Select(active, axn * c, temp5);
+      temp6  = Select(active, ayn * s, temp6);
+
+      V epw = (capu - temp4 + temp3 - temp2) /
+              (V(1.0) - temp5 - temp6) + temp2;
+
+      M done = (Abs(epw - temp2) <= V(E6A));
+
+      active = AndNot(active, done);
+      temp2  = Select(active, epw, temp2);
+   }
+
+   // Short period preliminary quantities
+   V ecose = temp5 + temp6;
+   V esine = temp3 - temp4;
+   V elsq  = axn * axn + ayn * ayn;
+   temp  = V(1.0) - elsq;
+   V pl = a * temp;
+   V r  = a * (V(1.0) - ecose);
+   V temp1 = V(1.0) / r;
+   V rdot  = V(k.m_Xke) * Sqrt(a) * esine * temp1;
+   V rfdot = V(k.m_Xke) * Sqrt(pl) * temp1;
+   temp2 = a * temp1;
+   V betal = Sqrt(temp);
+   temp3 = V(1.0) / (V(1.0) + betal);
+   V cosu  = temp2 * (cosepw - axn + ayn * esine * temp3);
+   V sinu  = temp2 * (sinepw - ayn - axn * esine * temp3);
+   V u     = AcTan(sinu, cosu);
+   V sin2u = V(2.0) * sinu * cosu;
+   V cos2u = V(2.0) * cosu * cosu - V(1.0);
+
+   temp  = V(1.0) / pl;
+   temp1 = V(k.m_Ck2) * temp;
+   temp2 = temp1 * temp;
+
+   // Update for short periodics
+   V rk = r * (V(1.0) - V(1.5) * temp2 * betal * el.x3thm1) +
+          V(0.5) * temp1 * el.x1mth2 * cos2u;
+   V uk = u - V(0.25) * temp2 * el.x7thm1 * sin2u;
+   V xnodek = xnode + V(1.5) * temp2 * el.cosio * sin2u;
+   V xinck  = el.xincl + V(1.5) * temp2 * el.cosio * el.sinio * cos2u;
+   V rdotk  = rdot - xn * temp1 * el.x1mth2 * sin2u;
+   V rfdotk = rfdot + xn * temp1 * (el.x1mth2 * cos2u + V(1.5) * el.x3thm1);
+
+   // Orientation vectors
+   V sinuk, cosuk, sinik, cosik, sinnok, cosnok;
+
+   SinCos(uk,     sinuk,  cosuk);
+   SinCos(xinck,  sinik,  cosik);
+   SinCos(xnodek, sinnok, cosnok);
+
+   V xmx = -sinnok * cosik;
+   V xmy = cosnok * cosik;
+   V ux  = xmx * sinuk + cosnok * cosuk;
+   V uy  = xmy * sinuk + sinnok * cosuk;
+   V uz  = sinik * sinuk;
+   V vx  = xmx * cosuk - cosnok * sinuk;
+   V vy  = xmy * cosuk - sinnok * sinuk;
+   V vz  = sinik * cosuk;
+
+   // Position
+   V x = rk * ux;
+   V y = rk * uy;
+   V z = rk * uz;
+
+   // Validate on altitude
+   V altKm = Sqrt(x * x + y * y + z * z) * V(k.m_Xkmper);
+
+   decayed = AndNot(altKm < V(k.m_Xkmper), error);
+
+   // Velocity
+   out[0] = x;
+   out[1] = y;
+   out[2] = z;
+   out[3] = rdotk * ux + rfdotk * vx;
+   out[4] = rdotk * uy + rfdotk * vy;
+   out[5] = rdotk * uz + rfdotk * vz;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Store()
+// Scales and writes one group of results and their status codes; failed
+// lanes are written as zero.
+template <class V>
+inline void Store(const cSgp4KernelArgs &k, size_t i, V out[6],
+                  typename V::Mask error, typename V::Mask decayed)
+{
+   typename V::Mask ok = AndNot(AndNot(V(0.0) == V(0.0), error), decayed);
+
+   V::Store(k.m_pX  + i, Select(ok, out[0] * V(k.m_PosScale), V(0.0)));
+   V::Store(k.m_pY  + i, Select(ok, out[1] * V(k.m_PosScale), V(0.0)));
+   V::Store(k.m_pZ  + i, Select(ok, out[2] * V(k.m_PosScale), V(0.0)));
+   V::Store(k.m_pVx + i, Select(ok, out[3] * V(k.m_VelScale), V(0.0)));
+   V::Store(k.m_pVy + i, Select(ok, out[4] * V(k.m_VelScale), V(0.0)));
+   V::Store(k.m_pVz + i, Select(ok, out[5] * V(k.m_VelScale), V(0.0)));
+
+   int errorBits = MaskBits(error);
+   int decayBits = MaskBits(decayed);
+
+   for (int lane = 0; lane < V::WIDTH; lane++)
+   {
+      unsigned char status = cNoradBase::POS_OK;
+
+      if (errorBits & (1 << lane))
+      {
+         status = cNoradBase::POS_ERROR;
+      }
+      else if (decayBits & (1 << lane))
+      {
+         status = cNoradBase::POS_DECAYED;
+      }
+
+      k.m_pStatus[i + lane] = status;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// RunKernel()
+// Propagates the whole table, V::WIDTH satellites at a time. A partial last
+// group is padded with copies of its first satellite.
+template <class V>
+void RunKernel(const cSgp4KernelArgs &args)
+{
+   typedef typename V::Mask M;
+
+   const size_t W     = V::WIDTH;
+   const size_t count = args.m_Count;
+   const size_t whole = count - (count % W);
+
+   tElements<V> el;
+   V out[6];
+   M error, decayed;
+
+   for (size_t i = 0; i < whole; i += W)
+   {
+      el.Load(args.m_pCol, i);
+      Position(el, V::Load(args.m_pTsince + i), args, out, error, decayed);
+      Store(args, i, out, error, decayed);
+   }
+
+   if (whole < count)
+   {
+      const size_t rest = count - whole;
+
+      double padCol[SGP4_COLUMN_COUNT][V::WIDTH];
+      const double *pPadCol[SGP4_COLUMN_COUNT];
+      double padT[V::WIDTH];
+      double padOut[6][V::WIDTH];
+      unsigned char padStatus[V::WIDTH];
+
+      for (size_t lane = 0; lane < W; lane++)
+      {
+         size_t src = whole + ((lane < rest) ? lane : 0);
+
+         for (int c = 0; c < SGP4_COLUMN_COUNT; c++)
+         {
+            padCol[c][lane] = args.m_pCol[c][src];
+         }
+
+         padT[lane] = args.m_pTsince[src];
+      }
+
+      for (int c = 0; c < SGP4_COLUMN_COUNT; c++)
+      {
+         pPadCol[c] = padCol[c];
+      }
+
+      cSgp4KernelArgs padArgs = args;
+
+      padArgs.m_pX      = padOut[0];
+      padArgs.m_pY      = padOut[1];
+      padArgs.m_pZ      = padOut[2];
+      padArgs.m_pVx     = padOut[3];
+      padArgs.m_pVy     = padOut[4];
+      padArgs.m_pVz     = padOut[5];
+      padArgs.m_pStatus = padStatus;
+
+      el.Load(pPadCol, 0);
+      Position(el, V::Load(padT), args, out, error, decayed);
+      Store(padArgs, 0, out, error, decayed);
+
+      memcpy(args.m_pX  + whole, padOut[0], rest * sizeof(double));
+      memcpy(args.m_pY  + whole, padOut[1], rest * sizeof(double));
+      memcpy(args.m_pZ  + whole, padOut[2], rest * sizeof(double));
+      memcpy(args.m_pVx + whole, padOut[3], rest * sizeof(double));
+      memcpy(args.m_pVy + whole, padOut[4], rest * sizeof(double));
+      memcpy(args.m_pVz + whole, padOut[5], rest * sizeof(double));
+      memcpy(args.m_pStatus + whole, padStatus, rest);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// RunTimeKernel()
+// Propagates one satellite to V::WIDTH timestamps at a time. See
+// Sgp4TimeKernelAvx2() for the contract.
+template <class V>
+size_t RunTimeKernel(const cNoradElements &elements, const cSgp4KernelArgs &args)
+{
+   typedef typename V::Mask M;
+
+   const size_t W     = V::WIDTH;
+   const size_t whole = args.m_Count - (args.m_Count % W);
+
+   tElements<V> el;
+   V out[6];
+   M error, decayed;
+
+   el.Broadcast(elements);
+
+   for (size_t i = 0; i < whole; i += W)
+   {
+      Position(el, V::Load(args.m_pTsince + i), args, out, error, decayed);
+
+      if (MaskBits(error | decayed))
+      {
+         return i;
+      }
+
+      V::Store(args.m_pX  + i, out[0] * V(args.m_PosScale));
+      V::Store(args.m_pY  + i, out[1] * V(args.m_PosScale));
+      V::Store(args.m_pZ  + i, out[2] * V(args.m_PosScale));
+      V::Store(args.m_pVx + i, out[3] * V(args.m_VelScale));
+      V::Store(args.m_pVy + i, out[4] * V(args.m_VelScale));
+      V::Store(args.m_pVz + i, out[5] * V(args.m_VelScale));
+   }
+
+   return whole;
+}
+}
+}
+}
\ No newline at end of file
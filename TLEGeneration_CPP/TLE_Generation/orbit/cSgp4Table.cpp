@@ -0,0 +1,206 @@
+//
+// cSgp4Table.cpp
+//
+#include "stdafx.h"
+
+#include "cSgp4Table.h"
+#include "cNoradSGP4.h"
+#include "cOrbit.h"
+#include "cEci.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+//////////////////////////////////////////////////////////////////////////////
+cSgp4Table::cSgp4Table() :
+   m_SimdLevel(SimdLevelSupported())
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Add()
+bool cSgp4Table::Add(const cOrbit &orbit)
+{
+   if (orbit.IsDeepSpace())
+   {
+      return false;
+   }
+
+   Add(orbit.NoradElements(), orbit.Epoch());
+
+   return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Add()
+void cSgp4Table::Add(const cNoradElements &el, const cJulian &epoch)
+{
+   m_Col[SGP4_XMO   ].push_back(el.m_xmo);
+   m_Col[SGP4_OMEGAO].push_back(el.m_omegao);
+   m_Col[SGP4_XNODEO].push_back(el.m_xnodeo);
+   m_Col[SGP4_EO    ].push_back(el.m_eo);
+   m_Col[SGP4_XINCL ].push_back(el.m_xincl);
+   m_Col[SGP4_BSTAR ].push_back(el.m_bstar);
+   m_Col[SGP4_AODP  ].push_back(el.m_aodp);
+   m_Col[SGP4_XNODP ].push_back(el.m_xnodp);
+   m_Col[SGP4_COSIO ].push_back(el.m_cosio);
+   m_Col[SGP4_SINIO ].push_back(el.m_sinio);
+   m_Col[SGP4_ETA   ].push_back(el.m_eta);
+   m_Col[SGP4_C1    ].push_back(el.m_c1);
+   m_Col[SGP4_C4    ].push_back(el.m_c4);
+   m_Col[SGP4_XMDOT ].push_back(el.m_xmdot);
+   m_Col[SGP4_OMGDOT].push_back(el.m_omgdot);
+   m_Col[SGP4_XNODOT].push_back(el.m_xnodot);
+   m_Col[SGP4_XNODCF].push_back(el.m_xnodcf);
+   m_Col[SGP4_T2COF ].push_back(el.m_t2cof);
+   m_Col[SGP4_AYCOF ].push_back(el.m_aycof);
+   m_Col[SGP4_XLCOF ].push_back(el.m_xlcof);
+   m_Col[SGP4_X3THM1].push_back(el.m_x3thm1);
+   m_Col[SGP4_X1MTH2].push_back(el.m_x1mth2);
+   m_Col[SGP4_X7THM1].push_back(el.m_x7thm1);
+   m_Col[SGP4_ISIMP ].push_back(el.m_isimp ? 1.0 : 0.0);
+   m_Col[SGP4_C5    ].push_back(el.m_c5);
+   m_Col[SGP4_OMGCOF].push_back(el.m_omgcof);
+   m_Col[SGP4_XMCOF ].push_back(el.m_xmcof);
+   m_Col[SGP4_DELMO ].push_back(el.m_delmo);
+   m_Col[SGP4_SINMO ].push_back(el.m_sinmo);
+   m_Col[SGP4_D2    ].push_back(el.m_d2);
+   m_Col[SGP4_D3    ].push_back(el.m_d3);
+   m_Col[SGP4_D4    ].push_back(el.m_d4);
+   m_Col[SGP4_T3COF ].push_back(el.m_t3cof);
+   m_Col[SGP4_T4COF ].push_back(el.m_t4cof);
+   m_Col[SGP4_T5COF ].push_back(el.m_t5cof);
+
+   m_Elements.push_back(el);
+   m_Epoch.push_back(epoch);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Clear()
+void cSgp4Table::Clear()
+{
+   for (int c = 0; c < SGP4_COLUMN_COUNT; c++)
+   {
+      m_Col[c].clear();
+   }
+
+   m_Elements.clear();
+   m_Epoch.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// SetSimdLevel()
+void cSgp4Table::SetSimdLevel(eSimdLevel level)
+{
+   eSimdLevel supported = SimdLevelSupported();
+
+   m_SimdLevel = (level > supported) ? supported : level;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PositionEciBatch()
+size_t cSgp4Table::PositionEciBatch(const double *tsince,
+                                    const cEciArrays &eci,
+                                    unsigned char *status) const
+{
+   const size_t count    = Size();
+   const double radiusAe = XKMPER_WGS72 / AE;
+   const double velScale = radiusAe * (MIN_PER_DAY / 86400);
+
+   if (count == 0)
+   {
+      return 0;
+   }
+
+#ifdef SGP4_X86_KERNELS
+   if (m_SimdLevel != SIMD_SCALAR)
+   {
+      cSgp4KernelArgs args;
+
+      for (int c = 0; c < SGP4_COLUMN_COUNT; c++)
+      {
+         args.m_pCol[c] = &m_Col[c][0];
+      }
+
+      args.m_pTsince  = tsince;
+      args.m_Count    = count;
+      args.m_Xke      = XKE;
+      args.m_Ck2      = CK2;
+      args.m_Xkmper   = XKMPER_WGS72;
+      args.m_PosScale = radiusAe;
+      args.m_VelScale = velScale;
+      args.m_pX       = eci.m_x;
+      args.m_pY       = eci.m_y;
+      args.m_pZ       = eci.m_z;
+      args.m_pVx      = eci.m_vx;
+      args.m_pVy      = eci.m_vy;
+      args.m_pVz      = eci.m_vz;
+      args.m_pStatus  = status;
+
+      if (m_SimdLevel == SIMD_AVX512)
+      {
+         Sgp4KernelAvx512(args);
+      }
+      else
+      {
+         Sgp4KernelAvx2(args);
+      }
+
+      size_t failed = 0;
+
+      for (size_t i = 0; i < count; i++)
+      {
+         failed += (status[i] != cNoradBase::POS_OK);
+      }
+
+      return failed;
+   }
+#endif
+
+   size_t failed = 0;
+
+   for (size_t i = 0; i < count; i++)
+   {
+      cNoradBase::ePositionStatus result =
+         cNoradSGP4::Propagate(m_Elements[i], tsince[i], eci, i);
+
+      if (result == cNoradBase::POS_OK)
+      {
+         eci.m_x [i] *= radiusAe;   // km
+         eci.m_y [i] *= radiusAe;
+         eci.m_z [i] *= radiusAe;
+         eci.m_vx[i] *= velScale;   // km/sec
+         eci.m_vy[i] *= velScale;
+         eci.m_vz[i] *= velScale;
+      }
+      else
+      {
+         eci.m_x [i] = eci.m_y [i] = eci.m_z [i] = 0.0;
+         eci.m_vx[i] = eci.m_vy[i] = eci.m_vz[i] = 0.0;
+         failed++;
+      }
+
+      status[i] = (unsigned char)result;
+   }
+
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PositionEciBatch()
+size_t cSgp4Table::PositionEciBatch(const cJulian &gmt,
+                                    const cEciArrays &eci,
+                                    unsigned char *status) const
+{
+   std::vector<double> tsince(Size());
+
+   for (size_t i = 0; i < tsince.size(); i++)
+   {
+      tsince[i] = gmt.SpanMin(m_Epoch[i]);
+   }
+
+   return PositionEciBatch(tsince.empty() ? NULL : &tsince[0], eci, status);
+}
+}
+}
\ No newline at end of file
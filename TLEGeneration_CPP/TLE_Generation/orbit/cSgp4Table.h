@@ -0,0 +1,72 @@
+//
+// cSgp4Table.h
+//
+// This class holds the compiled SGP4 elements of many near-earth
+// satellites as a structure of arrays (one array per cNoradElements field)
+// and propagates the whole table at once, four or eight satellites per
+// instruction with the AVX2 / AVX-512 kernels when the CPU has them. It
+// is intended for screening large catalogs at a common instant.
+//
+// Deep-space (SDP4) orbits cannot be added; propagate those with cOrbit.
+//
+#pragma once
+
+#include <vector>
+
+#include "cJulian.h"
+#include "cNoradBase.h"
+#include "cSgp4Kernel.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+class cOrbit;
+struct cEciArrays;
+
+//////////////////////////////////////////////////////////////////////////////
+class cSgp4Table
+{
+public:
+   cSgp4Table();
+
+   // Appends the orbit's elements. Returns false, leaving the table
+   // unchanged, if the orbit uses the SDP4 model.
+   bool Add(const cOrbit &orbit);
+
+   // Appends a near-earth element record directly, e.g. from a
+   // cOrbitSnapshot.
+   void Add(const cNoradElements &el, const cJulian &epoch);
+
+   void   Clear();
+   size_t Size() const { return m_Epoch.size(); }
+
+   cJulian Epoch(size_t i) const { return m_Epoch[i]; }
+
+   // Kernel used by PositionEciBatch(). Defaults to, and is limited to,
+   // SimdLevelSupported().
+   void       SetSimdLevel(eSimdLevel level);
+   eSimdLevel SimdLevel() const { return m_SimdLevel; }
+
+   // Writes the ECI position (km) and velocity (km/sec) of satellite i at
+   // tsince[i] minutes past its own epoch into element i of "eci", for
+   // every satellite in the table. status[i] receives the
+   // cNoradBase::ePositionStatus of satellite i; failed entries are zero.
+   // Returns the number of failed entries.
+   size_t PositionEciBatch(const double *tsince, const cEciArrays &eci,
+                           unsigned char *status) const;
+
+   // As above, with every satellite at the same time "gmt".
+   size_t PositionEciBatch(const cJulian &gmt, const cEciArrays &eci,
+                           unsigned char *status) const;
+
+protected:
+   std::vector<double>         m_Col[SGP4_COLUMN_COUNT];
+   std::vector<cNoradElements> m_Elements;   // for the scalar path
+   std::vector<cJulian>        m_Epoch;
+
+   eSimdLevel m_SimdLevel;
+};
+}
+}
\ No newline at end of file
@@ -0,0 +1,232 @@
+//
+// cVisibilityScreen.cpp
+//
+#include "stdafx.h"
+
+#include <float.h>
+
+#include "cVisibilityScreen.h"
+#include "cOrbit.h"
+#include "cSite.h"
+#include "exceptions.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+// Margins that keep the bounds safe against what the two-body figures
+// leave out: SGP4/SDP4 short-period and resonance terms and drag move the
+// radius beyond the recovered perigee and apogee and change the angular
+// momentum.
+static const double SCREEN_RADIUS_MARGIN_KM = 50.0;
+static const double SCREEN_RADIUS_MARGIN    = 0.02;
+static const double SCREEN_RATE_MARGIN      = 1.25;
+
+// Lowest elevation treated as visible: below the horizon by the
+// refraction margin of cSite::IsBelowHorizon() and by the largest angle
+// between the geodetic zenith and the geocentric direction of a site
+// (about 0.19 degrees), which the cone geometry is built on.
+static const double SCREEN_ELEVATION_MIN = deg2rad(-1.0 - 0.2);
+
+//////////////////////////////////////////////////////////////////////////////
+cVisibilityScreen::cVisibilityScreen(const cOrbit &orbit) :
+   m_Orbit(orbit),
+   m_Evaluations(0)
+{
+   double rp = orbit.Perigee() + XKMPER_WGS72;
+   double ra = orbit.Apogee()  + XKMPER_WGS72;
+
+   m_kmRadiusMin = rp * (1.0 - SCREEN_RADIUS_MARGIN) - SCREEN_RADIUS_MARGIN_KM;
+   m_kmRadiusMax = ra * (1.0 + SCREEN_RADIUS_MARGIN) + SCREEN_RADIUS_MARGIN_KM;
+
+   // Largest inertial angular rate, at the least radius, from the angular
+   // momentum per unit mass (km^2/sec)
+   double h = sqrt(GE * 2.0 * rp * ra / (rp + ra));
+
+   m_radPerMinInertial = h / sqr(m_kmRadiusMin) * 60.0 * SCREEN_RATE_MARGIN;
+
+   // The earth's rotation adds to it in the Earth-fixed frame
+   m_radPerMin = m_radPerMinInertial + TWOPI * (OMEGA_E / SEC_PER_DAY) * 60.0;
+
+   // A decaying orbit, one whose perigee may reach the surface, is not
+   // screened: propagation fails there, and may do so between two points
+   // that succeed.
+   m_fUsable = (m_kmRadiusMin > XKMPER_WGS72) && (m_radPerMin < DBL_MAX);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// AddSite()
+void cVisibilityScreen::AddSite(const cSite &site)
+{
+   const cVector &pos = site.PositionEcef();
+
+   double e = SCREEN_ELEVATION_MIN;
+   double c = pos.m_w * cos(e) / m_kmRadiusMax;
+
+   cCone cone;
+
+   cone.m_ux     = pos.m_x / pos.m_w;
+   cone.m_uy     = pos.m_y / pos.m_w;
+   cone.m_uz     = pos.m_z / pos.m_w;
+   cone.m_radMax = acos(min(1.0, c)) - e;
+
+   m_Cones.push_back(cone);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// IsConsistent()
+// The bounds hold only while the propagated orbit stays close to the one
+// its elements describe. Drag terms of a stale element set can carry SGP4
+// far from it, so each propagated point is checked: a radius outside the
+// bounds, or an angular rate above them, ends the screening.
+bool cVisibilityScreen::IsConsistent(const cEci &eci) const
+{
+   const cVector &r = eci.Position();
+   const cVector &v = eci.Velocity();
+
+   double r2 = sqr(r.m_x) + sqr(r.m_y) + sqr(r.m_z);
+
+   if (!(r2 >= sqr(m_kmRadiusMin)) || !(r2 <= sqr(m_kmRadiusMax)))
+   {
+      return false;
+   }
+
+   double hx = r.m_y * v.m_z - r.m_z * v.m_y;
+   double hy = r.m_z * v.m_x - r.m_x * v.m_z;
+   double hz = r.m_x * v.m_y - r.m_y * v.m_x;
+
+   double radPerMin = sqrt(sqr(hx) + sqr(hy) + sqr(hz)) / r2 * 60.0;
+
+   return radPerMin <= m_radPerMinInertial;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// MinutesToVisible()
+double cVisibilityScreen::MinutesToVisible(const cEcef &ecef,
+                                           double *pminInside /* = NULL */) const
+{
+   const cVector &pos = ecef.Position();
+
+   double r = sqrt(sqr(pos.m_x) + sqr(pos.m_y) + sqr(pos.m_z));
+
+   double radOutside = PI;    // least angle outside any cone
+   double radInside  = -1.0;  // greatest angle inside one
+
+   for (size_t i = 0; i < m_Cones.size(); i++)
+   {
+      const cCone &cone = m_Cones[i];
+
+      double cosPsi = (cone.m_ux * pos.m_x +
+                       cone.m_uy * pos.m_y +
+                       cone.m_uz * pos.m_z) / r;
+      double psi    = acos(max(-1.0, min(1.0, cosPsi)));
+      double d      = psi - cone.m_radMax;
+
+      if (!(d > 0.0))
+      {
+         // Inside (or not a number): possibly visible
+         radInside = max(radInside, (d <= 0.0) ? -d : 0.0);
+      }
+      else
+      {
+         radOutside = min(radOutside, d);
+      }
+   }
+
+   if (radInside >= 0.0)
+   {
+      if (pminInside != NULL)
+      {
+         *pminInside = radInside / m_radPerMin;
+      }
+
+      return 0.0;
+   }
+
+   return radOutside / m_radPerMin;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// AppendRange()
+static void AppendRange(vector<pair<size_t, size_t> > &ranges, size_t first, size_t last)
+{
+   if (!ranges.empty() && (ranges.back().second == first))
+   {
+      ranges.back().second = last;
+   }
+   else
+   {
+      ranges.push_back(make_pair(first, last));
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// CandidateRanges()
+// Once a point fails to propagate or is inconsistent with the bounds,
+// the rest of the grid, from the point after the last one classified, is
+// left to the caller, who then meets any error where it first occurs.
+vector<pair<size_t, size_t> >
+cVisibilityScreen::CandidateRanges(double mpeFirst, double minStep, size_t count)
+{
+   vector<pair<size_t, size_t> > ranges;
+
+   size_t i     = 0;
+   size_t iNext = 0;    // the point after the last one classified
+
+   while (m_fUsable && (i < count))
+   {
+      double mpe = mpeFirst + i * minStep;
+      double minToVisible;
+      double minInside = 0.0;
+
+      try
+      {
+         m_Evaluations++;
+
+         cEciTime eci = m_Orbit.PositionEci(mpe, m_Context);
+
+         if (!IsConsistent(eci))
+         {
+            break;
+         }
+
+         cJulian date = m_Orbit.Epoch();
+
+         date.AddMin(mpe);
+
+         minToVisible = MinutesToVisible(cEcef(eci, cGmstRotation(date)), &minInside);
+      }
+      catch (cPropagationException &)
+      {
+         break;
+      }
+
+      if (minToVisible > 0.0)
+      {
+         // Next point that may be visible
+         double skip = ceil(minToVisible / minStep);
+
+         iNext = i + 1;
+         i    += (size_t)max(1.0, min(skip, (double)(count - i)));
+      }
+      else
+      {
+         // This point and those certainly still inside a cone
+         size_t last = i + 1 + (size_t)min(floor(minInside / minStep), (double)(count - i - 1));
+
+         AppendRange(ranges, i, last);
+
+         i     = last;
+         iNext = last;
+      }
+   }
+
+   if (i < count)
+   {
+      AppendRange(ranges, iNext, count);
+   }
+
+   return ranges;
+}
+}
+}
@@ -0,0 +1,88 @@
+//
+// cVisibilityScreen.h
+//
+// This class finds the stretches of a time grid in which a satellite
+// cannot possibly be visible from any of a set of sites, so that they can
+// be skipped without propagating them.
+//
+// A satellite at distance r from the earth's center is at or above
+// elevation e from a site at distance R when the angle psi, at the
+// earth's center, between the two satisfies
+//
+//    psi <= acos(R * cos(e) / r) - e
+//
+// (the site's "horizon cone"). The cone is sized for the apogee radius
+// and an elevation a little below the horizon (see cVisibilityScreen.cpp
+// for the margins), and psi can change no faster than the satellite's
+// angular rate at perigee plus the earth's rotation rate. From one
+// propagated point, then, the satellite cannot enter a cone for
+// (psi - psiMax) / rate, and cannot leave it for (psiMax - psi) / rate;
+// neither stretch needs to be propagated to be classified.
+//
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "cNoradBase.h"
+
+namespace Zeptomoby
+{
+namespace OrbitTools
+{
+
+class cOrbit;
+class cSite;
+class cEci;
+class cEcef;
+
+//////////////////////////////////////////////////////////////////////////////
+class cVisibilityScreen
+{
+public:
+   cVisibilityScreen(const cOrbit &orbit);
+
+   void AddSite(const cSite &site);
+
+   // Minutes from the time of "ecef" (the satellite's Earth-fixed position)
+   // before which the satellite cannot be visible from any site; 0 if it
+   // is inside a horizon cone. In that case *pminInside, if given,
+   // receives the minutes for which it certainly stays inside one.
+   double MinutesToVisible(const cEcef &ecef, double *pminInside = NULL) const;
+
+   // Ranges [first, last) of the grid mpe(i) = mpeFirst + i * minStep,
+   // i < count, that hold every point at which the satellite may be
+   // visible, in order. A point that cannot be propagated, or that strays
+   // outside the bounds, ends the scan: the rest of the grid is included,
+   // so that the caller meets any error. Orbits whose perigee may reach
+   // the surface are not screened at all.
+   std::vector<std::pair<size_t, size_t> >
+      CandidateRanges(double mpeFirst, double minStep, size_t count);
+
+   // Propagations made by CandidateRanges() so far
+   size_t EvaluationCount() const { return m_Evaluations; }
+
+protected:
+   struct cCone
+   {
+      double m_ux;         // unit vector to the site, Earth-fixed
+      double m_uy;
+      double m_uz;
+      double m_radMax;     // cone half-angle, radians
+   };
+
+   bool IsConsistent(const cEci &eci) const;
+
+   const cOrbit         &m_Orbit;
+   cPropagationContext   m_Context;
+   std::vector<cCone>    m_Cones;
+
+   double m_kmRadiusMin;         // perigee radius with margin
+   double m_kmRadiusMax;         // apogee radius with margin
+   double m_radPerMinInertial;   // bound on the inertial angular rate
+   double m_radPerMin;           // bound on the rate of change of psi
+   bool   m_fUsable;             // false: nothing is skipped
+   size_t m_Evaluations;
+};
+}
+}
@@ -13,5 +13,12 @@ using namespace std;
 
 #include "cOrbit.h"
 #include "cSatellite.h"
+#include "cSgp4Table.h"
+#include "cDenseEphemeris.h"
+#include "cPassPredictor.h"
+#include "cOrbitSnapshot.h"
+#include "cOrbitCatalog.h"
+#include "cLookAngleEngine.h"
+#include "cVisibilityScreen.h"
 
 using namespace Zeptomoby::OrbitTools;
\ No newline at end of file
@@ -0,0 +1,75 @@
+//
+// sampleClock.cpp
+//
+#include "stdafx.h"
+
+#include <math.h>
+
+#include "sampleClock.h"
+
+const int64_t SampleClock::MSECS_PER_MINUTE;
+const int64_t SampleClock::MSECS_PER_DAY;
+
+//////////////////////////////////////////////////////////////////////////////
+SampleClock::SampleClock(const QDateTime& reference, int64_t firstTick, uint32_t stepMs)
+    : m_FirstTick(firstTick), m_StepMs(stepMs),
+      m_ReferenceMsecOfDay(reference.time().msecsSinceStartOfDay())
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+SampleClock::SampleClock(uint32_t referenceMsecOfDay, int64_t firstTick, uint32_t stepMs)
+    : m_FirstTick(firstTick), m_StepMs(stepMs),
+      m_ReferenceMsecOfDay(referenceMsecOfDay)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////
+QDateTime convertFractionalTimestampToDateTime(uint8_t year, double fractional_date_time){
+    uint16_t dayOfyear= uint16_t(fractional_date_time);
+    double sample_Time= fractional_date_time - dayOfyear; //0.75767778;//85986634;
+    QDateTime epoch_Time;
+
+    epoch_Time.setDate(QDate(2000 + year, 1, 1));
+    epoch_Time =epoch_Time.addDays(dayOfyear - 1);
+
+
+    uint8_t hour = 0, minute = 0, sec = 0;
+    uint16_t m_sec = 0;
+
+    double hourFraction = sample_Time*24;
+    hour = uint8_t(floor(hourFraction));
+    double minuteFraction = (hourFraction - hour)*60;
+    minute = uint8_t(floor(minuteFraction));
+    double secsFraction = (minuteFraction - minute)*60;
+    sec = uint8_t(floor(secsFraction));
+    double msecsFraction = (secsFraction - sec)*1000;
+    m_sec = uint16_t(floor(msecsFraction));
+
+    epoch_Time.setTime(QTime(hour, minute, sec, m_sec));
+
+
+    return epoch_Time;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+QDateTime convertEpochStringToDateTime(QString epochTimeString){
+    uint8_t year = epochTimeString.left(2).toUInt();
+    double dateTimeString = epochTimeString.mid(2).toDouble();
+    return convertFractionalTimestampToDateTime(year, dateTimeString);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+SampleClock EpochSampleClock(const std::string& tleLine1, const QDateTime& startTime,
+                             const QDateTime& endTime, uint32_t stepMs, uint32_t& sampleCount)
+{
+    QDateTime epochTime = convertEpochStringToDateTime(QString(tleLine1.c_str()).mid(18, 14));
+    int64_t firstTick = std::max(int64_t(0), int64_t(epochTime.msecsTo(startTime)));
+    int64_t windowMSecs = int64_t(epochTime.msecsTo(endTime)) - firstTick;
+
+    sampleCount = 0;
+    if(windowMSecs > 0 && stepMs > 0){
+        sampleCount = uint32_t((windowMSecs + stepMs - 1) / stepMs);
+    }
+    return SampleClock(epochTime, firstTick, stepMs);
+}
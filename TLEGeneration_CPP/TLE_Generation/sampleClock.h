@@ -0,0 +1,74 @@
+//
+// sampleClock.h
+//
+// Sample timestamps as integer milliseconds ("ticks") past a reference
+// time, normally the TLE epoch. The reference's wall-clock time of day is
+// taken from QDateTime once, at construction; after that, the minutes
+// past the reference that the propagator takes and the time-of-day fields
+// of the output rows are plain integer arithmetic on ticks, so sample
+// loops make no Qt date/time calls.
+//
+// Times of day advance uniformly from the reference: a daylight saving
+// change inside the run is not applied, as it is not to the minutes past
+// epoch either.
+//
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include <QDateTime>
+#include <QString>
+
+class SampleClock {
+public:
+    static const int64_t MSECS_PER_MINUTE = 60000;
+    static const int64_t MSECS_PER_DAY = 86400000;
+
+    // Sample ix is at "firstTick + ix*stepMs" ticks past "reference".
+    SampleClock(const QDateTime& reference, int64_t firstTick, uint32_t stepMs);
+    // As above, with the reference's time of day given directly.
+    SampleClock(uint32_t referenceMsecOfDay, int64_t firstTick, uint32_t stepMs);
+
+    int64_t Tick(uint64_t ix) const { return m_FirstTick + int64_t(ix)*m_StepMs; }
+
+    // Minutes past the reference: whole minutes plus the remaining
+    // milliseconds, so that long runs keep millisecond resolution.
+    static double MinutesPast(int64_t tick)
+    {
+        int64_t minutes = tick / MSECS_PER_MINUTE;
+        int64_t msecs = tick % MSECS_PER_MINUTE;
+        return double(minutes) + (double(msecs)/1000.0)/60.0;
+    }
+
+    double MinutesAt(uint64_t ix) const { return MinutesPast(Tick(ix)); }
+
+    // Milliseconds since (wall-clock) midnight.
+    uint32_t MsecOfDay(int64_t tick) const
+    {
+        int64_t msecs = (m_ReferenceMsecOfDay + tick) % MSECS_PER_DAY;
+        return uint32_t(msecs < 0 ? msecs + MSECS_PER_DAY : msecs);
+    }
+
+    uint32_t MsecOfDayAt(uint64_t ix) const { return MsecOfDay(Tick(ix)); }
+
+    uint32_t ReferenceMsecOfDay() const { return uint32_t(m_ReferenceMsecOfDay); }
+    uint32_t StepMs() const { return uint32_t(m_StepMs); }
+
+private:
+    int64_t m_FirstTick;
+    int64_t m_StepMs;
+    int64_t m_ReferenceMsecOfDay;
+};
+
+// The epoch of a TLE ("YYDDD.DDDDDDDD", columns 19-32 of line 1) as a
+// date and time, truncated to the millisecond.
+QDateTime convertFractionalTimestampToDateTime(uint8_t year, double fractional_date_time);
+QDateTime convertEpochStringToDateTime(QString epochTimeString);
+
+// The clock of a run from startTime to endTime of the TLE with line 1
+// "tleLine1": ticks count from the TLE's epoch (as above), and a start
+// before the epoch is moved up to it. Sets sampleCount to the number of
+// samples before endTime.
+SampleClock EpochSampleClock(const std::string& tleLine1, const QDateTime& startTime,
+                             const QDateTime& endTime, uint32_t stepMs, uint32_t& sampleCount);
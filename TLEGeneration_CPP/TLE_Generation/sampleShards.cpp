@@ -0,0 +1,288 @@
+//
+// sampleShards.cpp
+//
+#include "stdafx.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "lookAngleRowWriter.h"
+#include "sampleShards.h"
+
+//////////////////////////////////////////////////////////////////////////////
+static int64_t MicrosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Samples [first, last) of one range. The GMST grid at "first" is the
+// rotation stepped from point "gridFirst", where a grid walking all the
+// samples recomputes it exactly.
+struct SampleChunk {
+    uint32_t first;
+    uint32_t last;
+    uint32_t gridFirst;
+};
+
+struct TableRow {
+    int64_t tick;
+    double azDeg;
+    double elDeg;
+    double rangeKm;
+    double rateKmSec;
+};
+
+struct ChunkResult {
+    std::vector<char> text;
+    size_t textUsed;
+    std::vector<TableRow> table;
+    uint64_t rows;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Widens the ranges to whole batch groups (see cNoradBase::BATCH_GROUP),
+// merging those that then overlap, and cuts them into chunks.
+static std::vector<SampleChunk> SplitRanges(const std::vector<std::pair<uint32_t, uint32_t> >& ranges,
+                                            uint32_t sampleCount)
+{
+    const uint32_t group = uint32_t(cNoradBase::BATCH_GROUP);
+    std::vector<std::pair<uint32_t, uint32_t> > aligned;
+
+    for(size_t rx = 0; rx < ranges.size(); ++rx){
+        uint32_t first = ranges[rx].first - ranges[rx].first % group;
+        uint32_t last = std::min(sampleCount, ranges[rx].second + (group - ranges[rx].second % group) % group);
+
+        if(!aligned.empty() && first <= aligned.back().second){
+            aligned.back().second = std::max(aligned.back().second, last);
+        }else if(first < last){
+            aligned.push_back(std::make_pair(first, last));
+        }
+    }
+
+    std::vector<SampleChunk> chunks;
+    for(size_t rx = 0; rx < aligned.size(); ++rx){
+        for(uint32_t first = aligned[rx].first; first < aligned[rx].second; first += CHUNK_SAMPLES){
+            SampleChunk chunk;
+            chunk.first = first;
+            chunk.last = std::min(aligned[rx].second, first + CHUNK_SAMPLES);
+            chunk.gridFirst = first - first % cGmstGrid::DEFAULT_RESYNC;
+            chunks.push_back(chunk);
+        }
+    }
+    return chunks;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// The per-thread state: propagation context, GMST grid and batch arrays.
+class ShardWorker {
+public:
+    explicit ShardWorker(const SampleShardJob& job)
+        : m_Job(job),
+          m_Grid(job.pSatellite->Orbit().Epoch(), job.pClock->MinutesAt(0),
+                 job.pClock->StepMs() / 60000.0),
+          m_Mpe(CHUNK_SAMPLES), m_X(CHUNK_SAMPLES), m_Y(CHUNK_SAMPLES), m_Z(CHUNK_SAMPLES),
+          m_Vx(CHUNK_SAMPLES), m_Vy(CHUNK_SAMPLES), m_Vz(CHUNK_SAMPLES),
+          m_Next(0), m_BusyUs(0)
+    {
+        cEciArrays eci = { m_X.data(),  m_Y.data(),  m_Z.data(),
+                           m_Vx.data(), m_Vy.data(), m_Vz.data() };
+        m_Eci = eci;
+    }
+
+    void Compute(const SampleChunk& chunk, ChunkResult& result);
+
+    int64_t BusyUs() const { return m_BusyUs; }
+
+private:
+    const SampleShardJob& m_Job;
+    cPropagationContext m_Context;
+    cGmstGrid m_Grid;
+    std::vector<double> m_Mpe, m_X, m_Y, m_Z, m_Vx, m_Vy, m_Vz;
+    cEciArrays m_Eci;
+    uint32_t m_Next;      // sample following the last one computed
+    int64_t m_BusyUs;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+void ShardWorker::Compute(const SampleChunk& chunk, ChunkResult& result)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const SampleClock& clock = *m_Job.pClock;
+    uint32_t count = chunk.last - chunk.first;
+
+    // Not following on from this worker's last chunk: the SDP4 integrator
+    // restarts from its checkpoints, and the GMST grid catches up.
+    if(chunk.first != m_Next){
+        m_Context = cPropagationContext();
+        for(uint32_t ix = chunk.gridFirst; ix < chunk.first; ++ix){
+            m_Grid.At(ix);
+        }
+    }
+    m_Next = chunk.last;
+
+    for(uint32_t jx = 0; jx < count; ++jx){
+        m_Mpe[jx] = clock.MinutesAt(chunk.first + jx);
+    }
+
+    if(m_Job.pDenseEphemeris){
+        m_Job.pDenseEphemeris->PositionEciBatch(m_Mpe.data(), count, m_Eci);
+    }else{
+        m_Job.pSatellite->PositionEciBatch(m_Mpe.data(), count, m_Eci, m_Context);
+    }
+
+    result.textUsed = 0;
+    result.table.clear();
+    result.rows = 0;
+
+    for(uint32_t jx = 0; jx < count; ++jx){
+        cEci eci(cVector(m_X[jx], m_Y[jx], m_Z[jx]),
+                 cVector(m_Vx[jx], m_Vy[jx], m_Vz[jx]));
+        // Samples below the horizon are rejected before any of the
+        // look-angle trigonometry is evaluated.
+        cLookAngle topoLook = m_Job.pSite->GetLookAngleLazy(cEcef(eci, m_Grid.At(chunk.first + jx)));
+
+        if(!topoLook.IsBelowHorizon() && topoLook.AzimuthDeg() >= 0 && topoLook.ElevationDeg() >= 0){
+            if(m_Job.textRows){
+                if(result.text.size() - result.textUsed < LookAngleRowWriter::MAX_ROW_LENGTH){
+                    result.text.resize(std::max(2*result.text.size(),
+                                                result.textUsed + LookAngleRowWriter::MAX_ROW_LENGTH));
+                }
+                result.textUsed += LookAngleRowWriter::FormatRow(&result.text[result.textUsed],
+                                                                 clock.MsecOfDayAt(chunk.first + jx),
+                                                                 topoLook.AzimuthDeg(),
+                                                                 topoLook.ElevationDeg(),
+                                                                 m_Job.decimalCount);
+            }
+            if(m_Job.tableRows){
+                TableRow row = { clock.Tick(chunk.first + jx), topoLook.AzimuthDeg(),
+                                 topoLook.ElevationDeg(), topoLook.RangeKm(),
+                                 topoLook.RangeRateKmSec() };
+                result.table.push_back(row);
+            }
+            result.rows++;
+        }
+    }
+
+    m_BusyUs += MicrosecondsSince(start);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+static void WriteChunk(const SampleShardJob& job, const ChunkResult& result)
+{
+    if(job.pRows && result.textUsed > 0){
+        job.pRows->WriteBytes(&result.text[0], result.textUsed);
+    }
+    if(job.pTable){
+        for(size_t rx = 0; rx < result.table.size(); ++rx){
+            const TableRow& row = result.table[rx];
+            job.pTable->Append(row.tick, row.azDeg, row.elDeg, row.rangeKm, row.rateKmSec);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+SampleShardStats RunSampleShards(const SampleShardJob& job, unsigned threads)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<SampleChunk> chunks = SplitRanges(job.ranges, job.sampleCount);
+
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // A dense ephemeris builds its nodes from the samples it has seen, so
+    // its chunks must be computed in order by one worker.
+    if(job.pDenseEphemeris){
+        threads = 1;
+    }
+    threads = unsigned(std::min(size_t(threads), std::max(size_t(1), chunks.size())));
+
+    SampleShardStats stats;
+    stats.threads = threads;
+    stats.chunks = uint32_t(chunks.size());
+    stats.rows = 0;
+    stats.busyMs = 0;
+    stats.writeWaitMs = 0;
+
+    if(threads == 1){
+        ShardWorker worker(job);
+        ChunkResult result;
+        for(size_t cx = 0; cx < chunks.size(); ++cx){
+            worker.Compute(chunks[cx], result);
+            WriteChunk(job, result);
+            stats.rows += result.rows;
+        }
+        stats.busyMs = worker.BusyUs() / 1000;
+        stats.wallMs = MicrosecondsSince(start) / 1000;
+        return stats;
+    }
+
+    // Chunk cx is computed into slot cx % window once chunk cx - window
+    // has been written.
+    size_t window = size_t(threads) * WINDOW_PER_THREAD;
+    std::vector<ChunkResult> slots(window);
+    std::vector<bool> done(window, false);
+    size_t nextChunk = 0;
+    size_t written = 0;
+    std::mutex mutex;
+    std::condition_variable slotFree;
+    std::condition_variable chunkDone;
+    std::vector<int64_t> busyUs(threads, 0);
+    int64_t waitUs = 0;
+
+    std::vector<std::thread> workers;
+    for(unsigned tx = 0; tx < threads; ++tx){
+        workers.push_back(std::thread([&, tx]{
+            ShardWorker worker(job);
+            std::unique_lock<std::mutex> lock(mutex);
+            for(;;){
+                slotFree.wait(lock, [&]{ return nextChunk >= chunks.size() ||
+                                                nextChunk < written + window; });
+                if(nextChunk >= chunks.size()){
+                    break;
+                }
+                size_t cx = nextChunk++;
+                lock.unlock();
+
+                worker.Compute(chunks[cx], slots[cx % window]);
+
+                lock.lock();
+                done[cx % window] = true;
+                chunkDone.notify_all();
+            }
+            busyUs[tx] = worker.BusyUs();
+        }));
+    }
+
+    for(size_t cx = 0; cx < chunks.size(); ++cx){
+        std::unique_lock<std::mutex> lock(mutex);
+        if(!done[cx % window]){
+            std::chrono::steady_clock::time_point wait = std::chrono::steady_clock::now();
+            chunkDone.wait(lock, [&]{ return bool(done[cx % window]); });
+            waitUs += MicrosecondsSince(wait);
+        }
+        lock.unlock();
+
+        WriteChunk(job, slots[cx % window]);
+        stats.rows += slots[cx % window].rows;
+
+        lock.lock();
+        done[cx % window] = false;
+        written = cx + 1;
+        slotFree.notify_all();
+    }
+
+    int64_t totalBusyUs = 0;
+    for(size_t tx = 0; tx < workers.size(); ++tx){
+        workers[tx].join();
+        totalBusyUs += busyUs[tx];
+    }
+    stats.busyMs = totalBusyUs / 1000;
+    stats.writeWaitMs = waitUs / 1000;
+    stats.wallMs = MicrosecondsSince(start) / 1000;
+    return stats;
+}
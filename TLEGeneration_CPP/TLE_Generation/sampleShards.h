@@ -0,0 +1,68 @@
+//
+// sampleShards.h
+//
+// Generates the look-angle rows of one satellite and one site over the
+// sample ranges of a run, split into chunks of CHUNK_SAMPLES samples that
+// are computed on several threads. Each worker thread has its own
+// propagation context, GMST grid and batch arrays, and formats its
+// chunks' rows itself; the calling thread writes the chunks out in sample
+// order, so the output does not depend on the thread count.
+//
+// The ranges are widened to start at a multiple of cNoradBase::BATCH_GROUP
+// and end at one or at the last sample, and chunks are cut at multiples
+// of CHUNK_SAMPLES from the start of each range, so every sample is
+// propagated in the same SIMD group whatever the ranges. A worker starting
+// a chunk steps its GMST grid from the last multiple of
+// cGmstGrid::DEFAULT_RESYNC at or before it. A sample's look angles thus
+// depend only on its index, and match those cLookAngleEngine computes on
+// the same grid.
+//
+// At most WINDOW_PER_THREAD chunks per thread are computed ahead of the
+// one being written, which bounds the memory held by finished chunks.
+//
+#pragma once
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "coreLib.h"
+#include "orbitLib.h"
+
+#include "sampleClock.h"
+
+class LookAngleRowWriter;
+
+// Samples per chunk; a multiple of cNoradBase::BATCH_GROUP.
+const uint32_t CHUNK_SAMPLES = 1024;
+
+// Chunks computed ahead of the one being written, per thread.
+const unsigned WINDOW_PER_THREAD = 4;
+
+struct SampleShardJob {
+    const cSatellite* pSatellite;
+    const cSite* pSite;
+    const SampleClock* pClock;
+    uint32_t sampleCount;
+    std::vector<std::pair<uint32_t, uint32_t> > ranges;   // [first, last) sample indices, up to sampleCount
+    uint8_t decimalCount;
+    bool textRows;                      // format text rows
+    bool tableRows;                     // collect binary table rows
+    LookAngleRowWriter* pRows;          // text destination; NULL = discard
+    cLookAngleTableWriter* pTable;      // table destination; NULL = discard
+    cDenseEphemeris* pDenseEphemeris;   // interpolate instead of propagating; one thread only
+};
+
+struct SampleShardStats {
+    unsigned threads;
+    uint32_t chunks;
+    uint64_t rows;
+    int64_t wallMs;       // first chunk started to last chunk written
+    int64_t busyMs;       // summed over the workers
+    int64_t writeWaitMs;  // calling thread waiting for the next chunk
+};
+
+// Computes and writes the job's rows on "threads" threads (0 = one per
+// hardware thread). With one thread, or a dense ephemeris, everything
+// runs on the calling thread.
+SampleShardStats RunSampleShards(const SampleShardJob& job, unsigned threads);